@@ -0,0 +1,227 @@
+#include "deinterleave.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Inputs shorter than this many frames aren't worth handing to other threads.
+constexpr std::size_t kParallelMinFrames = std::size_t{1} << 14;
+
+// Frames converted per iteration of the vectorized loops. Parallel ranges are
+// aligned to this, so that only the last range has a scalar tail.
+constexpr std::size_t kBlockFrames = 16;
+
+#ifdef __AVX2__
+// Returns the first frame not converted.
+std::size_t Deinterleave2(const std::int16_t* in, std::size_t begin,
+                          std::size_t end, std::int16_t* const* out) {
+  // Within each 128-bit lane, gather the left samples into the low half and
+  // the right samples into the high half, then bring the halves of both lanes
+  // together.
+  const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15));
+  std::size_t f = begin;
+  for (; f + 8 <= end; f += 8) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * f));
+    v = _mm256_shuffle_epi8(v, shuffle);
+    v = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[0] + f),
+                     _mm256_castsi256_si128(v));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[1] + f),
+                     _mm256_extracti128_si256(v, 1));
+  }
+  return f;
+}
+
+std::size_t Deinterleave4(const std::int16_t* in, std::size_t begin,
+                          std::size_t end, std::int16_t* const* out) {
+  // Each 128-bit lane holds two frames. Pair up each channel's samples within
+  // the lane, then gather each channel's pairs from both lanes into one 64-bit
+  // element, i.e. 4 frames of one channel.
+  const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15));
+  const __m256i gather = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  auto load = [&](std::size_t f) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4 * f));
+    return _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, shuffle),
+                                       gather);
+  };
+  std::size_t f = begin;
+  for (; f + 8 <= end; f += 8) {
+    // Channels {0, 1, 2, 3} of frames [f, f + 4) and [f + 4, f + 8).
+    const __m256i first = load(f);
+    const __m256i second = load(f + 4);
+    // Channels {0, 2} and {1, 3} of all 8 frames.
+    const __m256i even = _mm256_unpacklo_epi64(first, second);
+    const __m256i odd = _mm256_unpackhi_epi64(first, second);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[0] + f),
+                     _mm256_castsi256_si128(even));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[1] + f),
+                     _mm256_castsi256_si128(odd));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[2] + f),
+                     _mm256_extracti128_si256(even, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[3] + f),
+                     _mm256_extracti128_si256(odd, 1));
+  }
+  return f;
+}
+
+std::size_t Deinterleave8(const std::int16_t* in, std::size_t begin,
+                          std::size_t end, std::int16_t* const* out) {
+  // Two 8x8 transposes of 16-bit elements at once: row i holds frame f + i in
+  // the low lane and frame f + 8 + i in the high lane.
+  auto load = [&](std::size_t f) {
+    return _mm256_loadu2_m128i(
+        reinterpret_cast<const __m128i*>(in + 8 * (f + 8)),
+        reinterpret_cast<const __m128i*>(in + 8 * f));
+  };
+  auto store = [&](std::size_t c, std::size_t f, __m256i v) {
+    _mm256_storeu2_m128i(reinterpret_cast<__m128i*>(out[c] + f + 8),
+                         reinterpret_cast<__m128i*>(out[c] + f), v);
+  };
+  std::size_t f = begin;
+  for (; f + 16 <= end; f += 16) {
+    const __m256i r0 = load(f);
+    const __m256i r1 = load(f + 1);
+    const __m256i r2 = load(f + 2);
+    const __m256i r3 = load(f + 3);
+    const __m256i r4 = load(f + 4);
+    const __m256i r5 = load(f + 5);
+    const __m256i r6 = load(f + 6);
+    const __m256i r7 = load(f + 7);
+    // Channels 0-3 and 4-7 of frame pairs.
+    const __m256i a0 = _mm256_unpacklo_epi16(r0, r1);
+    const __m256i a1 = _mm256_unpackhi_epi16(r0, r1);
+    const __m256i a2 = _mm256_unpacklo_epi16(r2, r3);
+    const __m256i a3 = _mm256_unpackhi_epi16(r2, r3);
+    const __m256i a4 = _mm256_unpacklo_epi16(r4, r5);
+    const __m256i a5 = _mm256_unpackhi_epi16(r4, r5);
+    const __m256i a6 = _mm256_unpacklo_epi16(r6, r7);
+    const __m256i a7 = _mm256_unpackhi_epi16(r6, r7);
+    // Channel pairs of frame quads.
+    const __m256i b0 = _mm256_unpacklo_epi32(a0, a2);
+    const __m256i b1 = _mm256_unpackhi_epi32(a0, a2);
+    const __m256i b2 = _mm256_unpacklo_epi32(a1, a3);
+    const __m256i b3 = _mm256_unpackhi_epi32(a1, a3);
+    const __m256i b4 = _mm256_unpacklo_epi32(a4, a6);
+    const __m256i b5 = _mm256_unpackhi_epi32(a4, a6);
+    const __m256i b6 = _mm256_unpacklo_epi32(a5, a7);
+    const __m256i b7 = _mm256_unpackhi_epi32(a5, a7);
+    store(0, f, _mm256_unpacklo_epi64(b0, b4));
+    store(1, f, _mm256_unpackhi_epi64(b0, b4));
+    store(2, f, _mm256_unpacklo_epi64(b1, b5));
+    store(3, f, _mm256_unpackhi_epi64(b1, b5));
+    store(4, f, _mm256_unpacklo_epi64(b2, b6));
+    store(5, f, _mm256_unpackhi_epi64(b2, b6));
+    store(6, f, _mm256_unpacklo_epi64(b3, b7));
+    store(7, f, _mm256_unpackhi_epi64(b3, b7));
+  }
+  return f;
+}
+#endif
+
+// Converts frames [begin, end).
+void DeinterleaveFrames(const std::int16_t* in, std::size_t channels,
+                        std::size_t begin, std::size_t end,
+                        std::int16_t* const* out) {
+  if (channels == 1) {
+    std::copy(in + begin, in + end, out[0] + begin);
+    return;
+  }
+  std::size_t f = begin;
+#ifdef __AVX2__
+  switch (channels) {
+    case 2:
+      f = Deinterleave2(in, begin, end, out);
+      break;
+    case 4:
+      f = Deinterleave4(in, begin, end, out);
+      break;
+    case 8:
+      f = Deinterleave8(in, begin, end, out);
+      break;
+  }
+#endif
+  for (std::size_t c = 0; c < channels; ++c) {
+    for (std::size_t i = f; i < end; ++i) {
+      out[c][i] = in[i * channels + c];
+    }
+  }
+}
+
+std::vector<std::int16_t*> Outputs(
+    std::span<const std::int16_t> interleaved,
+    std::span<const std::span<std::int16_t>> planar) {
+  assert(!planar.empty());
+  assert(interleaved.size() % planar.size() == 0);
+  std::vector<std::int16_t*> out;
+  out.reserve(planar.size());
+  for (const std::span<std::int16_t> channel : planar) {
+    assert(channel.size() == interleaved.size() / planar.size());
+    out.push_back(channel.data());
+  }
+  return out;
+}
+
+}  // namespace
+
+void Deinterleave(std::span<const std::int16_t> interleaved,
+                  std::span<const std::span<std::int16_t>> planar) {
+  const std::vector<std::int16_t*> out = Outputs(interleaved, planar);
+  DeinterleaveFrames(interleaved.data(), planar.size(), 0,
+                     interleaved.size() / planar.size(), out.data());
+}
+
+void Deinterleave(std::span<const std::int16_t> interleaved,
+                  std::span<const std::span<std::int16_t>> planar,
+                  WorkerPool& pool) {
+  const std::vector<std::int16_t*> out = Outputs(interleaved, planar);
+  const std::size_t channels = planar.size();
+  const std::size_t frames = interleaved.size() / channels;
+  const std::size_t ranges =
+      frames < kParallelMinFrames ? 1 : pool.concurrency();
+  const std::size_t range_frames =
+      (frames / ranges + kBlockFrames - 1) / kBlockFrames * kBlockFrames;
+  pool.ParallelFor(ranges, [&](std::size_t i) {
+    const std::size_t begin = std::min(frames, i * range_frames);
+    const std::size_t end =
+        i + 1 == ranges ? frames : std::min(frames, begin + range_frames);
+    DeinterleaveFrames(interleaved.data(), channels, begin, end, out.data());
+  });
+}
+
+AsyncGenerator<std::vector<Buffer<std::int16_t>>> Deinterleaved(
+    std::size_t channels, AsyncGenerator<Buffer<std::int16_t>> source,
+    WorkerPool* pool) {
+  if (channels == 0) {
+    throw std::invalid_argument("Channel count must be positive.");
+  }
+  while (Buffer<std::int16_t>* frame = co_await source) {
+    if (frame->size() % channels != 0) {
+      throw std::invalid_argument(
+          "Buffer of " + std::to_string(frame->size()) +
+          " samples doesn't hold whole frames of " + std::to_string(channels) +
+          " channels.");
+    }
+    std::vector<Buffer<std::int16_t>> planar;
+    std::vector<std::span<std::int16_t>> spans;
+    for (std::size_t c = 0; c < channels; ++c) {
+      planar.push_back(
+          Buffer<std::int16_t>::Uninitialized(frame->size() / channels));
+      spans.push_back(planar.back().span());
+    }
+    if (pool != nullptr) {
+      Deinterleave(frame->span(), spans, *pool);
+    } else {
+      Deinterleave(frame->span(), spans);
+    }
+    co_yield std::move(planar);
+  }
+}
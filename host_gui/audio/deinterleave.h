@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "diy/buffer.h"
+#include "diy/coro/async_generator.h"
+#include "diy/worker_pool.h"
+
+// Copies channel c of `interleaved`, which consists of frames of one sample per
+// channel, to `planar[c]`. Each planar span must hold
+// interleaved.size() / planar.size() samples. 2, 4 and 8 channels have
+// vectorized implementations.
+void Deinterleave(std::span<const std::int16_t> interleaved,
+                  std::span<const std::span<std::int16_t>> planar);
+
+// As above, but long inputs are split into ranges of frames that are converted
+// across `pool`.
+void Deinterleave(std::span<const std::int16_t> interleaved,
+                  std::span<const std::span<std::int16_t>> planar,
+                  WorkerPool& pool);
+
+// Splits each buffer of `source`, which holds samples interleaved across
+// `channels` channels, into one buffer per channel. Throws
+// std::invalid_argument if a buffer doesn't hold a whole number of frames. If
+// given, `pool` must outlive the returned generator.
+AsyncGenerator<std::vector<Buffer<std::int16_t>>> Deinterleaved(
+    std::size_t channels, AsyncGenerator<Buffer<std::int16_t>> source,
+    WorkerPool* pool = nullptr);
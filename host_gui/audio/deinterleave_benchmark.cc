@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "deinterleave.h"
+
+// Converts `frames` frames of `channels` channels, inline (threads=1) or split
+// across a pool of `threads` threads.
+static void BM_Deinterleave(benchmark::State& state) {
+  const std::size_t channels = state.range(0);
+  const std::size_t frames = state.range(1);
+  const std::size_t threads = state.range(2);
+  std::mt19937 rng{std::random_device{}()};
+  std::uniform_int_distribution<std::int16_t> distribution;
+  std::vector<std::int16_t> interleaved(channels * frames);
+  std::ranges::generate(interleaved, [&] { return distribution(rng); });
+  std::vector<std::vector<std::int16_t>> planar(
+      channels, std::vector<std::int16_t>(frames));
+  std::vector<std::span<std::int16_t>> spans(planar.begin(), planar.end());
+  std::unique_ptr<WorkerPool> pool;
+  if (threads > 1) {
+    pool = std::make_unique<WorkerPool>(threads - 1);
+  }
+
+  for (auto _ : state) {
+    if (pool) {
+      Deinterleave(interleaved, spans, *pool);
+    } else {
+      Deinterleave(interleaved, spans);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(interleaved.size() * sizeof(std::int16_t) *
+                          state.iterations());
+}
+BENCHMARK(BM_Deinterleave)
+    ->ArgNames({"channels", "frames", "threads"})
+    ->ArgsProduct({{1, 2, 3, 4, 8}, {1 << 10, 1 << 16}, {1, 4}});
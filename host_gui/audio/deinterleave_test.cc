@@ -0,0 +1,98 @@
+#include "deinterleave.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "diy/coro/task.h"
+
+using testing::ElementsAre;
+using testing::ElementsAreArray;
+using testing::Pointee;
+using testing::SizeIs;
+
+namespace {
+// Sample of channel c in frame f.
+std::int16_t Sample(std::size_t f, std::size_t c) {
+  return static_cast<std::int16_t>(100 * f + c);
+}
+
+std::vector<std::int16_t> Interleaved(std::size_t frames,
+                                      std::size_t channels) {
+  std::vector<std::int16_t> samples;
+  for (std::size_t f = 0; f < frames; ++f) {
+    for (std::size_t c = 0; c < channels; ++c) {
+      samples.push_back(Sample(f, c));
+    }
+  }
+  return samples;
+}
+
+std::vector<std::int16_t> Channel(std::size_t frames, std::size_t c) {
+  std::vector<std::int16_t> samples;
+  for (std::size_t f = 0; f < frames; ++f) {
+    samples.push_back(Sample(f, c));
+  }
+  return samples;
+}
+
+void ExpectDeinterleaves(std::size_t frames, std::size_t channels,
+                         WorkerPool* pool) {
+  const std::vector<std::int16_t> interleaved = Interleaved(frames, channels);
+  std::vector<std::vector<std::int16_t>> planar(
+      channels, std::vector<std::int16_t>(frames));
+  std::vector<std::span<std::int16_t>> spans(planar.begin(), planar.end());
+  if (pool != nullptr) {
+    Deinterleave(interleaved, spans, *pool);
+  } else {
+    Deinterleave(interleaved, spans);
+  }
+  for (std::size_t c = 0; c < channels; ++c) {
+    EXPECT_THAT(planar[c], ElementsAreArray(Channel(frames, c)))
+        << "frames=" << frames << " channels=" << channels << " c=" << c;
+  }
+}
+}  // namespace
+
+TEST(DeinterleaveTest, Mono) { ExpectDeinterleaves(5, 1, nullptr); }
+
+TEST(DeinterleaveTest, AllChannelCounts) {
+  // Includes frame counts with and without a scalar tail.
+  for (std::size_t channels = 1; channels <= 9; ++channels) {
+    for (std::size_t frames : {0, 3, 8, 16, 37}) {
+      ExpectDeinterleaves(frames, channels, nullptr);
+    }
+  }
+}
+
+TEST(DeinterleaveTest, Parallel) {
+  WorkerPool pool(3);
+  for (std::size_t channels : {2, 3, 4, 8}) {
+    // Large enough to be split across the pool, and not a multiple of the
+    // range size.
+    ExpectDeinterleaves((1 << 15) + 5, channels, &pool);
+    ExpectDeinterleaves(10, channels, &pool);
+  }
+}
+
+TEST(DeinterleavedTest, SplitsBuffers) {
+  auto source = []() -> AsyncGenerator<Buffer<std::int16_t>> {
+    co_yield AdoptAsBuffer(Interleaved(3, 2));
+  }();
+  auto planar = Deinterleaved(2, std::move(source));
+  auto* channels = Task(planar).Wait();
+  ASSERT_NE(channels, nullptr);
+  ASSERT_THAT(*channels, SizeIs(2));
+  EXPECT_THAT((*channels)[0], ElementsAre(0, 100, 200));
+  EXPECT_THAT((*channels)[1], ElementsAre(1, 101, 201));
+  EXPECT_EQ(Task(planar).Wait(), nullptr);
+}
+
+TEST(DeinterleavedTest, PartialFrameThrows) {
+  auto source = []() -> AsyncGenerator<Buffer<std::int16_t>> {
+    co_yield AdoptAsBuffer(std::vector<std::int16_t>(5));
+  }();
+  auto planar = Deinterleaved(2, std::move(source));
+  EXPECT_THROW(Task(planar).Wait(), std::invalid_argument);
+}
@@ -0,0 +1,51 @@
+// Replays one pass of the simulated recording as fast as possible, and writes
+// the onsets found in it to stdout as CSV.
+
+#include <absl/time/time.h>
+
+#include <iostream>
+#include <vector>
+
+#include "deinterleave.h"
+#include "diy/coro/task.h"
+#include "diy/worker_pool.h"
+#include "fft_plan.h"
+#include "onset_detector.h"
+#include "source.h"
+#include "spectrum.h"
+
+namespace {
+constexpr double kSampleRate = 24'000;
+constexpr absl::Duration kFramePeriod = absl::Milliseconds(10);
+
+AsyncGenerator<Buffer<std::int16_t>> OnePass() {
+  const std::size_t frame_size =
+      absl::ToInt64Seconds(kSampleRate * kFramePeriod);
+  const std::size_t frames = SimulatedSamples().size() / frame_size;
+  auto source = SimulatedSource(kFramePeriod, SimulatedSourcePacing::kInstant);
+  for (std::size_t i = 0; i < frames; ++i) {
+    co_yield std::move(*co_await source);
+  }
+}
+}  // namespace
+
+int main() {
+  const SpectrumConfig config({.sample_rate = kSampleRate,
+                               .window_size = 1024,
+                               .window_function = WindowFunction::kHann,
+                               .hop_size = 256});
+  FftPlanCache plans;
+  WorkerPool pool(0);
+  auto spectra = MultichannelSpectra(config, plans, pool,
+                                     Deinterleaved(1, OnePass()));
+  auto onsets = DetectOnsets({}, kSampleRate, std::move(spectra));
+  std::vector<OnsetEvent> events;
+  [&]() -> Task<> {
+    while (OnsetEvent* onset = co_await onsets) {
+      events.push_back(*onset);
+    }
+  }()
+               .Wait();
+  WriteOnsetsCsv(events, std::cout);
+  return 0;
+}
@@ -0,0 +1,293 @@
+#include "fft_plan.h"
+
+#include <fftw3.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+// FFTW's planner and wisdom functions share global state. Only plan execution
+// is thread-safe.
+ABSL_CONST_INIT absl::Mutex planner_mutex(absl::kConstInit);
+
+// How often the tuning thread checks whether replaced plans are still in use.
+constexpr absl::Duration kReleaseInterval = absl::Seconds(1);
+
+unsigned PlannerFlags(PlannerEffort effort) {
+  switch (effort) {
+    case PlannerEffort::kEstimate:
+      return FFTW_ESTIMATE;
+    case PlannerEffort::kMeasure:
+      return FFTW_MEASURE;
+    case PlannerEffort::kPatient:
+      return FFTW_PATIENT;
+    case PlannerEffort::kExhaustive:
+      return FFTW_EXHAUSTIVE;
+  }
+  return FFTW_ESTIMATE;
+}
+
+// Whether fftw_init_threads() has been called.
+bool threads_initialized ABSL_GUARDED_BY(planner_mutex) = false;
+
+fftw_plan CreatePlan(std::size_t n, unsigned flags, absl::Duration time_limit,
+                     int threads) {
+  // The planner needs arrays with the alignment of the arrays the plan will be
+  // executed on. Measuring planners also overwrite them.
+  auto scratch = FftBuffer(n);
+  auto* data = reinterpret_cast<fftw_complex*>(scratch.data());
+  absl::MutexLock lock(&planner_mutex);
+  if (threads > 1 && !threads_initialized) {
+    if (fftw_init_threads() == 0) {
+      throw std::runtime_error("Failed to initialize FFTW threads.");
+    }
+    threads_initialized = true;
+  }
+  if (threads_initialized) {
+    fftw_plan_with_nthreads(threads);
+  }
+  fftw_set_timelimit(time_limit == absl::InfiniteDuration()
+                         ? FFTW_NO_TIMELIMIT
+                         : absl::ToDoubleSeconds(time_limit));
+  return fftw_plan_dft_1d(n, data, data, FFTW_FORWARD, flags);
+}
+}  // namespace
+
+Buffer<std::complex<double>> FftBuffer(std::size_t n) {
+  auto* raw = reinterpret_cast<std::complex<double>*>(fftw_alloc_complex(n));
+  return Buffer<std::complex<double>>({raw, n}, [raw] { fftw_free(raw); });
+}
+
+FftPlan::FftPlan(std::size_t n, PlannerEffort effort,
+                 absl::Duration time_limit, int threads)
+    : FftPlan(n, effort, threads,
+              CreatePlan(n, PlannerFlags(effort), time_limit, threads)) {}
+
+FftPlan::FftPlan(std::size_t n, PlannerEffort effort, int threads,
+                 fftw_plan_s* plan)
+    : n_(n), effort_(effort), threads_(threads), plan_(plan) {}
+
+std::unique_ptr<FftPlan> FftPlan::FromWisdom(std::size_t n,
+                                             PlannerEffort effort,
+                                             int threads) {
+  fftw_plan plan = CreatePlan(n, PlannerFlags(effort) | FFTW_WISDOM_ONLY,
+                              absl::InfiniteDuration(), threads);
+  if (plan == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<FftPlan>(new FftPlan(n, effort, threads, plan));
+}
+
+FftPlan::~FftPlan() {
+  absl::MutexLock lock(&planner_mutex);
+  fftw_destroy_plan(plan_);
+}
+
+void FftPlan::Execute(std::span<std::complex<double>> buffer) const {
+  assert(buffer.size() == n_);
+  auto* data = reinterpret_cast<fftw_complex*>(buffer.data());
+  fftw_execute_dft(plan_, data, data);
+}
+
+bool LoadFftWisdom(const std::filesystem::path& path) {
+  absl::MutexLock lock(&planner_mutex);
+  return fftw_import_wisdom_from_filename(path.c_str()) != 0;
+}
+
+bool SaveFftWisdom(const std::filesystem::path& path) {
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+  // Write to a temporary file first, so that a concurrently starting process
+  // never reads a partial file.
+  std::filesystem::path temp_path = path;
+  temp_path += ".tmp";
+  {
+    absl::MutexLock lock(&planner_mutex);
+    if (fftw_export_wisdom_to_filename(temp_path.c_str()) == 0) {
+      return false;
+    }
+  }
+  std::filesystem::rename(temp_path, path, error);
+  return !error;
+}
+
+FftPlanCache::FftPlanCache(const Options& options) : options_(options) {
+  if (!options_.wisdom_path.empty()) {
+    LoadFftWisdom(options_.wisdom_path);
+  }
+  if (options_.tuning_effort != PlannerEffort::kEstimate) {
+    tuning_thread_ = std::jthread(&FftPlanCache::TuningLoop, this);
+  }
+}
+
+FftPlanCache::~FftPlanCache() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  if (tuning_thread_.joinable()) {
+    tuning_thread_.join();
+  }
+}
+
+auto FftPlanCache::Plan(std::size_t n) const -> Entry {
+  Entry entry;
+  if (options_.tuning_effort != PlannerEffort::kEstimate) {
+    entry.plan = FftPlan::FromWisdom(n, options_.tuning_effort, Threads(n));
+    entry.tuned = entry.plan != nullptr;
+  }
+  if (entry.plan == nullptr) {
+    entry.plan = std::make_shared<FftPlan>(
+        n, PlannerEffort::kEstimate, absl::InfiniteDuration(), Threads(n));
+  }
+  return entry;
+}
+
+void FftPlanCache::Insert(std::vector<std::pair<std::size_t, Entry>> entries) {
+  absl::MutexLock lock(&mutex_);
+  for (auto& [n, entry] : entries) {
+    // Another thread may have planned the same size in the meantime.
+    const auto [it, inserted] = plans_.emplace(n, std::move(entry));
+    if (inserted && !it->second.tuned && tuning_thread_.joinable()) {
+      tuning_queue_.push_back(n);
+    }
+  }
+}
+
+std::shared_ptr<const FftPlan> FftPlanCache::Get(std::size_t n) {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (auto it = plans_.find(n); it != plans_.end()) {
+      return it->second.plan;
+    }
+  }
+  // Plan without holding the lock, so that other sizes remain available.
+  std::vector<std::pair<std::size_t, Entry>> entries;
+  Entry entry = Plan(n);
+  // Returned even if another thread cached the same size in the meantime, as
+  // both compute the same transform.
+  std::shared_ptr<const FftPlan> plan = entry.plan;
+  entries.emplace_back(n, std::move(entry));
+  Insert(std::move(entries));
+  return plan;
+}
+
+void FftPlanCache::Prepare(std::span<const std::size_t> sizes) {
+  std::vector<std::pair<std::size_t, Entry>> entries;
+  for (const std::size_t n : sizes) {
+    bool planned;
+    {
+      absl::MutexLock lock(&mutex_);
+      planned = plans_.contains(n);
+    }
+    if (!planned) {
+      entries.emplace_back(n, Plan(n));
+    }
+  }
+  Insert(std::move(entries));
+}
+
+void FftPlanCache::WaitForTuning() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &FftPlanCache::TuningIdle));
+}
+
+std::size_t FftPlanCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return plans_.size();
+}
+
+std::size_t FftPlanCache::retired() const {
+  absl::MutexLock lock(&mutex_);
+  return retired_.size();
+}
+
+std::size_t FftPlanCache::tuned() const {
+  absl::MutexLock lock(&mutex_);
+  std::size_t count = 0;
+  for (const auto& [n, entry] : plans_) {
+    count += entry.tuned;
+  }
+  return count;
+}
+
+int FftPlanCache::Threads(std::size_t n) const {
+  return n >= options_.threaded_min_size ? options_.threads : 1;
+}
+
+void FftPlanCache::ReleaseRetired() {
+  std::vector<std::shared_ptr<const FftPlan>> unused;
+  {
+    absl::MutexLock lock(&mutex_);
+    // Only `retired_` can hand out new references, so a plan it holds the only
+    // reference to stays unused.
+    const auto used = std::ranges::partition(
+        retired_, [](const auto& plan) { return plan.use_count() > 1; });
+    unused.assign(std::make_move_iterator(used.begin()),
+                  std::make_move_iterator(used.end()));
+    retired_.erase(used.begin(), used.end());
+  }
+  // Destroyed here, outside the lock.
+}
+
+bool FftPlanCache::TuningReady() const {
+  return stopping_ || !tuning_queue_.empty();
+}
+
+bool FftPlanCache::TuningIdle() const {
+  return stopping_ || (tuning_queue_.empty() && !tuning_);
+}
+
+void FftPlanCache::TuningLoop() {
+  while (true) {
+    std::size_t n;
+    bool ready;
+    {
+      absl::MutexLock lock(&mutex_);
+      const absl::Condition condition(this, &FftPlanCache::TuningReady);
+      // Plans still held when they were replaced are released once their
+      // users have moved on to the tuned ones.
+      if (retired_.empty()) {
+        mutex_.Await(condition);
+        ready = true;
+      } else {
+        ready = mutex_.AwaitWithTimeout(condition, kReleaseInterval);
+      }
+      if (stopping_) {
+        return;
+      }
+      if (ready) {
+        n = tuning_queue_.front();
+        tuning_queue_.pop_front();
+        tuning_ = true;
+      }
+    }
+    if (!ready) {
+      ReleaseRetired();
+      continue;
+    }
+    std::shared_ptr<const FftPlan> plan = std::make_shared<FftPlan>(
+        n, options_.tuning_effort, options_.tuning_time_limit, Threads(n));
+    bool save = false;
+    {
+      absl::MutexLock lock(&mutex_);
+      Entry& entry = plans_[n];
+      std::swap(entry.plan, plan);
+      entry.tuned = true;
+      // Destroying the estimated plan takes the planner lock, which Get()
+      // callers mustn't wait for, so it's left for this thread to destroy.
+      retired_.push_back(std::move(plan));
+      // Save once per batch rather than after every plan.
+      save = tuning_queue_.empty() && !options_.wisdom_path.empty();
+    }
+    ReleaseRetired();
+    if (save) {
+      SaveFftWisdom(options_.wisdom_path);
+    }
+    absl::MutexLock lock(&mutex_);
+    tuning_ = false;
+  }
+}
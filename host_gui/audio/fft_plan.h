@@ -0,0 +1,180 @@
+#pragma once
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
+#include <complex>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "diy/buffer.h"
+
+// Opaque FFTW plan type, so that users of this header don't need FFTW's
+// include directories.
+struct fftw_plan_s;
+
+// How hard FFTW searches for a fast algorithm. Efforts above kEstimate time
+// candidate algorithms, which takes from milliseconds to minutes depending on
+// the size.
+enum class PlannerEffort {
+  kEstimate,
+  kMeasure,
+  kPatient,
+  kExhaustive,
+};
+
+// Buffer with the alignment that FFTW's SIMD kernels expect. FftPlan inputs
+// must be allocated this way.
+Buffer<std::complex<double>> FftBuffer(std::size_t n);
+
+// FFTW plan for an in-place forward complex-to-complex FFT of size `n`.
+class FftPlan {
+ public:
+  // Plans with the given effort, spending at most `time_limit` on it. Planning
+  // is serialized process-wide, as FFTW's planner isn't thread-safe.
+  //
+  // Plans with `threads` > 1 split each transform across that many threads,
+  // which only pays off for large sizes (see fft_plan_benchmark).
+  explicit FftPlan(std::size_t n,
+                   PlannerEffort effort = PlannerEffort::kEstimate,
+                   absl::Duration time_limit = absl::InfiniteDuration(),
+                   int threads = 1);
+
+  // A plan with at least the given effort, if FFTW wisdom (see LoadFftWisdom())
+  // already has one for this size; nullptr otherwise. Never times anything.
+  static std::unique_ptr<FftPlan> FromWisdom(std::size_t n,
+                                             PlannerEffort effort,
+                                             int threads = 1);
+
+  ~FftPlan();
+
+  FftPlan(const FftPlan&) = delete;
+  FftPlan& operator=(const FftPlan&) = delete;
+
+  std::size_t size() const noexcept { return n_; }
+  PlannerEffort effort() const noexcept { return effort_; }
+  int threads() const noexcept { return threads_; }
+
+  // Transforms `buffer` in-place. `buffer` must have size() elements and be
+  // allocated with FftBuffer(). May be called concurrently.
+  void Execute(std::span<std::complex<double>> buffer) const;
+
+ private:
+  FftPlan(std::size_t n, PlannerEffort effort, int threads, fftw_plan_s* plan);
+
+  const std::size_t n_;
+  const PlannerEffort effort_;
+  const int threads_;
+  fftw_plan_s* const plan_;
+};
+
+// Merges FFTW wisdom, i.e. the outcome of earlier planning, from `path` into
+// the process-wide wisdom, so that the same plans don't have to be timed
+// again. Returns false if the file is missing or malformed.
+bool LoadFftWisdom(const std::filesystem::path& path);
+
+// Writes the process-wide wisdom to `path`, creating parent directories as
+// needed. Returns false on failure.
+bool SaveFftWisdom(const std::filesystem::path& path);
+
+// FftPlans keyed by size. Plans are created on first use and kept for the
+// lifetime of the cache, so that switching back and forth between sizes never
+// re-plans.
+//
+// Get() never times plans itself. If `tuning_effort` is above kEstimate, sizes
+// that the wisdom file has no tuned plan for are served by an estimated plan
+// until a background thread has tuned one, which then replaces it. Tuned plans
+// are saved to the wisdom file, so later runs start with them.
+//
+// FFTW's planner is process-wide, so planning a size that wasn't prepared
+// waits for any tuning in progress. Real-time callers should Prepare() every
+// size they may use up front. Replaced plans are destroyed by the tuning
+// thread, which also takes the planner, once Get() callers have released them.
+//
+// All methods are thread-safe.
+class FftPlanCache {
+ public:
+  struct Options {
+    // FFTW wisdom file, loaded at construction and updated after tuning. Empty
+    // disables persistence.
+    std::filesystem::path wisdom_path;
+    PlannerEffort tuning_effort = PlannerEffort::kEstimate;
+    // Upper bound on the time spent tuning each plan, which is also how long
+    // planning an unprepared size may wait for the planner.
+    absl::Duration tuning_time_limit = absl::Seconds(1);
+    // Plans of at least `threaded_min_size` use `threads` threads. Smaller
+    // plans are single-threaded.
+    int threads = 1;
+    std::size_t threaded_min_size = std::size_t{1} << 16;
+  };
+
+  FftPlanCache() : FftPlanCache(Options()) {}
+  explicit FftPlanCache(const Options& options);
+  ~FftPlanCache();
+
+  // The best plan currently available for size `n`. The returned plan stays
+  // usable after a tuned plan replaces it.
+  std::shared_ptr<const FftPlan> Get(std::size_t n) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Plans for `sizes` ahead of their first use, e.g. all sizes that may be
+  // configured, at startup. All sizes are planned before any of them is
+  // queued for tuning, so tuning doesn't delay the rest. Tuning continues in
+  // the background.
+  void Prepare(std::span<const std::size_t> sizes) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Blocks until queued tuning has finished.
+  void WaitForTuning() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Number of sizes with a plan.
+  std::size_t size() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Number of sizes whose plan has `tuning_effort`.
+  std::size_t tuned() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Number of replaced plans that haven't been destroyed yet.
+  std::size_t retired() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Entry {
+    std::shared_ptr<const FftPlan> plan;
+    bool tuned = false;
+  };
+
+  int Threads(std::size_t n) const;
+  // Wisdom or estimated plan for size `n`.
+  Entry Plan(std::size_t n) const;
+  // Inserts `entries` that aren't in `plans_` yet, queueing them for tuning.
+  // Holds no references afterwards, so that the tuning thread can release the
+  // plans it replaces.
+  void Insert(std::vector<std::pair<std::size_t, Entry>> entries)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Destroys retired plans that are no longer used.
+  void ReleaseRetired() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  bool TuningReady() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool TuningIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void TuningLoop() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  const Options options_;
+
+  mutable absl::Mutex mutex_;
+  std::map<std::size_t, Entry> plans_ ABSL_GUARDED_BY(mutex_);
+  std::deque<std::size_t> tuning_queue_ ABSL_GUARDED_BY(mutex_);
+  // Whether the tuning thread is working on a dequeued size.
+  bool tuning_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  // Plans replaced by tuning, kept until Get() callers have released them.
+  // Checked after each tuned plan, and every second while any remain.
+  std::vector<std::shared_ptr<const FftPlan>> retired_ ABSL_GUARDED_BY(mutex_);
+
+  // Only started if tuning is enabled.
+  std::jthread tuning_thread_;
+};
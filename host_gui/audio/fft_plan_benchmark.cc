@@ -0,0 +1,87 @@
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+
+#include "fft_plan.h"
+
+const char* EffortName(PlannerEffort effort) {
+  switch (effort) {
+    case PlannerEffort::kEstimate:
+      return "estimate";
+    case PlannerEffort::kMeasure:
+      return "measure";
+    case PlannerEffort::kPatient:
+      return "patient";
+    case PlannerEffort::kExhaustive:
+      return "exhaustive";
+  }
+  return "";
+}
+
+auto RandomSignal(std::size_t n) {
+  std::mt19937 rng{std::random_device{}()};
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  auto signal = FftBuffer(n);
+  std::ranges::generate(signal, [&] {
+    return std::complex<double>(distribution(rng), distribution(rng));
+  });
+  return signal;
+}
+
+// Execution time of a plan of size `n` and planner effort `effort`. Planning
+// happens before timing starts, and its duration is reported as a counter.
+// Later runs of the same size plan from the wisdom gathered by earlier ones, so
+// only the first run's planning time is representative.
+static void BM_Execute(benchmark::State& state) {
+  const std::size_t n = state.range(0);
+  const auto effort = static_cast<PlannerEffort>(state.range(1));
+  const absl::Time planning_start = absl::Now();
+  const FftPlan plan(n, effort);
+  state.counters["planning_ms"] =
+      absl::ToDoubleMilliseconds(absl::Now() - planning_start);
+  state.SetLabel(EffortName(effort));
+
+  const auto input = RandomSignal(n);
+  auto buffer = FftBuffer(n);
+
+  for (auto _ : state) {
+    // The plan is in-place, so each iteration starts from a fresh copy.
+    std::ranges::copy(input, buffer.begin());
+    plan.Execute(buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(n * state.iterations());
+}
+BENCHMARK(BM_Execute)
+    ->ArgNames({"n", "effort"})
+    ->ArgsProduct({{256, 1024, 2028, 2048, 4096, 8192, 16384},
+                   {static_cast<int>(PlannerEffort::kEstimate),
+                    static_cast<int>(PlannerEffort::kMeasure),
+                    static_cast<int>(PlannerEffort::kPatient)}});
+
+// Execution time of a measured plan of size `n` split across `threads`
+// threads. Multithreading only pays off once the transform is large enough to
+// amortize the synchronization between threads.
+static void BM_ExecuteThreads(benchmark::State& state) {
+  const std::size_t n = state.range(0);
+  const int threads = state.range(1);
+  const FftPlan plan(n, PlannerEffort::kMeasure, absl::Seconds(10), threads);
+
+  const auto input = RandomSignal(n);
+  auto buffer = FftBuffer(n);
+
+  for (auto _ : state) {
+    std::ranges::copy(input, buffer.begin());
+    plan.Execute(buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(n * state.iterations());
+}
+BENCHMARK(BM_ExecuteThreads)
+    ->ArgNames({"n", "threads"})
+    ->ArgsProduct({benchmark::CreateRange(1 << 10, 1 << 20, /*multi=*/4),
+                   {1, 2, 4, 8}})
+    ->UseRealTime();
@@ -0,0 +1,142 @@
+#include "fft_plan.h"
+
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+
+using testing::Each;
+using testing::Eq;
+
+TEST(FftPlanTest, Impulse) {
+  const FftPlan plan(8);
+  EXPECT_EQ(plan.size(), 8);
+  auto buffer = FftBuffer(8);
+  std::ranges::fill(buffer, 0);
+  buffer[0] = 1;
+  plan.Execute(buffer);
+  EXPECT_THAT(buffer, Each(Eq(std::complex<double>(1, 0))));
+}
+
+TEST(FftPlanTest, Dc) {
+  const FftPlan plan(4);
+  auto buffer = FftBuffer(4);
+  std::ranges::fill(buffer, 1);
+  plan.Execute(buffer);
+  EXPECT_EQ(buffer[0], std::complex<double>(4, 0));
+  EXPECT_EQ(buffer[1], std::complex<double>(0, 0));
+  EXPECT_EQ(buffer[2], std::complex<double>(0, 0));
+  EXPECT_EQ(buffer[3], std::complex<double>(0, 0));
+}
+
+TEST(FftPlanTest, MultithreadedImpulse) {
+  const FftPlan plan(8, PlannerEffort::kEstimate, absl::InfiniteDuration(),
+                     /*threads=*/2);
+  EXPECT_EQ(plan.threads(), 2);
+  auto buffer = FftBuffer(8);
+  std::ranges::fill(buffer, 0);
+  buffer[0] = 1;
+  plan.Execute(buffer);
+  EXPECT_THAT(buffer, Each(Eq(std::complex<double>(1, 0))));
+}
+
+TEST(FftPlanCacheTest, ReusesPlans) {
+  FftPlanCache cache;
+  EXPECT_EQ(cache.size(), 0);
+  const std::shared_ptr<const FftPlan> a = cache.Get(16);
+  const std::shared_ptr<const FftPlan> b = cache.Get(32);
+  EXPECT_EQ(a->size(), 16);
+  EXPECT_EQ(b->size(), 32);
+  EXPECT_EQ(cache.size(), 2);
+
+  // Switching back doesn't create a new plan.
+  EXPECT_EQ(cache.Get(16), a);
+  EXPECT_EQ(cache.Get(32), b);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.tuned(), 0);
+}
+
+TEST(FftPlanCacheTest, ThreadsAboveThreshold) {
+  FftPlanCache cache({.threads = 4, .threaded_min_size = 64});
+  EXPECT_EQ(cache.Get(32)->threads(), 1);
+  EXPECT_EQ(cache.Get(64)->threads(), 4);
+  EXPECT_EQ(cache.Get(128)->threads(), 4);
+}
+
+TEST(FftPlanCacheTest, TunesInBackground) {
+  FftPlanCache cache({.tuning_effort = PlannerEffort::kMeasure});
+  const std::shared_ptr<const FftPlan> estimated = cache.Get(40);
+  EXPECT_EQ(estimated->effort(), PlannerEffort::kEstimate);
+
+  cache.WaitForTuning();
+  EXPECT_EQ(cache.tuned(), 1);
+  const std::shared_ptr<const FftPlan> tuned = cache.Get(40);
+  EXPECT_EQ(tuned->effort(), PlannerEffort::kMeasure);
+
+  // The replaced plan remains usable.
+  auto buffer = FftBuffer(40);
+  std::ranges::fill(buffer, 1);
+  estimated->Execute(buffer);
+  EXPECT_EQ(buffer[0], std::complex<double>(40, 0));
+}
+
+TEST(FftPlanCacheTest, TuningThreadReleasesReplacedPlans) {
+  FftPlanCache cache({.tuning_effort = PlannerEffort::kMeasure});
+  // Sizes not tuned by other tests, whose wisdom would be reused.
+  const std::size_t sizes[] = {72, 80};
+  cache.Prepare(sizes);
+  cache.WaitForTuning();
+  EXPECT_EQ(cache.tuned(), 2);
+  // Nothing else referenced the estimated plans.
+  EXPECT_EQ(cache.retired(), 0);
+}
+
+TEST(FftPlanCacheTest, HeldPlansReleasedLater) {
+  FftPlanCache cache({.tuning_effort = PlannerEffort::kMeasure});
+  std::shared_ptr<const FftPlan> estimated = cache.Get(88);
+  cache.WaitForTuning();
+  EXPECT_EQ(cache.retired(), 1);
+  estimated.reset();
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (cache.retired() > 0 && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  EXPECT_EQ(cache.retired(), 0);
+}
+
+TEST(FftPlanCacheTest, PrepareBeforeTuning) {
+  FftPlanCache cache({.tuning_effort = PlannerEffort::kMeasure});
+  const std::size_t sizes[] = {24, 96, 104};
+  cache.Prepare(sizes);
+  EXPECT_EQ(cache.size(), 3);
+  cache.WaitForTuning();
+  EXPECT_EQ(cache.tuned(), 3);
+}
+
+TEST(FftPlanCacheTest, TunedPlansFromWisdom) {
+  const std::filesystem::path path =
+      std::filesystem::path(testing::TempDir()) / "fft_plan_test" / "wisdom";
+  std::filesystem::remove(path);
+  EXPECT_FALSE(LoadFftWisdom(path));
+  {
+    FftPlanCache cache(
+        {.wisdom_path = path, .tuning_effort = PlannerEffort::kMeasure});
+    const std::size_t sizes[] = {48, 56};
+    cache.Prepare(sizes);
+    cache.WaitForTuning();
+  }
+  EXPECT_TRUE(std::filesystem::exists(path));
+  EXPECT_TRUE(LoadFftWisdom(path));
+
+  // Sizes with wisdom start with tuned plans.
+  FftPlanCache cache(
+      {.wisdom_path = path, .tuning_effort = PlannerEffort::kMeasure});
+  EXPECT_EQ(cache.Get(48)->effort(), PlannerEffort::kMeasure);
+  EXPECT_EQ(cache.Get(56)->effort(), PlannerEffort::kMeasure);
+  EXPECT_EQ(cache.tuned(), 2);
+}
@@ -0,0 +1,123 @@
+#include "gcc_phat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Cross-power bins weaker than this carry no usable phase, and are left out
+// rather than amplified by the whitening.
+constexpr double kMinCrossPower = 1e-20;
+
+void CheckOptions(std::size_t channels, std::size_t n,
+                  const GccPhatOptions& options) {
+  if (channels < 2) {
+    throw std::invalid_argument("GCC-PHAT needs at least two channels. Got: " +
+                                std::to_string(channels));
+  }
+  if (2 * options.max_lag >= n) {
+    throw std::invalid_argument(
+        "Maximum lag must be below half the window size. Got: " +
+        std::to_string(options.max_lag) + " for " + std::to_string(n));
+  }
+}
+
+struct PairTdoa {
+  double lag;
+  double peak;
+};
+
+// TDOA of `b` behind `a`, using `scratch` for the correlation.
+PairTdoa PairGccPhat(std::span<const std::complex<double>> a,
+                     std::span<const std::complex<double>> b,
+                     std::size_t max_lag, const FftPlan& plan,
+                     std::span<std::complex<double>> scratch) {
+  const std::size_t n = a.size();
+  // The correlation is the inverse FFT of the whitened cross-power spectrum
+  // G = B * conj(A). Its imaginary part vanishes for real signals, and
+  // Re(IFFT(G)) = Re(FFT(conj(G))) / n, so the forward plan suffices.
+  for (std::size_t k = 0; k < n; ++k) {
+    const std::complex<double> g = a[k] * std::conj(b[k]);
+    const double power = std::norm(g);
+    scratch[k] = power > kMinCrossPower ? g / std::sqrt(power) : 0;
+  }
+  plan.Execute(scratch);
+  auto correlation = [&](std::ptrdiff_t lag) {
+    return scratch[(lag + n) % n].real() / n;
+  };
+
+  const auto l = static_cast<std::ptrdiff_t>(max_lag);
+  std::ptrdiff_t best = -l;
+  for (std::ptrdiff_t lag = -l + 1; lag <= l; ++lag) {
+    if (correlation(lag) > correlation(best)) {
+      best = lag;
+    }
+  }
+  // Fit a parabola through the peak and its neighbours.
+  const double y0 = correlation(best - 1);
+  const double y1 = correlation(best);
+  const double y2 = correlation(best + 1);
+  const double curvature = y0 - 2 * y1 + y2;
+  const double offset =
+      curvature < 0 ? std::clamp(0.5 * (y0 - y2) / curvature, -0.5, 0.5) : 0;
+  return {.lag = best + offset, .peak = std::max(0.0, y1)};
+}
+
+}  // namespace
+
+std::pair<std::size_t, std::size_t> ChannelPair(std::size_t channels,
+                                                std::size_t p) {
+  std::size_t i = 0;
+  while (p >= channels - 1 - i) {
+    p -= channels - 1 - i;
+    ++i;
+  }
+  return {i, i + 1 + p};
+}
+
+TdoaFrame GccPhat(std::span<const Buffer<std::complex<double>>> fft,
+                  const GccPhatOptions& options, FftPlanCache& plans,
+                  WorkerPool& pool, GccPhatScratch& scratch) {
+  const std::size_t channels = fft.size();
+  const std::size_t n = channels == 0 ? 0 : fft.front().size();
+  CheckOptions(channels, n, options);
+  const std::shared_ptr<const FftPlan> plan = plans.Get(n);
+  const std::size_t pairs = ChannelPairs(channels);
+  if (scratch.size() != pairs || scratch.front().size() != n) {
+    scratch.clear();
+    for (std::size_t p = 0; p < pairs; ++p) {
+      scratch.push_back(FftBuffer(n));
+    }
+  }
+
+  TdoaFrame frame;
+  frame.lags.resize(pairs);
+  frame.peaks.resize(pairs);
+  pool.ParallelFor(pairs, [&](std::size_t p) {
+    const auto [i, j] = ChannelPair(channels, p);
+    const PairTdoa tdoa =
+        PairGccPhat(fft[i].span(), fft[j].span(), options.max_lag, *plan,
+                    scratch[p].span());
+    frame.lags[p] = tdoa.lag;
+    frame.peaks[p] = tdoa.peak;
+  });
+
+  frame.histogram.assign(2 * options.max_lag + 1, 0);
+  const auto max_lag = static_cast<double>(options.max_lag);
+  for (std::size_t p = 0; p < pairs; ++p) {
+    const double lag = std::clamp(std::round(frame.lags[p]), -max_lag, max_lag);
+    frame.histogram[static_cast<std::size_t>(lag + max_lag)] += frame.peaks[p];
+  }
+  return frame;
+}
+
+AsyncGenerator<TdoaFrame> GccPhat(GccPhatOptions options, FftPlanCache& plans,
+                                  WorkerPool& pool,
+                                  AsyncGenerator<ChannelSpectra> source) {
+  GccPhatScratch scratch;
+  while (ChannelSpectra* spectra = co_await source) {
+    co_yield GccPhat(spectra->fft, options, plans, pool, scratch);
+  }
+}
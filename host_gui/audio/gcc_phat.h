@@ -0,0 +1,66 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "diy/buffer.h"
+#include "diy/coro/async_generator.h"
+#include "diy/worker_pool.h"
+#include "fft_plan.h"
+#include "spectrum.h"
+
+struct GccPhatOptions {
+  // Largest time difference of arrival of interest, in samples, e.g. the
+  // largest microphone spacing divided by the speed of sound. Correlation lags
+  // beyond it are ignored.
+  std::size_t max_lag = 8;
+};
+
+// Time differences of arrival (TDOA) between the channels of one window.
+struct TdoaFrame {
+  // For each channel pair (see ChannelPair()), the lag in samples of the second
+  // channel behind the first, refined to sub-sample precision.
+  std::vector<double> lags;
+  // Peak correlation of each pair, from 0 to 1. Low values mean the pair shares
+  // little coherent signal, e.g. during silence.
+  std::vector<double> peaks;
+  // Sum of `peaks` binned by rounded lag, from -max_lag to max_lag.
+  std::vector<double> histogram;
+};
+
+// Number of distinct pairs of `channels` channels.
+constexpr std::size_t ChannelPairs(std::size_t channels) {
+  return channels * (channels - 1) / 2;
+}
+
+// Channels (i, j), with i < j, of pair `p` in the order (0, 1), (0, 2), ...,
+// (1, 2), ...
+std::pair<std::size_t, std::size_t> ChannelPair(std::size_t channels,
+                                                std::size_t p);
+
+// Correlation buffers of GccPhat(), one per channel pair. Kept by the caller
+// across windows so that they are only allocated when the number of pairs or
+// the window size changes.
+using GccPhatScratch = std::vector<Buffer<std::complex<double>>>;
+
+// Generalized cross-correlation with phase transform (GCC-PHAT) between every
+// pair of `fft`, the complex spectra of one window of each channel. Each pair's
+// cross-power spectrum is whitened so that only phase differences remain, which
+// makes its inverse transform peak sharply at the pair's TDOA whatever the
+// spectrum of the source. Pairs are processed across `pool`, each in its own
+// buffer of `scratch`.
+//
+// Throws std::invalid_argument if there are fewer than two channels, or if
+// `max_lag` isn't below half the window size.
+TdoaFrame GccPhat(std::span<const Buffer<std::complex<double>>> fft,
+                  const GccPhatOptions& options, FftPlanCache& plans,
+                  WorkerPool& pool, GccPhatScratch& scratch);
+
+// Applies GccPhat() to the FFTs of each item of `source`. `plans` and `pool`
+// must outlive the returned generator.
+AsyncGenerator<TdoaFrame> GccPhat(GccPhatOptions options, FftPlanCache& plans,
+                                  WorkerPool& pool,
+                                  AsyncGenerator<ChannelSpectra> source);
@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "gcc_phat.h"
+
+// GCC-PHAT between all pairs of `channels` channels of random spectra of size
+// `n`, e.g. 28 pairs for 8 channels, across `threads` threads.
+static void BM_GccPhat(benchmark::State& state) {
+  const std::size_t channels = state.range(0);
+  const std::size_t n = state.range(1);
+  const std::size_t threads = state.range(2);
+  std::mt19937 rng{std::random_device{}()};
+  std::normal_distribution<double> distribution;
+  std::vector<Buffer<std::complex<double>>> fft;
+  for (std::size_t c = 0; c < channels; ++c) {
+    Buffer<std::complex<double>> spectrum = FftBuffer(n);
+    for (std::complex<double>& x : spectrum) {
+      x = {distribution(rng), distribution(rng)};
+    }
+    fft.push_back(std::move(spectrum));
+  }
+  FftPlanCache plans;
+  plans.Get(n);
+  WorkerPool pool(threads - 1);
+  GccPhatScratch scratch;
+
+  for (auto _ : state) {
+    TdoaFrame frame = GccPhat(fft, {}, plans, pool, scratch);
+    benchmark::DoNotOptimize(frame.histogram.data());
+  }
+  state.counters["pairs"] = ChannelPairs(channels);
+  state.SetItemsProcessed(ChannelPairs(channels) * state.iterations());
+}
+BENCHMARK(BM_GccPhat)
+    ->ArgNames({"channels", "n", "threads"})
+    ->ArgsProduct({{2, 4, 8}, {1024, 2048, 4096}, {1, 2, 4}})
+    ->UseRealTime();
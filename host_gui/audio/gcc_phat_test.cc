@@ -0,0 +1,113 @@
+#include "gcc_phat.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "diy/coro/task.h"
+
+using testing::DoubleNear;
+using testing::ElementsAre;
+using testing::Pointwise;
+
+namespace {
+// FFTs of white noise, circularly delayed by delays[c] samples in channel c.
+std::vector<Buffer<std::complex<double>>> DelayedNoise(
+    std::size_t n, const std::vector<std::size_t>& delays) {
+  std::mt19937 rng(1);
+  std::normal_distribution<double> distribution;
+  std::vector<double> noise(n);
+  for (double& x : noise) {
+    x = distribution(rng);
+  }
+  const FftPlan plan(n);
+  std::vector<Buffer<std::complex<double>>> fft;
+  for (const std::size_t delay : delays) {
+    Buffer<std::complex<double>> channel = FftBuffer(n);
+    for (std::size_t t = 0; t < n; ++t) {
+      channel[t] = noise[(t + n - delay) % n];
+    }
+    plan.Execute(channel);
+    fft.push_back(std::move(channel));
+  }
+  return fft;
+}
+}  // namespace
+
+TEST(GccPhatTest, ChannelPairs) {
+  EXPECT_EQ(ChannelPairs(2), 1);
+  EXPECT_EQ(ChannelPairs(8), 28);
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  for (std::size_t p = 0; p < ChannelPairs(4); ++p) {
+    pairs.push_back(ChannelPair(4, p));
+  }
+  EXPECT_THAT(pairs, ElementsAre(std::pair(0, 1), std::pair(0, 2),
+                                 std::pair(0, 3), std::pair(1, 2),
+                                 std::pair(1, 3), std::pair(2, 3)));
+}
+
+TEST(GccPhatTest, FindsDelays) {
+  FftPlanCache plans;
+  WorkerPool pool(2);
+  GccPhatScratch scratch;
+  const auto fft = DelayedNoise(64, {0, 3, 1});
+  const TdoaFrame frame = GccPhat(fft, {.max_lag = 4}, plans, pool, scratch);
+  // Pairs (0, 1), (0, 2) and (1, 2).
+  const std::vector<double> lags = {3, 1, -2};
+  const std::vector<double> peaks = {1, 1, 1};
+  const std::vector<double> histogram = {0, 0, 1, 0, 0, 1, 0, 1, 0};
+  EXPECT_THAT(frame.lags, Pointwise(DoubleNear(1e-9), lags));
+  EXPECT_THAT(frame.peaks, Pointwise(DoubleNear(1e-9), peaks));
+  EXPECT_THAT(frame.histogram, Pointwise(DoubleNear(1e-9), histogram));
+}
+
+TEST(GccPhatTest, IgnoresLagsBeyondMaximum) {
+  FftPlanCache plans;
+  WorkerPool pool(0);
+  GccPhatScratch scratch;
+  const auto fft = DelayedNoise(64, {0, 10});
+  const TdoaFrame frame = GccPhat(fft, {.max_lag = 4}, plans, pool, scratch);
+  EXPECT_LT(frame.peaks[0], 0.5);
+}
+
+TEST(GccPhatTest, InvalidInputsThrow) {
+  FftPlanCache plans;
+  WorkerPool pool(0);
+  GccPhatScratch scratch;
+  EXPECT_THROW(GccPhat(DelayedNoise(16, {0}), {}, plans, pool, scratch),
+               std::invalid_argument);
+  EXPECT_THROW(
+      GccPhat(DelayedNoise(16, {0, 1}), {.max_lag = 8}, plans, pool, scratch),
+      std::invalid_argument);
+}
+
+TEST(GccPhatTest, ScratchFollowsPairsAndWindowSize) {
+  FftPlanCache plans;
+  WorkerPool pool(2);
+  GccPhatScratch scratch;
+  GccPhat(DelayedNoise(64, {0, 3, 1}), {.max_lag = 4}, plans, pool, scratch);
+  EXPECT_EQ(scratch.size(), 3);
+  const TdoaFrame frame =
+      GccPhat(DelayedNoise(128, {0, 2}), {.max_lag = 4}, plans, pool, scratch);
+  ASSERT_EQ(scratch.size(), 1);
+  EXPECT_EQ(scratch[0].size(), 128);
+  EXPECT_NEAR(frame.lags[0], 2, 1e-9);
+}
+
+TEST(GccPhatTest, Stream) {
+  FftPlanCache plans;
+  WorkerPool pool(0);
+  auto source = []() -> AsyncGenerator<ChannelSpectra> {
+    ChannelSpectra spectra;
+    spectra.fft = DelayedNoise(32, {2, 0});
+    co_yield std::move(spectra);
+  }();
+  auto frames = GccPhat({.max_lag = 4}, plans, pool, std::move(source));
+  const TdoaFrame* frame = Task(frames).Wait();
+  ASSERT_NE(frame, nullptr);
+  ASSERT_THAT(frame->lags, testing::SizeIs(1));
+  EXPECT_NEAR(frame->lags[0], -2, 1e-9);
+  EXPECT_EQ(Task(frames).Wait(), nullptr);
+}
@@ -27,19 +27,20 @@ struct Awaiter {
 };
 }  // namespace
 
-AsyncGenerator<Buffer<std::int16_t>> InputSource() {
+AsyncGenerator<Buffer<std::int16_t>> InputSource(InputSourceOptions options) {
   Awaiter awaiter;
 
   ma_device_config config = ma_device_config_init(ma_device_type_capture);
   config.capture.format = ma_format_s16;
-  config.capture.channels = 1;
-  config.sampleRate = 24'000;
+  config.capture.channels = options.channels;
+  config.sampleRate = options.sample_rate;
   config.noFixedSizedCallback = true;
   config.pUserData = &awaiter;
   config.dataCallback = +[](ma_device* device, [[maybe_unused]] void* output,
-                            const void* input, ma_uint32 size) {
+                            const void* input, ma_uint32 frames) {
     auto& awaiter = *static_cast<Awaiter*>(device->pUserData);
-    awaiter.input = std::span(static_cast<const std::int16_t*>(input), size);
+    awaiter.input = std::span(static_cast<const std::int16_t*>(input),
+                              frames * device->capture.channels);
     if (awaiter.waiting) {
       awaiter.waiting.resume();
     }
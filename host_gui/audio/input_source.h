@@ -3,4 +3,11 @@
 #include "diy/buffer.h"
 #include "diy/coro/async_generator.h"
 
-AsyncGenerator<Buffer<std::int16_t>> InputSource();
+struct InputSourceOptions {
+  double sample_rate = 24'000;
+  // Buffers hold frames of one sample per channel, interleaved.
+  std::size_t channels = 1;
+};
+
+AsyncGenerator<Buffer<std::int16_t>> InputSource(
+    InputSourceOptions options = {});
@@ -18,3 +18,12 @@ TEST(InputSourceTest, SomeFrames) {
   EXPECT_THAT(Task(gen).Wait(), non_empty);
   EXPECT_THAT(Task(gen).Wait(), non_empty);
 }
+
+TEST(InputSourceTest, WholeStereoFrames) {
+  auto gen = InputSource({.channels = 2});
+  for (int i = 0; i < 3; ++i) {
+    auto* buffer = Task(gen).Wait();
+    ASSERT_NE(buffer, nullptr);
+    EXPECT_EQ(buffer->size() % 2, 0);
+  }
+}
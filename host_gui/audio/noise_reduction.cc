@@ -0,0 +1,118 @@
+#include "noise_reduction.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+}  // namespace
+
+NoiseReducer::NoiseReducer(NoiseReductionOptions options) : options_(options) {
+  if (!(options_.smoothing >= 0 && options_.smoothing < 1)) {
+    throw std::invalid_argument("Smoothing must be in [0, 1).");
+  }
+  if (options_.subwindows == 0 || options_.subwindow_spectra == 0) {
+    throw std::invalid_argument("Noise window must not be empty.");
+  }
+}
+
+void NoiseReducer::Reset(std::span<const double> psd) {
+  bins_ = psd.size();
+  smoothed_.assign(psd.begin(), psd.end());
+  subwindow_min_.assign(bins_, kInfinity);
+  subwindow_minima_.assign(options_.subwindows * bins_, kInfinity);
+  window_min_.assign(bins_, kInfinity);
+  oldest_subwindow_ = 0;
+  subwindow_size_ = 0;
+}
+
+template <bool kSubtract>
+void NoiseReducer::Step(std::span<const double> in, double* out) {
+  if (in.size() != bins_) {
+    Reset(in);
+  }
+  const double a = options_.smoothing;
+  const double b = 1 - options_.smoothing;
+  const double scale = options_.noise_scale;
+  const double floor = options_.floor;
+  double* const smoothed = smoothed_.data();
+  double* const subwindow_min = subwindow_min_.data();
+  const double* const window_min = window_min_.data();
+  std::size_t i = 0;
+#ifdef __AVX2__
+  const __m256d a4 = _mm256_set1_pd(a);
+  const __m256d b4 = _mm256_set1_pd(b);
+  const __m256d scale4 = _mm256_set1_pd(scale);
+  const __m256d floor4 = _mm256_set1_pd(floor);
+  for (; i + 4 <= bins_; i += 4) {
+    const __m256d p = _mm256_loadu_pd(in.data() + i);
+    const __m256d s = _mm256_fmadd_pd(a4, _mm256_loadu_pd(smoothed + i),
+                                      _mm256_mul_pd(b4, p));
+    _mm256_storeu_pd(smoothed + i, s);
+    const __m256d m = _mm256_min_pd(_mm256_loadu_pd(subwindow_min + i), s);
+    _mm256_storeu_pd(subwindow_min + i, m);
+    if constexpr (kSubtract) {
+      const __m256d noise = _mm256_mul_pd(
+          scale4, _mm256_min_pd(_mm256_loadu_pd(window_min + i), m));
+      _mm256_storeu_pd(out + i, _mm256_max_pd(_mm256_sub_pd(p, noise),
+                                              _mm256_mul_pd(floor4, p)));
+    }
+  }
+#endif
+  for (; i < bins_; ++i) {
+    const double p = in[i];
+    smoothed[i] = a * smoothed[i] + b * p;
+    subwindow_min[i] = std::min(subwindow_min[i], smoothed[i]);
+    if constexpr (kSubtract) {
+      const double noise = scale * std::min(window_min[i], subwindow_min[i]);
+      out[i] = std::max(p - noise, floor * p);
+    }
+  }
+
+  if (++subwindow_size_ < options_.subwindow_spectra) {
+    return;
+  }
+  // The current subwindow replaces the oldest one.
+  std::ranges::copy(subwindow_min_,
+                    subwindow_minima_.begin() + oldest_subwindow_ * bins_);
+  oldest_subwindow_ = (oldest_subwindow_ + 1) % options_.subwindows;
+  subwindow_size_ = 0;
+  std::ranges::fill(subwindow_min_, kInfinity);
+  std::ranges::copy(std::span(subwindow_minima_).first(bins_),
+                    window_min_.begin());
+  for (std::size_t row = 1; row < options_.subwindows; ++row) {
+    const double* minima = subwindow_minima_.data() + row * bins_;
+    for (std::size_t k = 0; k < bins_; ++k) {
+      window_min_[k] = std::min(window_min_[k], minima[k]);
+    }
+  }
+}
+
+void NoiseReducer::Process(std::span<double> psd) {
+  Step<true>(psd, psd.data());
+}
+
+void NoiseReducer::Update(std::span<const double> psd) {
+  Step<false>(psd, nullptr);
+}
+
+std::vector<double> NoiseReducer::NoiseEstimate() const {
+  std::vector<double> noise(bins_);
+  for (std::size_t k = 0; k < bins_; ++k) {
+    noise[k] =
+        options_.noise_scale * std::min(window_min_[k], subwindow_min_[k]);
+  }
+  return noise;
+}
+
+AsyncGenerator<Buffer<double>> ReduceNoise(
+    NoiseReductionOptions options, AsyncGenerator<Buffer<double>> spectra) {
+  NoiseReducer reducer(options);
+  while (Buffer<double>* psd = co_await spectra) {
+    reducer.Process(psd->span());
+    co_yield std::move(*psd);
+  }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "diy/buffer.h"
+#include "diy/coro/async_generator.h"
+
+struct NoiseReductionOptions {
+  // Weight of the previous smoothed PSD in the recursive average whose minima
+  // are tracked. Smoothing keeps the minima of noisy periodograms from
+  // falling far below the mean noise power. From 0 (no smoothing) to 1.
+  double smoothing = 0.7;
+  // Minima are taken over a sliding window of `subwindows` blocks of
+  // `subwindow_spectra` spectra, e.g. 48 spectra of 2048 samples last about
+  // 4 seconds at 24 kHz. The window should outlast the sounds of interest, or
+  // they're mistaken for noise.
+  std::size_t subwindows = 8;
+  std::size_t subwindow_spectra = 6;
+  // The noise estimate is the tracked minimum times `noise_scale`, which
+  // compensates for the minimum's bias below the mean noise power.
+  double noise_scale = 1.5;
+  // Output power is at least `floor` times the input power, so that
+  // subtraction leaves a faint background rather than holes.
+  double floor = 0.05;
+};
+
+// Spectral subtraction of a steady noise floor from a stream of PSDs, with
+// the noise estimated per bin by minimum statistics.
+//
+// The estimate is the minimum of the smoothed PSD over a sliding window. Each
+// spectrum updates the running minimum of the current subwindow; when a
+// subwindow completes, its minima replace the oldest subwindow's. The window
+// minimum is only recomputed then, so updates take amortized O(bins) time
+// without rescanning the window's spectra.
+class NoiseReducer {
+ public:
+  // Throws std::invalid_argument if `options` are invalid.
+  explicit NoiseReducer(NoiseReductionOptions options = {});
+
+  // Updates the noise estimate with `psd`, then subtracts the estimate from
+  // `psd` in place. A change of spectrum size restarts the estimate.
+  void Process(std::span<double> psd);
+
+  // Updates the noise estimate with `psd` only, e.g. to keep learning while
+  // subtraction is disabled.
+  void Update(std::span<const double> psd);
+
+  // The current per-bin noise estimate, empty before the first spectrum.
+  std::vector<double> NoiseEstimate() const;
+
+ private:
+  template <bool kSubtract>
+  void Step(std::span<const double> in, double* out);
+  void Reset(std::span<const double> psd);
+
+  const NoiseReductionOptions options_;
+  std::size_t bins_ = 0;
+  std::vector<double> smoothed_;
+  // Minimum of `smoothed_` in the current subwindow so far.
+  std::vector<double> subwindow_min_;
+  // Minima of the completed subwindows, one row of `bins_` per subwindow, and
+  // their minimum.
+  std::vector<double> subwindow_minima_;
+  std::vector<double> window_min_;
+  // Row of `subwindow_minima_` that the current subwindow replaces.
+  std::size_t oldest_subwindow_ = 0;
+  std::size_t subwindow_size_ = 0;
+};
+
+// Applies a NoiseReducer to each spectrum of `spectra`.
+AsyncGenerator<Buffer<double>> ReduceNoise(
+    NoiseReductionOptions options, AsyncGenerator<Buffer<double>> spectra);
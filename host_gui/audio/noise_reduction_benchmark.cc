@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "noise_reduction.h"
+
+namespace {
+std::vector<double> RandomPsd(std::mt19937& rng, std::size_t bins) {
+  std::exponential_distribution<double> distribution(1e-3);
+  std::vector<double> psd(bins);
+  std::ranges::generate(psd, [&] { return distribution(rng); });
+  return psd;
+}
+}  // namespace
+
+// Noise estimation and subtraction, per spectrum of `n` bins. Includes the
+// amortized cost of sliding the window.
+static void BM_NoiseReducer(benchmark::State& state) {
+  const std::size_t bins = state.range(0);
+  std::mt19937 rng{std::random_device{}()};
+  const std::vector<double> psds[] = {RandomPsd(rng, bins),
+                                      RandomPsd(rng, bins)};
+  std::vector<double> psd(bins);
+  NoiseReducer reducer;
+  std::size_t i = 0;
+  for (auto _ : state) {
+    std::ranges::copy(psds[i++ % 2], psd.begin());
+    reducer.Process(psd);
+    benchmark::DoNotOptimize(psd.data());
+  }
+  state.SetItemsProcessed(bins * state.iterations());
+}
+BENCHMARK(BM_NoiseReducer)->RangeMultiplier(4)->Range(129, 32769);
@@ -0,0 +1,163 @@
+#include "noise_reduction.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "diy/coro/task.h"
+
+using testing::Each;
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace {
+constexpr std::size_t kBins = 129;
+}  // namespace
+
+TEST(NoiseReducerTest, SteadyNoiseIsFloored) {
+  NoiseReducer reducer({.noise_scale = 1.5, .floor = 0.05});
+  std::vector<double> psd;
+  for (int i = 0; i < 10; ++i) {
+    psd.assign(kBins, 10);
+    reducer.Process(psd);
+  }
+  EXPECT_THAT(psd, Each(0.5));
+  EXPECT_THAT(reducer.NoiseEstimate(), Each(15));
+}
+
+TEST(NoiseReducerTest, ToneSurvives) {
+  NoiseReducer reducer({.noise_scale = 1.5, .floor = 0.05});
+  std::vector<double> psd;
+  for (int i = 0; i < 10; ++i) {
+    psd.assign(kBins, 10);
+    reducer.Process(psd);
+  }
+  // A tone starting after the noise floor was learned.
+  psd.assign(kBins, 10);
+  psd[5] = 1000;
+  reducer.Process(psd);
+  EXPECT_DOUBLE_EQ(psd[5], 1000 - 15);
+  EXPECT_DOUBLE_EQ(psd[4], 0.5);
+  EXPECT_DOUBLE_EQ(psd[6], 0.5);
+}
+
+TEST(NoiseReducerTest, FirstSpectrumIsItsOwnNoise) {
+  NoiseReducer reducer({.noise_scale = 1, .floor = 0});
+  std::vector<double> psd(kBins, 10);
+  reducer.Process(psd);
+  EXPECT_THAT(psd, Each(0));
+}
+
+TEST(NoiseReducerTest, SlidingWindow) {
+  NoiseReducer reducer({.smoothing = 0,
+                        .subwindows = 2,
+                        .subwindow_spectra = 3,
+                        .noise_scale = 1});
+  const std::vector<double> quiet(kBins, 10);
+  const std::vector<double> loud(kBins, 100);
+  for (int i = 0; i < 6; ++i) {
+    reducer.Update(quiet);
+  }
+  // The estimate falls as soon as the noise does, but the quiet minimum is
+  // remembered until both of its subwindows have slid out of the window.
+  for (int i = 0; i < 5; ++i) {
+    reducer.Update(loud);
+  }
+  EXPECT_THAT(reducer.NoiseEstimate(), Each(10));
+  reducer.Update(loud);
+  EXPECT_THAT(reducer.NoiseEstimate(), Each(100));
+  reducer.Update(quiet);
+  EXPECT_THAT(reducer.NoiseEstimate(), Each(10));
+}
+
+TEST(NoiseReducerTest, UpdateLeavesSpectrumUnchanged) {
+  NoiseReducer reducer;
+  const std::vector<double> psd = {1, 2, 3, 4, 5};
+  reducer.Update(psd);
+  reducer.Update(psd);
+  EXPECT_THAT(psd, ElementsAre(1, 2, 3, 4, 5));
+  EXPECT_THAT(reducer.NoiseEstimate(), ElementsAre(1.5, 3, 4.5, 6, 7.5));
+}
+
+TEST(NoiseReducerTest, SizeChangeRestarts) {
+  NoiseReducer reducer({.noise_scale = 1});
+  EXPECT_THAT(reducer.NoiseEstimate(), IsEmpty());
+  reducer.Update(std::vector<double>(kBins, 1));
+  reducer.Update(std::vector<double>(65, 100));
+  EXPECT_THAT(reducer.NoiseEstimate(), Each(100));
+}
+
+TEST(NoiseReducerTest, MatchesReference) {
+  // Random spectra through the vectorized path and a per-bin reference.
+  const NoiseReductionOptions options = {.subwindows = 3,
+                                         .subwindow_spectra = 4};
+  NoiseReducer reducer(options);
+  std::mt19937 rng(1);
+  std::exponential_distribution<double> distribution(1e-3);
+  std::vector<double> smoothed(kBins);
+  std::vector<std::vector<double>> history;
+  std::vector<double> psd(kBins);
+  for (int i = 0; i < 40; ++i) {
+    std::ranges::generate(psd, [&] { return distribution(rng); });
+    for (std::size_t k = 0; k < kBins; ++k) {
+      smoothed[k] = i == 0 ? psd[k]
+                           : options.smoothing * smoothed[k] +
+                                 (1 - options.smoothing) * psd[k];
+    }
+    history.push_back(smoothed);
+    // The window holds the completed subwindows and the current one.
+    const std::size_t window =
+        (options.subwindows * options.subwindow_spectra) + (i % 4) + 1;
+    std::vector<double> expected(kBins);
+    for (std::size_t k = 0; k < kBins; ++k) {
+      double noise = history.back()[k];
+      for (std::size_t j = 0; j < std::min(window, history.size()); ++j) {
+        noise = std::min(noise, history[history.size() - 1 - j][k]);
+      }
+      expected[k] = std::max(psd[k] - options.noise_scale * noise,
+                             options.floor * psd[k]);
+    }
+    reducer.Process(psd);
+    for (std::size_t k = 0; k < kBins; ++k) {
+      ASSERT_NEAR(psd[k], expected[k], 1e-9 * expected[k]) << i << " " << k;
+    }
+  }
+}
+
+TEST(NoiseReducerTest, InvalidOptionsThrow) {
+  EXPECT_THROW(NoiseReducer({.smoothing = 1}), std::invalid_argument);
+  EXPECT_THROW(NoiseReducer({.smoothing = -0.5}), std::invalid_argument);
+  EXPECT_THROW(NoiseReducer({.subwindows = 0}), std::invalid_argument);
+  EXPECT_THROW(NoiseReducer({.subwindow_spectra = 0}), std::invalid_argument);
+}
+
+TEST(NoiseReducerTest, SteadyToneIsNoise) {
+  // A tone lasting longer than the window is indistinguishable from noise.
+  NoiseReducer reducer({.subwindows = 2, .subwindow_spectra = 2});
+  std::vector<double> psd;
+  for (int i = 0; i < 10; ++i) {
+    psd.assign(kBins, 10);
+    psd[5] = 1000;
+    reducer.Process(psd);
+  }
+  EXPECT_DOUBLE_EQ(psd[5], 50);
+}
+
+TEST(NoiseReducerTest, Stream) {
+  auto spectra = []() -> AsyncGenerator<Buffer<double>> {
+    for (int i = 0; i < 3; ++i) {
+      co_yield AdoptAsBuffer(std::vector<double>(kBins, 10));
+    }
+  }();
+  auto reduced = ReduceNoise({.noise_scale = 1, .floor = 0.1},
+                             std::move(spectra));
+  for (int i = 0; i < 3; ++i) {
+    Buffer<double>* psd = Task(reduced).Wait();
+    ASSERT_NE(psd, nullptr);
+    EXPECT_THAT(psd->span(), Each(1));
+  }
+  EXPECT_EQ(Task(reduced).Wait(), nullptr);
+}
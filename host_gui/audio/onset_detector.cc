@@ -0,0 +1,113 @@
+#include "onset_detector.h"
+
+#include <absl/strings/str_format.h>
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "diy/fast_log.h"
+
+double SpectralFlux(std::span<const double> previous,
+                    std::span<const double> current) {
+  assert(previous.size() == current.size());
+  const std::size_t n = current.size();
+  if (n == 0) {
+    return 0;
+  }
+  double sum = 0;
+  std::size_t i = 0;
+#ifdef __AVX2__
+  const __m256d zero = _mm256_setzero_pd();
+  __m256d lane_sums = zero;
+  for (; i + 4 <= n; i += 4) {
+    const __m256d rise = _mm256_sub_pd(_mm256_loadu_pd(current.data() + i),
+                                       _mm256_loadu_pd(previous.data() + i));
+    lane_sums = _mm256_add_pd(lane_sums, _mm256_max_pd(rise, zero));
+  }
+  alignas(32) double lanes[4];
+  _mm256_store_pd(lanes, lane_sums);
+  sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+  for (; i < n; ++i) {
+    sum += std::max(0.0, current[i] - previous[i]);
+  }
+  return sum / n;
+}
+
+OnsetDetector::OnsetDetector(double sample_rate, OnsetDetectorOptions options)
+    : sample_rate_(sample_rate), options_(options) {
+  if (options_.median_spectra == 0) {
+    throw std::invalid_argument(
+        "Onset threshold needs at least one spectrum of history.");
+  }
+}
+
+double OnsetDetector::Threshold() {
+  double median = 0;
+  if (!recent_flux_.empty()) {
+    median_scratch_.assign(recent_flux_.begin(), recent_flux_.end());
+    const auto middle = median_scratch_.begin() + median_scratch_.size() / 2;
+    std::nth_element(median_scratch_.begin(), middle, median_scratch_.end());
+    median = *middle;
+  }
+  return options_.threshold_scale * median + options_.threshold_offset;
+}
+
+std::optional<OnsetEvent> OnsetDetector::Add(std::span<const double> psd,
+                                             std::int64_t window_end) {
+  assert(psd.size() >= 2);
+  log_.resize(psd.size());
+  FastLog2p1(psd, log_);
+  const bool continuous = log_.size() == previous_log_.size();
+  const double flux = continuous ? SpectralFlux(previous_log_, log_) : 0;
+  std::swap(log_, previous_log_);
+  if (!continuous) {
+    candidate_.reset();
+    return std::nullopt;
+  }
+
+  std::optional<OnsetEvent> onset;
+  if (candidate_ && candidate_->rising &&
+      candidate_->event.flux > candidate_->event.threshold &&
+      candidate_->event.flux > flux &&
+      (!last_onset_ ||
+       candidate_->event.timestamp - *last_onset_ >= options_.min_interval)) {
+    onset = candidate_->event;
+    last_onset_ = onset->timestamp;
+  }
+
+  const bool rising = !candidate_ || flux >= candidate_->event.flux;
+  candidate_ = Candidate{
+      .event = {.timestamp = absl::Seconds(window_end) / sample_rate_,
+                .flux = flux,
+                .threshold = Threshold()},
+      .rising = rising};
+  recent_flux_.push_back(flux);
+  if (recent_flux_.size() > options_.median_spectra) {
+    recent_flux_.pop_front();
+  }
+  return onset;
+}
+
+AsyncGenerator<OnsetEvent> DetectOnsets(
+    OnsetDetectorOptions options, double sample_rate,
+    AsyncGenerator<ChannelSpectra> spectra) {
+  OnsetDetector detector(sample_rate, options);
+  while (ChannelSpectra* frame = co_await spectra) {
+    if (const std::optional<OnsetEvent> onset =
+            detector.Add(frame->power.front().span(), frame->window_end)) {
+      co_yield *onset;
+    }
+  }
+}
+
+void WriteOnsetsCsv(std::span<const OnsetEvent> onsets, std::ostream& out) {
+  out << "time_s,flux,threshold\n";
+  for (const OnsetEvent& onset : onsets) {
+    out << absl::StrFormat("%.6f,%.6g,%.6g\n",
+                           absl::ToDoubleSeconds(onset.timestamp), onset.flux,
+                           onset.threshold);
+  }
+}
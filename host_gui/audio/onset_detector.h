@@ -0,0 +1,87 @@
+#pragma once
+
+#include <absl/time/time.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include "diy/buffer.h"
+#include "diy/coro/async_generator.h"
+#include "spectrum.h"
+
+struct OnsetDetectorOptions {
+  // Number of preceding spectra whose median flux the threshold adapts to.
+  std::size_t median_spectra = 16;
+  // An onset's flux must exceed `threshold_scale` times the recent median plus
+  // `threshold_offset`, in the units of SpectralFlux().
+  double threshold_scale = 1.5;
+  double threshold_offset = 0.1;
+  // Onsets sooner than this after the previous one are ignored, e.g. the
+  // ringing of a transient.
+  absl::Duration min_interval = absl::Milliseconds(50);
+};
+
+// A transient event, e.g. a note or a click.
+struct OnsetEvent {
+  // End of the window of the spectrum at which the flux peaked.
+  absl::Duration timestamp;
+  // Spectral flux of that spectrum, and the adaptive threshold it exceeded.
+  double flux = 0;
+  double threshold = 0;
+};
+
+// Mean rise per bin from `previous` to `current`, two log2(psd + 1) spectra of
+// equal size. Falling bins count as zero, so that onsets stand out from the
+// decay of earlier sounds.
+double SpectralFlux(std::span<const double> previous,
+                    std::span<const double> current);
+
+// Detects onsets in a stream of one-sided PSDs, as output by PowerSpectrum(),
+// by peak picking their spectral flux against a threshold that follows the
+// recent median flux.
+class OnsetDetector {
+ public:
+  // Throws std::invalid_argument if `options.median_spectra` is zero.
+  explicit OnsetDetector(double sample_rate, OnsetDetectorOptions options = {});
+
+  // Adds the PSD `psd` of the next window, which ends just before sample
+  // `window_end`, see ChannelSpectra. Returns the previous spectrum's onset, if
+  // it was one: a flux peak is only confirmed once the flux falls again. A
+  // change of spectrum size restarts the flux.
+  std::optional<OnsetEvent> Add(std::span<const double> psd,
+                                std::int64_t window_end);
+
+ private:
+  double Threshold();
+
+  const double sample_rate_;
+  const OnsetDetectorOptions options_;
+  // log2(psd + 1) of the most recent spectrum, and scratch space for the next.
+  std::vector<double> previous_log_;
+  std::vector<double> log_;
+  // Flux of up to `median_spectra` recent spectra, oldest first.
+  std::deque<double> recent_flux_;
+  std::vector<double> median_scratch_;
+  // The most recent spectrum, an onset if its flux turns out to be a peak.
+  struct Candidate {
+    OnsetEvent event;
+    // Whether its flux is at least that of the spectrum before it.
+    bool rising;
+  };
+  std::optional<Candidate> candidate_;
+  std::optional<absl::Duration> last_onset_;
+};
+
+// Onsets of channel 0 of `spectra`, as output by MultichannelSpectra().
+AsyncGenerator<OnsetEvent> DetectOnsets(OnsetDetectorOptions options,
+                                        double sample_rate,
+                                        AsyncGenerator<ChannelSpectra> spectra);
+
+// Writes `onsets` as CSV, with a header row, one row per onset and the
+// timestamp in seconds.
+void WriteOnsetsCsv(std::span<const OnsetEvent> onsets, std::ostream& out);
@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "diy/coro/task.h"
+#include "onset_detector.h"
+#include "source.h"
+
+namespace {
+std::vector<double> RandomPsd(std::mt19937& rng, std::size_t bins) {
+  std::exponential_distribution<double> distribution(1e-3);
+  std::vector<double> psd(bins);
+  std::ranges::generate(psd, [&] { return distribution(rng); });
+  return psd;
+}
+}  // namespace
+
+// Onset detection alone, per spectrum of `n` bins.
+static void BM_OnsetDetector(benchmark::State& state) {
+  const std::size_t bins = state.range(0);
+  std::mt19937 rng{std::random_device{}()};
+  const std::vector<double> psds[] = {RandomPsd(rng, bins),
+                                      RandomPsd(rng, bins)};
+  OnsetDetector detector(24'000);
+  std::int64_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(detector.Add(psds[i % 2], 256 * i));
+    ++i;
+  }
+  state.SetItemsProcessed(bins * state.iterations());
+}
+BENCHMARK(BM_OnsetDetector)->RangeMultiplier(4)->Range(129, 32769);
+
+// Spectra and onsets of the simulated recording, replayed as fast as
+// possible. The "realtime" counter is the replay speed relative to real time.
+static void BM_InstantReplay(benchmark::State& state) {
+  const std::size_t window_size = state.range(0);
+  const std::size_t hop_size = window_size / 4;
+  SpectrumConfig config({.sample_rate = 24'000,
+                         .window_size = window_size,
+                         .window_function = WindowFunction::kHann,
+                         .hop_size = hop_size});
+  auto spectra = PowerSpectrum(
+      config, SimulatedSource(absl::Milliseconds(10),
+                              SimulatedSourcePacing::kInstant));
+  OnsetDetector detector(24'000);
+  std::int64_t window_end = window_size;
+  for (auto _ : state) {
+    Buffer<double>* psd = Task(spectra).Wait();
+    benchmark::DoNotOptimize(detector.Add(psd->span(), window_end));
+    window_end += hop_size;
+  }
+  state.SetItemsProcessed(hop_size * state.iterations());
+  state.counters["realtime"] = benchmark::Counter(
+      static_cast<double>(hop_size * state.iterations()) / 24'000,
+      benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_InstantReplay)->RangeMultiplier(4)->Range(256, 16384);
@@ -0,0 +1,127 @@
+#include "onset_detector.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "diy/coro/task.h"
+
+using testing::IsEmpty;
+using testing::SizeIs;
+
+namespace {
+// 1 second windows of 256 samples, i.e. PSDs of 129 bins at 256 Hz.
+constexpr double kSampleRate = 256;
+constexpr std::size_t kBins = 129;
+
+// Onsets of a sequence of flat spectra, `q` for quiet and `L` for loud.
+std::vector<OnsetEvent> FlatOnsets(const std::string& levels,
+                                   OnsetDetectorOptions options = {}) {
+  OnsetDetector detector(kSampleRate, options);
+  std::vector<OnsetEvent> onsets;
+  std::int64_t window_end = 0;
+  for (const char level : levels) {
+    const std::vector<double> psd(kBins, level == 'L' ? 1023 : 1);
+    window_end += 256;
+    if (const auto onset = detector.Add(psd, window_end)) {
+      onsets.push_back(*onset);
+    }
+  }
+  return onsets;
+}
+}  // namespace
+
+TEST(SpectralFluxTest, RectifiedMeanRise) {
+  const std::vector<double> previous = {0, 1, 2, 3, 4, 5, 6};
+  const std::vector<double> current = {1, 1, 0, 5, 4, 9, 6};
+  EXPECT_DOUBLE_EQ(SpectralFlux(previous, current), (1.0 + 2 + 4) / 7);
+  EXPECT_EQ(SpectralFlux({}, {}), 0);
+}
+
+TEST(OnsetDetectorTest, Step) {
+  const std::vector<OnsetEvent> onsets = FlatOnsets("qqqqqqLLLL");
+  ASSERT_THAT(onsets, SizeIs(1));
+  // The 7th window ends after 7 seconds.
+  EXPECT_EQ(onsets[0].timestamp, absl::Seconds(7));
+  // log2(1024) - log2(2) bits in every bin.
+  EXPECT_DOUBLE_EQ(onsets[0].flux, 9);
+  EXPECT_DOUBLE_EQ(onsets[0].threshold, 0.1);
+}
+
+TEST(OnsetDetectorTest, UnconfirmedPeak) {
+  // The flux hasn't fallen yet.
+  EXPECT_THAT(FlatOnsets("qqqqL"), IsEmpty());
+}
+
+TEST(OnsetDetectorTest, MinInterval) {
+  const std::vector<OnsetEvent> onsets =
+      FlatOnsets("qqqqLqLqqqLq", {.min_interval = absl::Seconds(3)});
+  ASSERT_THAT(onsets, SizeIs(2));
+  EXPECT_EQ(onsets[0].timestamp, absl::Seconds(5));
+  EXPECT_EQ(onsets[1].timestamp, absl::Seconds(11));
+}
+
+TEST(OnsetDetectorTest, AdaptsToSteadyNoise) {
+  OnsetDetector detector(kSampleRate);
+  std::mt19937 rng(1);
+  std::exponential_distribution<double> distribution(1e-3);
+  std::vector<double> psd(kBins);
+  std::int64_t window_end = 0;
+  for (int i = 0; i < 200; ++i) {
+    std::ranges::generate(psd, [&] { return distribution(rng); });
+    EXPECT_EQ(detector.Add(psd, window_end += 256), std::nullopt) << i;
+  }
+  // A burst ten times louder still stands out.
+  std::ranges::generate(psd, [&] { return 10 * distribution(rng); });
+  EXPECT_EQ(detector.Add(psd, window_end += 256), std::nullopt);
+  std::ranges::generate(psd, [&] { return distribution(rng); });
+  EXPECT_NE(detector.Add(psd, window_end += 256), std::nullopt);
+}
+
+TEST(OnsetDetectorTest, SizeChangeRestarts) {
+  OnsetDetector detector(kSampleRate);
+  EXPECT_EQ(detector.Add(std::vector<double>(kBins, 1), 256), std::nullopt);
+  // Loud, but not comparable with the previous spectrum.
+  EXPECT_EQ(detector.Add(std::vector<double>(65, 1023), 384), std::nullopt);
+  EXPECT_EQ(detector.Add(std::vector<double>(65, 1), 512), std::nullopt);
+}
+
+TEST(OnsetDetectorTest, InvalidOptionsThrow) {
+  EXPECT_THROW(OnsetDetector(kSampleRate, {.median_spectra = 0}),
+               std::invalid_argument);
+}
+
+TEST(OnsetDetectorTest, Stream) {
+  // 256-sample windows, 128 samples apart.
+  auto spectra = []() -> AsyncGenerator<ChannelSpectra> {
+    std::int64_t window_start = 0;
+    for (const char level : std::string("qqqLq")) {
+      ChannelSpectra frame = {.window_start = window_start,
+                              .window_end = window_start + 256};
+      frame.power.push_back(AdoptAsBuffer(
+          std::vector<double>(kBins, level == 'L' ? 1023 : 1)));
+      co_yield std::move(frame);
+      window_start += 128;
+    }
+  }();
+  auto onsets = DetectOnsets({}, kSampleRate, std::move(spectra));
+  const OnsetEvent* onset = Task(onsets).Wait();
+  ASSERT_NE(onset, nullptr);
+  // Windows end after 1, 1.5, 2, 2.5 and 3 seconds.
+  EXPECT_EQ(onset->timestamp, absl::Seconds(2.5));
+  EXPECT_EQ(Task(onsets).Wait(), nullptr);
+}
+
+TEST(OnsetDetectorTest, Csv) {
+  const std::vector<OnsetEvent> onsets = {
+      {.timestamp = absl::Milliseconds(250), .flux = 2, .threshold = 0.5}};
+  std::ostringstream out;
+  WriteOnsetsCsv(onsets, out);
+  EXPECT_EQ(out.str(),
+            "time_s,flux,threshold\n"
+            "0.250000,2,0.5\n");
+}
@@ -0,0 +1,173 @@
+#include "peak_tracker.h"
+
+#include <absl/strings/str_format.h>
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Smallest power of an HPS pitch candidate, relative to the strongest peak.
+constexpr double kMinFundamentalPower = 1e-3;
+
+// Vertex of the parabola through the log values of bins k - 1, k and k + 1.
+struct Vertex {
+  // Offset from bin k, within half a bin.
+  double offset;
+  // Interpolated value at the vertex.
+  double value;
+};
+
+// The log of a peak of a smooth window's main lobe is close to a parabola, so
+// interpolating log values is more accurate than interpolating the values
+// themselves.
+Vertex ParabolicPeak(std::span<const double> values, std::size_t k) {
+  if (k == 0 || k + 1 >= values.size()) {
+    return {.offset = 0, .value = values[k]};
+  }
+  auto log = [](double x) {
+    return std::log(std::max(x, std::numeric_limits<double>::min()));
+  };
+  const double y0 = log(values[k - 1]);
+  const double y1 = log(values[k]);
+  const double y2 = log(values[k + 1]);
+  const double curvature = y0 - 2 * y1 + y2;
+  if (!(curvature < 0)) {
+    return {.offset = 0, .value = values[k]};
+  }
+  const double offset = std::clamp(0.5 * (y0 - y2) / curvature, -0.5, 0.5);
+  return {.offset = offset, .value = std::exp(y1 - 0.25 * (y0 - y2) * offset)};
+}
+
+}  // namespace
+
+std::size_t PeakBin(std::span<const double> values) {
+  assert(!values.empty());
+  const std::size_t n = values.size();
+  std::size_t best = 0;
+  std::size_t i = 1;
+#ifdef __AVX2__
+  if (n >= 8) {
+    // Each lane tracks the largest of every fourth value, and its index.
+    // Indices are kept as doubles so that they can be blended with the same
+    // comparison mask; they're exact far beyond any spectrum size.
+    __m256d lane_max = _mm256_loadu_pd(values.data());
+    __m256d index = _mm256_setr_pd(0, 1, 2, 3);
+    __m256d lane_best = index;
+    const __m256d step = _mm256_set1_pd(4);
+    for (i = 4; i + 4 <= n; i += 4) {
+      index = _mm256_add_pd(index, step);
+      const __m256d v = _mm256_loadu_pd(values.data() + i);
+      const __m256d greater = _mm256_cmp_pd(v, lane_max, _CMP_GT_OQ);
+      lane_max = _mm256_blendv_pd(lane_max, v, greater);
+      lane_best = _mm256_blendv_pd(lane_best, index, greater);
+    }
+    alignas(32) double maxima[4];
+    alignas(32) double indices[4];
+    _mm256_store_pd(maxima, lane_max);
+    _mm256_store_pd(indices, lane_best);
+    double best_value = maxima[0];
+    double best_index = indices[0];
+    for (int lane = 1; lane < 4; ++lane) {
+      if (maxima[lane] > best_value ||
+          (maxima[lane] == best_value && indices[lane] < best_index)) {
+        best_value = maxima[lane];
+        best_index = indices[lane];
+      }
+    }
+    best = static_cast<std::size_t>(best_index);
+  }
+#endif
+  for (; i < n; ++i) {
+    if (values[i] > values[best]) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+PeakTracker::PeakTracker(double sample_rate, PeakTrackerOptions options)
+    : sample_rate_(sample_rate), options_(options) {
+  if (options_.harmonics == 0) {
+    throw std::invalid_argument("HPS needs at least one harmonic.");
+  }
+}
+
+TrackPoint PeakTracker::Track(std::span<const double> psd,
+                              std::int64_t window_end) {
+  assert(psd.size() >= 2);
+  const std::size_t window_size = 2 * (psd.size() - 1);
+  TrackPoint point = {.timestamp = absl::Seconds(window_end) / sample_rate_};
+
+  const double bin_width = sample_rate_ / window_size;
+  const auto first = static_cast<std::size_t>(
+      std::max(0.0, std::ceil(options_.min_frequency / bin_width)));
+  if (first >= psd.size()) {
+    return point;
+  }
+  const std::size_t peak = first + PeakBin(psd.subspan(first));
+  const Vertex vertex = ParabolicPeak(psd, peak);
+  point.frequency = (peak + vertex.offset) * bin_width;
+  point.power = vertex.value;
+
+  // Bins whose harmonics are all within the spectrum. The HPS multiplies each
+  // bin by the bins at its multiples, so only a fundamental lines up with
+  // peaks in all of them.
+  const std::size_t bins = (psd.size() - 1) / options_.harmonics + 1;
+  if (first >= bins) {
+    return point;
+  }
+  auto hps = [&](std::size_t k) {
+    double product = psd[k];
+    for (std::size_t h = 2; h <= options_.harmonics; ++h) {
+      product *= psd[h * k];
+    }
+    return product;
+  };
+  // The HPS of a pure tone is as large at its subharmonics as at the tone
+  // itself, since each of them has the tone as one harmonic. Candidates must
+  // therefore have power of their own.
+  const double min_power = kMinFundamentalPower * point.power;
+  hps_.assign(bins - first, 0);
+  for (std::size_t k = first; k < bins; ++k) {
+    if (psd[k] >= min_power) {
+      hps_[k - first] = hps(k);
+    }
+  }
+  std::size_t pitch = first + PeakBin(hps_);
+  if (hps_[pitch - first] == 0) {
+    return point;
+  }
+  // Leakage around the overtones skews the HPS towards neighbouring bins, so
+  // the estimate is refined on the fundamental's own peak instead.
+  while (pitch + 1 < psd.size() && psd[pitch + 1] > psd[pitch]) {
+    ++pitch;
+  }
+  while (pitch > first && psd[pitch - 1] > psd[pitch]) {
+    --pitch;
+  }
+  point.pitch = (pitch + ParabolicPeak(psd, pitch).offset) * bin_width;
+  return point;
+}
+
+AsyncGenerator<TrackPoint> TrackPeaks(PeakTrackerOptions options,
+                                      double sample_rate,
+                                      AsyncGenerator<ChannelSpectra> spectra) {
+  PeakTracker tracker(sample_rate, options);
+  while (ChannelSpectra* frame = co_await spectra) {
+    co_yield tracker.Track(frame->power.front().span(), frame->window_end);
+  }
+}
+
+void WriteTrackCsv(std::span<const TrackPoint> track, std::ostream& out) {
+  out << "time_s,frequency_hz,power,pitch_hz\n";
+  for (const TrackPoint& point : track) {
+    out << absl::StrFormat("%.6f,%.3f,%.6g,%.3f\n",
+                           absl::ToDoubleSeconds(point.timestamp),
+                           point.frequency, point.power, point.pitch);
+  }
+}
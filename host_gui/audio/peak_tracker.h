@@ -0,0 +1,71 @@
+#pragma once
+
+#include <absl/time/time.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include "diy/buffer.h"
+#include "diy/coro/async_generator.h"
+#include "spectrum.h"
+
+struct PeakTrackerOptions {
+  // Bins below this frequency, e.g. DC offset and mains hum, are ignored by
+  // both estimates.
+  double min_frequency = 60;
+  // Number of harmonics, including the fundamental, multiplied together by
+  // the pitch estimate.
+  std::size_t harmonics = 4;
+};
+
+// Dominant frequency and pitch of one spectrum.
+struct TrackPoint {
+  // End of the spectrum's window, from the start of the stream.
+  absl::Duration timestamp;
+  // Frequency of the strongest bin, refined by parabolic interpolation.
+  double frequency = 0;
+  // Interpolated PSD at `frequency`.
+  double power = 0;
+  // Fundamental frequency estimated by the harmonic product spectrum (HPS),
+  // which finds the pitch of harmonic sounds even when an overtone is
+  // stronger than the fundamental. The fundamental must be within 30 dB of
+  // the strongest peak.
+  double pitch = 0;
+};
+
+// Index of the largest value of `values`, or of the first of several equal
+// largest values. `values` must not be empty.
+std::size_t PeakBin(std::span<const double> values);
+
+// Tracks the dominant frequency and pitch of a stream of one-sided PSDs, as
+// output by PowerSpectrum().
+class PeakTracker {
+ public:
+  // Throws std::invalid_argument if `options.harmonics` is zero.
+  explicit PeakTracker(double sample_rate, PeakTrackerOptions options = {});
+
+  // Track point of the PSD `psd` of the window ending just before sample
+  // `window_end`, see ChannelSpectra. Frequencies are zero if no bin is above
+  // `min_frequency`, and the pitch is zero if no bin below Nyquist divided by
+  // `harmonics` is strong enough to be the fundamental.
+  TrackPoint Track(std::span<const double> psd, std::int64_t window_end);
+
+ private:
+  const double sample_rate_;
+  const PeakTrackerOptions options_;
+  // Harmonic product spectrum scratch space.
+  std::vector<double> hps_;
+};
+
+// Track points of channel 0 of each item of `spectra`, as output by
+// MultichannelSpectra().
+AsyncGenerator<TrackPoint> TrackPeaks(PeakTrackerOptions options,
+                                      double sample_rate,
+                                      AsyncGenerator<ChannelSpectra> spectra);
+
+// Writes `track` as CSV, with a header row, one row per point and the
+// timestamp in seconds.
+void WriteTrackCsv(std::span<const TrackPoint> track, std::ostream& out);
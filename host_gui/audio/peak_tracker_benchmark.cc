@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "peak_tracker.h"
+
+namespace {
+std::vector<double> RandomPsd(std::size_t bins) {
+  std::mt19937 rng{std::random_device{}()};
+  std::exponential_distribution<double> distribution;
+  std::vector<double> psd(bins);
+  std::ranges::generate(psd, [&] { return distribution(rng); });
+  return psd;
+}
+}  // namespace
+
+// Vectorized peak picking over `n` bins, compared to std::max_element
+// (simd=0).
+static void BM_PeakBin(benchmark::State& state) {
+  const std::vector<double> psd = RandomPsd(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        state.range(1) ? PeakBin(psd)
+                       : std::ranges::max_element(psd) - psd.begin());
+  }
+  state.SetItemsProcessed(psd.size() * state.iterations());
+}
+BENCHMARK(BM_PeakBin)
+    ->ArgNames({"n", "simd"})
+    ->ArgsProduct({benchmark::CreateRange(128, 32768, /*multi=*/4), {0, 1}});
+
+// Peak and pitch of the PSD of an `n`-sample window.
+static void BM_Track(benchmark::State& state) {
+  const std::size_t n = state.range(0);
+  const std::vector<double> psd = RandomPsd(n / 2 + 1);
+  PeakTracker tracker(24'000);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tracker.Track(psd, 0));
+  }
+  state.SetItemsProcessed(psd.size() * state.iterations());
+}
+BENCHMARK(BM_Track)->RangeMultiplier(2)->Range(256, 65536);
@@ -0,0 +1,137 @@
+#include "peak_tracker.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "diy/coro/task.h"
+
+namespace {
+// PSD of 129 bins, i.e. 1 Hz bins at a 256 Hz sample rate, with a Gaussian
+// peak at each of `peaks` (bin, power) on a faint noise floor.
+std::vector<double> PeaksPsd(
+    const std::vector<std::pair<double, double>>& peaks) {
+  std::vector<double> psd(129, 1e-6);
+  for (const auto [center, power] : peaks) {
+    for (std::size_t k = 0; k < psd.size(); ++k) {
+      psd[k] += power * std::exp(-0.5 * (k - center) * (k - center));
+    }
+  }
+  return psd;
+}
+}  // namespace
+
+TEST(PeakBinTest, MatchesMaxElement) {
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> distribution(0, 20);
+  for (std::size_t n = 1; n < 70; ++n) {
+    std::vector<double> values(n);
+    std::ranges::generate(values, [&] { return distribution(rng); });
+    const auto expected = std::ranges::max_element(values) - values.begin();
+    EXPECT_EQ(PeakBin(values), expected) << "n = " << n;
+  }
+}
+
+TEST(PeakBinTest, FirstOfTies) {
+  EXPECT_EQ(PeakBin(std::vector<double>(37, 1.0)), 0);
+  std::vector<double> values(37, 1.0);
+  values[6] = 2;
+  values[9] = 2;
+  values[33] = 2;
+  EXPECT_EQ(PeakBin(values), 6);
+}
+
+TEST(PeakTrackerTest, RefinesPeak) {
+  PeakTracker tracker(256, {.min_frequency = 1});
+  const TrackPoint point = tracker.Track(PeaksPsd({{40.3, 5}}), 256);
+  EXPECT_NEAR(point.frequency, 40.3, 1e-3);
+  EXPECT_NEAR(point.power, 5, 1e-3);
+}
+
+TEST(PeakTrackerTest, PitchOfStrongOvertone) {
+  PeakTracker tracker(256, {.min_frequency = 1, .harmonics = 3});
+  // The second harmonic is the strongest bin, but the fundamental is 20 Hz.
+  const TrackPoint point =
+      tracker.Track(PeaksPsd({{20, 1}, {40, 4}, {60, 2}}), 256);
+  EXPECT_NEAR(point.frequency, 40, 1e-3);
+  EXPECT_NEAR(point.pitch, 20, 1e-3);
+}
+
+TEST(PeakTrackerTest, IgnoresLowFrequencies) {
+  PeakTracker tracker(256, {.min_frequency = 10});
+  const TrackPoint point = tracker.Track(PeaksPsd({{0, 100}, {30, 1}}), 256);
+  EXPECT_NEAR(point.frequency, 30, 1e-3);
+  EXPECT_NEAR(point.pitch, 30, 1e-3);
+}
+
+TEST(PeakTrackerTest, NoBinsAboveMinimum) {
+  PeakTracker tracker(256, {.min_frequency = 1000});
+  const TrackPoint point = tracker.Track(PeaksPsd({{30, 1}}), 256);
+  EXPECT_EQ(point.frequency, 0);
+  EXPECT_EQ(point.pitch, 0);
+}
+
+TEST(PeakTrackerTest, NoPitchAbovePeak) {
+  // The peak is beyond the harmonics of any candidate fundamental.
+  PeakTracker tracker(256, {.min_frequency = 1, .harmonics = 4});
+  const TrackPoint point = tracker.Track(PeaksPsd({{100, 1}}), 256);
+  EXPECT_NEAR(point.frequency, 100, 1e-3);
+  EXPECT_EQ(point.pitch, 0);
+}
+
+TEST(PeakTrackerTest, Timestamps) {
+  PeakTracker tracker(256, {.min_frequency = 1});
+  const std::vector<double> psd = PeaksPsd({{30, 1}});
+  EXPECT_EQ(tracker.Track(psd, 256).timestamp, absl::Seconds(1));
+  EXPECT_EQ(tracker.Track(psd, 320).timestamp, absl::Seconds(1.25));
+  // Windows needn't be consecutive, e.g. after a hop size change.
+  EXPECT_EQ(tracker.Track(psd, 576).timestamp, absl::Seconds(2.25));
+}
+
+TEST(PeakTrackerTest, InvalidOptionsThrow) {
+  EXPECT_THROW(PeakTracker(256, {.harmonics = 0}), std::invalid_argument);
+}
+
+TEST(PeakTrackerTest, Stream) {
+  std::vector<std::vector<double>> psds = {PeaksPsd({{30, 1}}),
+                                           PeaksPsd({{50, 1}})};
+  // 256-sample windows, 128 samples apart.
+  auto spectra = [](auto psds) -> AsyncGenerator<ChannelSpectra> {
+    std::int64_t window_start = 0;
+    for (std::vector<double>& psd : psds) {
+      ChannelSpectra frame = {.window_start = window_start,
+                              .window_end = window_start + 256};
+      frame.power.push_back(AdoptAsBuffer(std::move(psd)));
+      co_yield std::move(frame);
+      window_start += 128;
+    }
+  }(std::move(psds));
+  auto track = TrackPeaks({.min_frequency = 1}, 256, std::move(spectra));
+  const TrackPoint* point = Task(track).Wait();
+  ASSERT_NE(point, nullptr);
+  EXPECT_NEAR(point->frequency, 30, 1e-3);
+  EXPECT_EQ(point->timestamp, absl::Seconds(1));
+  point = Task(track).Wait();
+  ASSERT_NE(point, nullptr);
+  EXPECT_NEAR(point->frequency, 50, 1e-3);
+  EXPECT_EQ(point->timestamp, absl::Seconds(1.5));
+  EXPECT_EQ(Task(track).Wait(), nullptr);
+}
+
+TEST(PeakTrackerTest, Csv) {
+  const std::vector<TrackPoint> track = {
+      {.timestamp = absl::Milliseconds(500),
+       .frequency = 440,
+       .power = 2.5,
+       .pitch = 220}};
+  std::ostringstream out;
+  WriteTrackCsv(track, out);
+  EXPECT_EQ(out.str(),
+            "time_s,frequency_hz,power,pitch_hz\n"
+            "0.500000,440.000,2.5,220.000\n");
+}
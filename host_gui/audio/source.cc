@@ -25,19 +25,27 @@ namespace {
 Buffer<std::int16_t> RampSamples(const RampSourceOptions& options) {
   const std::size_t size =
       absl::ToInt64Seconds(options.sample_rate * options.ramp_period);
+  const std::size_t channels = options.channels;
+  const std::int64_t delay = std::llround(
+      absl::ToDoubleSeconds(options.sample_rate * options.channel_delay));
   const float f_min = options.frequency_min;
   const float f_max = options.frequency_max;
-  auto samples = Buffer<std::int16_t>::Uninitialized(size);
-  auto t = std::ranges::iota_view<int, int>(0, size - 1);
-  auto y = t | std::views::transform([&](int t) -> std::int16_t {
-             const float f =
-                 std::lerp(f_min, f_max, static_cast<float>(t) / size);
-             const float val = std::sin(2 * std::numbers::pi_v<float> * f *
-                                        (t / options.sample_rate));
-             return static_cast<std::int16_t>(
-                 std::numeric_limits<std::int16_t>::max() * val);
-           });
-  std::ranges::copy(y, samples.begin());
+  auto ramp = [&](int t) -> std::int16_t {
+    const float f = std::lerp(f_min, f_max, static_cast<float>(t) / size);
+    const float val = std::sin(2 * std::numbers::pi_v<float> * f *
+                               (t / options.sample_rate));
+    return static_cast<std::int16_t>(std::numeric_limits<std::int16_t>::max() *
+                                     val);
+  };
+  auto samples = Buffer<std::int16_t>::Uninitialized(size * channels);
+  const auto n = static_cast<std::int64_t>(size);
+  for (std::int64_t t = 0; t < n; ++t) {
+    for (std::int64_t c = 0; c < static_cast<std::int64_t>(channels); ++c) {
+      // Delayed channels wrap around to the end of the previous ramp.
+      const std::int64_t delayed = (t - c * delay) % n;
+      samples[t * channels + c] = ramp(delayed < 0 ? delayed + n : delayed);
+    }
+  }
   return samples;
 }
 
@@ -56,10 +64,13 @@ Buffer<std::int16_t> PeriodicSubspan(std::span<const std::int16_t> s,
   return data;
 }
 
+// `samples` holds interleaved frames of `channels` samples each.
 AsyncGenerator<Buffer<std::int16_t>> PaceSamples(
     std::span<const std::int16_t> samples, double sample_rate,
-    absl::Duration period, SimulatedSourcePacing pacing) {
-  const std::size_t frame_size = absl::ToInt64Seconds(sample_rate * period);
+    absl::Duration period, SimulatedSourcePacing pacing,
+    std::size_t channels = 1) {
+  const std::size_t frame_size =
+      absl::ToInt64Seconds(sample_rate * period) * channels;
   if (frame_size > samples.size()) {
     throw std::invalid_argument("Period longer than simulated sample source.");
   }
@@ -87,7 +98,7 @@ AsyncGenerator<Buffer<std::int16_t>> SimulatedSource(
 AsyncGenerator<Buffer<std::int16_t>> RampSource(RampSourceOptions options) {
   const auto samples = RampSamples(options);
   auto frames = PaceSamples(samples, options.sample_rate, options.frame_period,
-                            options.pacing);
+                            options.pacing, options.channels);
   while (auto* frame = co_await frames) {
     co_yield std::move(*frame);
   }
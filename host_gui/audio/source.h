@@ -21,7 +21,8 @@ AsyncGenerator<Buffer<std::int16_t>> SimulatedSource(
     SimulatedSourcePacing pacing = SimulatedSourcePacing::kInstant);
 
 // A sinusoid whose frequency sweeps between [frequency_min, frequency_max) over
-// an interval of `ramp_period`.
+// an interval of `ramp_period`. With multiple channels, buffers hold
+// interleaved frames, and channel c lags channel 0 by c * `channel_delay`.
 struct RampSourceOptions {
   double sample_rate = 24'000;
   absl::Duration frame_period = absl::Milliseconds(10);
@@ -29,6 +30,8 @@ struct RampSourceOptions {
   double frequency_min = 1'000;
   double frequency_max = 10'000;
   SimulatedSourcePacing pacing = SimulatedSourcePacing::kInstant;
+  std::size_t channels = 1;
+  absl::Duration channel_delay = absl::ZeroDuration();
 };
 
 AsyncGenerator<Buffer<std::int16_t>> RampSource(RampSourceOptions options);
@@ -81,3 +81,22 @@ TEST(RampSourceTest, Loops) {
   EXPECT_THAT(frames[3], Ne(frames[2]));
   EXPECT_THAT(frames[4], Eq(frames[0]));
 }
+
+TEST(RampSourceTest, DelayedChannels) {
+  auto source = RampSource({.sample_rate = 100,
+                            .frame_period = absl::Milliseconds(250),
+                            .ramp_period = absl::Seconds(1),
+                            .frequency_min = 0,
+                            .frequency_max = 5,
+                            .channels = 2,
+                            .channel_delay = absl::Milliseconds(30)});
+  const std::vector<std::int16_t> first = NextFrame(source);
+  const std::vector<std::int16_t> second = NextFrame(source);
+  ASSERT_THAT(first, SizeIs(50));
+  ASSERT_THAT(second, SizeIs(50));
+  // Channel 1 lags channel 0 by 3 samples.
+  for (std::size_t t = 3; t < 25; ++t) {
+    EXPECT_EQ(first[2 * t + 1], first[2 * (t - 3)]) << t;
+  }
+  EXPECT_EQ(second[1], first[2 * 22]);
+}
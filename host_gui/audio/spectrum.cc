@@ -1,11 +1,15 @@
 #include "spectrum.h"
 
-#include <fftw3.h>
-
 #include <algorithm>
+#include <cmath>
 #include <complex>
+#include <map>
 #include <memory>
+#include <numbers>
 #include <ranges>
+#include <utility>
+
+#include "fft_plan.h"
 
 namespace {
 
@@ -42,95 +46,66 @@ double ScaleFactor(std::span<const double> window) {
   return factor / (window.size() * window.size());
 }
 
-Buffer<std::complex<double>> FftwBuffer(std::size_t n) {
-  auto* raw = reinterpret_cast<std::complex<double>*>(fftw_alloc_complex(n));
-  return Buffer<std::complex<double>>({raw, n}, [raw] { fftw_free(raw); });
-}
-
-struct Plan {
-  fftw_plan plan;
-  ~Plan() { fftw_destroy_plan(plan); }
+// Window function values, their PSD scale factor, and the kernel for their
+// size.
+struct WindowTable {
+  Buffer<double> window;
+  double scale_factor;
+  const SpectrumKernel* kernel;
 };
 
-// Create a plan for an in-place complex-to-complex FFT.
-Plan CreatePlan(std::size_t n) {
-  auto fake_buffer = FftwBuffer(n);
-  return {fftw_plan_dft_1d(n,
-                           reinterpret_cast<fftw_complex*>(fake_buffer.data()),
-                           reinterpret_cast<fftw_complex*>(fake_buffer.data()),
-                           FFTW_FORWARD, FFTW_ESTIMATE)};
-}
+// WindowTables keyed by window function and size.
+class WindowCache {
+ public:
+  const WindowTable& Get(const SpectrumOptions& options) {
+    std::unique_ptr<WindowTable>& table =
+        tables_[{options.window_function, options.window_size}];
+    if (table == nullptr) {
+      Buffer<double> window = Window(options);
+      const double scale_factor = ScaleFactor(window);
+      table = std::make_unique<WindowTable>(
+          std::move(window), scale_factor,
+          &SelectSpectrumKernel(options.window_size, options.window_function));
+    }
+    return *table;
+  }
 
-Buffer<std::complex<double>> Spectrum(fftw_plan plan,
-                                      std::span<const double> window,
-                                      std::span<const std::int16_t> samples) {
-  const std::size_t n = samples.size();
-  Buffer<std::complex<double>> buffer = FftwBuffer(n);
-  std::ranges::transform(
-      samples, window, buffer.begin(),
-      [](std::int16_t s, double w) -> std::complex<double> { return w * s; });
-  auto* buffer_data = reinterpret_cast<fftw_complex*>(buffer.data());
-  // In-place FFT.
-  fftw_execute_dft(plan, buffer_data, buffer_data);
-  return buffer;
-}
+ private:
+  std::map<std::pair<WindowFunction, std::size_t>,
+           std::unique_ptr<WindowTable>>
+      tables_;
+};
 
-template <typename T>
-AsyncGenerator<std::vector<T>> ChunkedSamples(
-    std::size_t n, AsyncGenerator<Buffer<T>> source) {
-  std::vector<T> chunk(n);
-  std::span<T> unfilled_chunk_span(chunk);
-  Buffer<T>* source_frame = co_await source;
-  if (!source_frame) {
-    co_return;
+void CheckOptions(const SpectrumOptions& options) {
+  CheckEven(options.window_size);
+  if (options.window_size == 0) {
+    throw std::invalid_argument("FFT length must be positive.");
   }
-  std::span<T> current_source_span = source_frame->span();
-  while (true) {
-    if (current_source_span.empty()) {
-      source_frame = co_await source;
-      if (!source_frame) {
-        co_return;
-      }
-      current_source_span = source_frame->span();
-    }
-    const std::size_t copy_count =
-        std::min(unfilled_chunk_span.size(), current_source_span.size());
-    std::ranges::copy(current_source_span.first(copy_count),
-                      unfilled_chunk_span.begin());
-    current_source_span = current_source_span.subspan(copy_count);
-    unfilled_chunk_span = unfilled_chunk_span.subspan(copy_count);
-    if (unfilled_chunk_span.empty()) {
-      co_yield chunk;
-      unfilled_chunk_span = chunk;
-    }
+  if (options.hop_size > options.window_size) {
+    throw std::invalid_argument(
+        "Hop size must not exceed the FFT length. Got: " +
+        std::to_string(options.hop_size) + " > " +
+        std::to_string(options.window_size));
   }
 }
 
+// Windowed FFT of `samples`, and its PSD.
+//
 // PSD scaling based off of https://dsp.stackexchange.com/a/32205 and
 // https://dsp.stackexchange.com/a/47603
-Buffer<double> SingleFramePowerSpectrum(fftw_plan plan,
-                                        std::span<const double> window,
-                                        double psd_scale_factor,
-                                        std::span<const std::int16_t> samples) {
+void SingleFrameSpectrum(const FftPlan& plan, const WindowTable& window,
+                         double psd_scale_factor,
+                         std::span<const std::int16_t> samples,
+                         Buffer<std::complex<double>>& spectrum,
+                         Buffer<double>& power_spectrum) {
   const std::size_t n = samples.size();
   CheckEven(n);
-  Buffer<std::complex<double>> spectrum = Spectrum(plan, window, samples);
-  // DC bin and nyquist bins are the only bins that don't have a conjugate pair.
-  const std::size_t conjugate_bin_count = (n - 2) / 2;
-  const std::size_t nyquist_index = n / 2;
-
-  // TODO(dhrosa): We could reuse the buffer returned by Spectrum().
-  auto power_spectrum = Buffer<double>::Uninitialized(2 + conjugate_bin_count);
-  power_spectrum.front() = psd_scale_factor * std::norm(spectrum[0]);
-  power_spectrum.back() = psd_scale_factor * std::norm(spectrum[nyquist_index]);
-  auto positive_ac = std::move(spectrum) | std::views::drop(1) |
-                     std::views::take(conjugate_bin_count);
-
-  std::ranges::transform(positive_ac, power_spectrum.begin() + 1,
-                         [&](std::complex<double> s) {
-                           return 2 * psd_scale_factor * std::norm(s);
-                         });
-  return power_spectrum;
+  spectrum = FftBuffer(n);
+  window.kernel->apply_window(samples, window.window, spectrum);
+  // In-place FFT.
+  plan.Execute(spectrum);
+  power_spectrum = Buffer<double>::Uninitialized(n / 2 + 1);
+  window.kernel->power(spectrum, psd_scale_factor, power_spectrum);
 }
 }  // namespace
 
@@ -143,17 +118,161 @@ std::vector<double> FrequencyBins(std::size_t n, double fs) {
   return bins;
 }
 
+SpectrumConfig::SpectrumConfig(const SpectrumOptions& options)
+    : options_(options) {
+  CheckOptions(options);
+}
+
+void SpectrumConfig::Set(const SpectrumOptions& options) {
+  CheckOptions(options);
+  absl::MutexLock lock(&mutex_);
+  options_ = options;
+  version_.fetch_add(1, std::memory_order_release);
+}
+
+SpectrumOptions SpectrumConfig::Get() const {
+  absl::MutexLock lock(&mutex_);
+  return options_;
+}
+
 AsyncGenerator<Buffer<double>> PowerSpectrum(
     SpectrumOptions options, AsyncGenerator<Buffer<std::int16_t>> source) {
-  CheckEven(options.window_size);
-  const Buffer<double> window = Window(options);
-  const double psd_scale_factor =
-      ScaleFactor(window) / (2 * options.sample_rate);
-  const Plan plan = CreatePlan(options.window_size);
-
-  auto chunked_samples = ChunkedSamples(options.window_size, std::move(source));
-  while (std::vector<std::int16_t>* frame = co_await chunked_samples) {
-    co_yield SingleFramePowerSpectrum(plan.plan, window, psd_scale_factor,
-                                      *frame);
+  const SpectrumConfig config(options);
+  auto spectra = PowerSpectrum(config, std::move(source));
+  while (Buffer<double>* spectrum = co_await spectra) {
+    co_yield std::move(*spectrum);
+  }
+}
+
+AsyncGenerator<Buffer<double>> PowerSpectrum(
+    const SpectrumConfig& config, AsyncGenerator<Buffer<std::int16_t>> source) {
+  FftPlanCache plans;
+  auto spectra = PowerSpectrum(config, plans, std::move(source));
+  while (Buffer<double>* spectrum = co_await spectra) {
+    co_yield std::move(*spectrum);
+  }
+}
+
+AsyncGenerator<Buffer<double>> PowerSpectrum(
+    const SpectrumConfig& config, FftPlanCache& plans,
+    AsyncGenerator<Buffer<std::int16_t>> source) {
+  auto channels = [](AsyncGenerator<Buffer<std::int16_t>> source)
+      -> AsyncGenerator<std::vector<Buffer<std::int16_t>>> {
+    while (Buffer<std::int16_t>* frame = co_await source) {
+      std::vector<Buffer<std::int16_t>> mono;
+      mono.push_back(std::move(*frame));
+      co_yield std::move(mono);
+    }
+  }(std::move(source));
+  WorkerPool inline_pool(0);
+  auto spectra = MultichannelPowerSpectrum(config, plans, inline_pool,
+                                           std::move(channels));
+  while (std::vector<Buffer<double>>* spectrum = co_await spectra) {
+    co_yield std::move(spectrum->front());
+  }
+}
+
+AsyncGenerator<std::vector<Buffer<double>>> MultichannelPowerSpectrum(
+    const SpectrumConfig& config, FftPlanCache& plans, WorkerPool& pool,
+    AsyncGenerator<std::vector<Buffer<std::int16_t>>> source) {
+  auto spectra = MultichannelSpectra(config, plans, pool, std::move(source));
+  while (ChannelSpectra* frame = co_await spectra) {
+    co_yield std::move(frame->power);
+  }
+}
+
+AsyncGenerator<ChannelSpectra> MultichannelSpectra(
+    const SpectrumConfig& config, FftPlanCache& plans, WorkerPool& pool,
+    AsyncGenerator<std::vector<Buffer<std::int16_t>>> source) {
+  WindowCache windows;
+  std::uint64_t version = config.version();
+  SpectrumOptions options = config.Get();
+
+  // Samples of each channel that haven't been consumed by a window yet start
+  // at `pending`. Consumed samples are discarded in bulk, to amortize the cost
+  // of shifting the remainder.
+  std::vector<std::vector<std::int16_t>> samples;
+  std::size_t pending = 0;
+  // Samples of each channel discarded so far.
+  std::int64_t discarded = 0;
+  while (std::vector<Buffer<std::int16_t>>* frame = co_await source) {
+    if (samples.empty()) {
+      samples.resize(frame->size());
+    }
+    if (frame->empty() || frame->size() != samples.size()) {
+      throw std::invalid_argument(
+          "Expected " + std::to_string(samples.size()) +
+          " channels. Got: " + std::to_string(frame->size()));
+    }
+    for (std::size_t c = 0; c < samples.size(); ++c) {
+      const Buffer<std::int16_t>& channel = (*frame)[c];
+      if (channel.size() != frame->front().size()) {
+        throw std::invalid_argument("Channels differ in length.");
+      }
+      samples[c].insert(samples[c].end(), channel.begin(), channel.end());
+    }
+    while (true) {
+      if (const std::uint64_t latest = config.version(); latest != version) {
+        version = latest;
+        options = config.Get();
+      }
+      const std::size_t n = options.window_size;
+      if (samples.front().size() - pending < n) {
+        break;
+      }
+      const WindowTable& window = windows.Get(options);
+      // Plans are looked up for every window, so that tuned plans are picked
+      // up as soon as they're ready.
+      const std::shared_ptr<const FftPlan> plan = plans.Get(n);
+      const double psd_scale_factor =
+          window.scale_factor / (2 * options.sample_rate);
+      ChannelSpectra spectra;
+      spectra.window_start = discarded + static_cast<std::int64_t>(pending);
+      spectra.window_end = spectra.window_start + static_cast<std::int64_t>(n);
+      spectra.fft.resize(samples.size());
+      spectra.power.resize(samples.size());
+      pool.ParallelFor(samples.size(), [&](std::size_t c) {
+        SingleFrameSpectrum(*plan, window, psd_scale_factor,
+                            std::span(samples[c]).subspan(pending, n),
+                            spectra.fft[c], spectra.power[c]);
+      });
+      co_yield std::move(spectra);
+      pending += options.hop_size == 0 ? n : options.hop_size;
+    }
+    if (pending >= samples.front().size() / 2) {
+      for (std::vector<std::int16_t>& channel : samples) {
+        channel.erase(channel.begin(), channel.begin() + pending);
+      }
+      discarded += pending;
+      pending = 0;
+    }
+  }
+}
+
+void ResampleSpectrum(std::span<const double> in, std::span<double> out) {
+  if (in.size() == out.size()) {
+    std::ranges::copy(in, out.begin());
+    return;
+  }
+  if (in.size() == 1 || out.size() == 1) {
+    std::ranges::fill(out, std::ranges::max(in));
+    return;
+  }
+  // Input bins per output bin.
+  const double ratio = double(in.size() - 1) / (out.size() - 1);
+  const std::size_t last = in.size() - 1;
+  for (std::size_t j = 0; j < out.size(); ++j) {
+    const double x = j * ratio;
+    if (ratio > 1) {
+      const auto first = static_cast<std::size_t>(
+          std::max(0.0, std::ceil(x - ratio / 2)));
+      const auto end = std::min(
+          last + 1, static_cast<std::size_t>(std::floor(x + ratio / 2)) + 1);
+      out[j] = *std::max_element(in.begin() + first, in.begin() + end);
+    } else {
+      const auto i = std::min(static_cast<std::size_t>(x), last - 1);
+      const double t = x - i;
+      out[j] = (1 - t) * in[i] + t * in[i + 1];
+    }
   }
 }
@@ -1,23 +1,100 @@
 #pragma once
 
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <atomic>
+#include <complex>
 #include <cstdint>
+#include <span>
 #include <vector>
 
 #include "diy/buffer.h"
 #include "diy/coro/async_generator.h"
+#include "diy/worker_pool.h"
+#include "fft_plan.h"
+#include "spectrum_kernel.h"
 
 std::vector<double> FrequencyBins(std::size_t n, double fs);
 
-enum class WindowFunction {
-  kRectangular,
-  kHann,
-};
-
 struct SpectrumOptions {
   double sample_rate = 24'000;
   std::size_t window_size = 2048;
   WindowFunction window_function = WindowFunction::kRectangular;
+  // Number of samples between the starts of consecutive windows. Zero means
+  // `window_size`, i.e. non-overlapping windows.
+  std::size_t hop_size = 0;
+};
+
+// SpectrumOptions of a running PowerSpectrum() stage, which may be changed from
+// other threads. Changes take effect from the next output spectrum onwards.
+class SpectrumConfig {
+ public:
+  // Throws std::invalid_argument if `options` are invalid.
+  explicit SpectrumConfig(const SpectrumOptions& options);
+
+  // Throws std::invalid_argument if `options` are invalid, in which case the
+  // current options are kept. May be called from any thread.
+  void Set(const SpectrumOptions& options) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  SpectrumOptions Get() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Incremented by every Set(), so that readers can cheaply detect changes.
+  std::uint64_t version() const noexcept {
+    return version_.load(std::memory_order_acquire);
+  }
+
+ private:
+  mutable absl::Mutex mutex_;
+  SpectrumOptions options_ ABSL_GUARDED_BY(mutex_);
+  std::atomic<std::uint64_t> version_ = 0;
 };
 
 AsyncGenerator<Buffer<double>> PowerSpectrum(
     SpectrumOptions options, AsyncGenerator<Buffer<std::int16_t>> source);
+
+// As above, but follows changes to `config`, which must outlive the returned
+// generator. The length of each output spectrum reflects the window size it
+// was computed with. Plans and window tables are cached, so switching back to
+// earlier options is cheap.
+AsyncGenerator<Buffer<double>> PowerSpectrum(
+    const SpectrumConfig& config, AsyncGenerator<Buffer<std::int16_t>> source);
+
+// As above, but with plans from `plans`, which must outlive the returned
+// generator.
+AsyncGenerator<Buffer<double>> PowerSpectrum(
+    const SpectrumConfig& config, FftPlanCache& plans,
+    AsyncGenerator<Buffer<std::int16_t>> source);
+
+// Spectra of one window of every channel.
+struct ChannelSpectra {
+  // Complex FFT of each windowed channel, with window_size bins.
+  std::vector<Buffer<std::complex<double>>> fft;
+  // One-sided PSD of each channel, as output by PowerSpectrum().
+  std::vector<Buffer<double>> power;
+  // First sample of the window and the sample just past its end, counting
+  // each channel's samples from the start of the stream.
+  std::int64_t window_start = 0;
+  std::int64_t window_end = 0;
+};
+
+// Spectra of each channel of `source`, whose items hold one buffer of samples
+// per channel, as produced by Deinterleaved(). Every channel uses the same
+// options and windows, and the channels of each window are transformed across
+// `pool`. Throws std::invalid_argument if the number of channels changes, or if
+// the channels of an item differ in length. `config`, `plans` and `pool` must
+// outlive the returned generator.
+AsyncGenerator<ChannelSpectra> MultichannelSpectra(
+    const SpectrumConfig& config, FftPlanCache& plans, WorkerPool& pool,
+    AsyncGenerator<std::vector<Buffer<std::int16_t>>> source);
+
+// As above, but only the power spectra.
+AsyncGenerator<std::vector<Buffer<double>>> MultichannelPowerSpectrum(
+    const SpectrumConfig& config, FftPlanCache& plans, WorkerPool& pool,
+    AsyncGenerator<std::vector<Buffer<std::int16_t>>> source);
+
+// Resamples a one-sided PSD spanning DC to Nyquist onto `out`, which spans the
+// same frequency range with a different number of bins. Downsampling keeps the
+// peak of the input bins that map to each output bin, so that narrow tones
+// remain visible; upsampling interpolates linearly.
+void ResampleSpectrum(std::span<const double> in, std::span<double> out);
@@ -0,0 +1,147 @@
+#include "spectrum_kernel.h"
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <numbers>
+#include <utility>
+
+namespace {
+
+// cos(2πi/n), evaluable at compile time.
+constexpr double CosTurn(std::size_t i, std::size_t n) {
+  // Reduce the angle to [0, π/2], where the Taylor series below converges to
+  // full precision.
+  i %= n;
+  if (2 * i > n) {
+    i = n - i;
+  }
+  double sign = 1;
+  if (4 * i > n) {
+    // cos(π - x) = -cos(x)
+    i = n - 2 * i;
+    n *= 2;
+    sign = -1;
+  }
+  const double x = 2 * std::numbers::pi * i / n;
+  double term = 1;
+  double sum = 1;
+  for (int k = 1; k <= 15; ++k) {
+    term *= -x * x / ((2 * k - 1) * (2 * k));
+    sum += term;
+  }
+  return sign * sum;
+}
+
+template <std::size_t N>
+constexpr std::array<double, N> HannWindow() {
+  std::array<double, N> window;
+  for (std::size_t i = 0; i < N; ++i) {
+    // sin²(πi/N)
+    window[i] = (1 - CosTurn(i, N)) / 2;
+  }
+  return window;
+}
+
+template <std::size_t N>
+constexpr std::array<double, N> kHannWindow = HannWindow<N>();
+
+void GenericApplyWindow(std::span<const std::int16_t> samples,
+                        std::span<const double> window,
+                        std::span<std::complex<double>> out) {
+  assert(samples.size() == window.size() && samples.size() == out.size());
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    out[i] = window[i] * samples[i];
+  }
+}
+
+void GenericPower(std::span<const std::complex<double>> spectrum,
+                  double psd_scale_factor, std::span<double> out) {
+  const std::size_t nyquist_index = spectrum.size() / 2;
+  assert(out.size() == nyquist_index + 1);
+  // DC and Nyquist bins are the only bins that don't have a conjugate pair.
+  out[0] = psd_scale_factor * std::norm(spectrum[0]);
+  for (std::size_t i = 1; i < nyquist_index; ++i) {
+    out[i] = 2 * psd_scale_factor * std::norm(spectrum[i]);
+  }
+  out[nyquist_index] = psd_scale_factor * std::norm(spectrum[nyquist_index]);
+}
+
+// The fixed kernels work on the interleaved real and imaginary parts directly,
+// which std::complex explicitly allows, so that the loops are plain arithmetic
+// on doubles.
+
+template <std::size_t N, WindowFunction F>
+void FixedApplyWindow(std::span<const std::int16_t> samples,
+                      std::span<const double> /*window*/,
+                      std::span<std::complex<double>> out) {
+  assert(samples.size() == N && out.size() == N);
+  const std::int16_t* __restrict in = samples.data();
+  double* __restrict parts = reinterpret_cast<double*>(out.data());
+  for (std::size_t i = 0; i < N; ++i) {
+    if constexpr (F == WindowFunction::kHann) {
+      parts[2 * i] = kHannWindow<N>[i] * in[i];
+    } else {
+      parts[2 * i] = in[i];
+    }
+    parts[2 * i + 1] = 0;
+  }
+}
+
+template <std::size_t N>
+void FixedPower(std::span<const std::complex<double>> spectrum,
+                double psd_scale_factor, std::span<double> out) {
+  assert(spectrum.size() == N && out.size() == N / 2 + 1);
+  const double* __restrict parts =
+      reinterpret_cast<const double*>(spectrum.data());
+  double* __restrict power = out.data();
+  const double conjugate_scale_factor = 2 * psd_scale_factor;
+  for (std::size_t i = 0; i <= N / 2; ++i) {
+    const double re = parts[2 * i];
+    const double im = parts[2 * i + 1];
+    power[i] = conjugate_scale_factor * (re * re + im * im);
+  }
+  power[0] /= 2;
+  power[N / 2] /= 2;
+}
+
+constexpr std::size_t kFixedSizeCount =
+    std::countr_zero(kMaxFixedSpectrumSize) -
+    std::countr_zero(kMinFixedSpectrumSize) + 1;
+
+// Kernels for window function `F`, indexed by log2(n / kMinFixedSpectrumSize).
+template <WindowFunction F, std::size_t... I>
+constexpr std::array<SpectrumKernel, sizeof...(I)> FixedKernels(
+    std::index_sequence<I...>) {
+  return {{{&FixedApplyWindow<(kMinFixedSpectrumSize << I), F>,
+            &FixedPower<(kMinFixedSpectrumSize << I)>}...}};
+}
+
+constexpr auto kRectangularKernels =
+    FixedKernels<WindowFunction::kRectangular>(
+        std::make_index_sequence<kFixedSizeCount>());
+constexpr auto kHannKernels = FixedKernels<WindowFunction::kHann>(
+    std::make_index_sequence<kFixedSizeCount>());
+
+constexpr SpectrumKernel kGenericKernel = {&GenericApplyWindow, &GenericPower};
+
+}  // namespace
+
+const SpectrumKernel& SelectSpectrumKernel(std::size_t n,
+                                           WindowFunction window_function) {
+  if (!std::has_single_bit(n) || n < kMinFixedSpectrumSize ||
+      n > kMaxFixedSpectrumSize) {
+    return kGenericKernel;
+  }
+  const std::size_t index =
+      std::countr_zero(n) - std::countr_zero(kMinFixedSpectrumSize);
+  switch (window_function) {
+    case WindowFunction::kRectangular:
+      return kRectangularKernels[index];
+    case WindowFunction::kHann:
+      return kHannKernels[index];
+  }
+  return kGenericKernel;
+}
+
+const SpectrumKernel& GenericSpectrumKernel() { return kGenericKernel; }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <span>
+
+enum class WindowFunction {
+  kRectangular,
+  kHann,
+};
+
+// The stages of a power spectrum computation around the FFT itself.
+//
+// Power-of-two sizes from kMinFixedSpectrumSize to kMaxFixedSpectrumSize have
+// kernels specialized at compile time, with constexpr window tables and
+// fixed-length loops. Other sizes use a generic kernel.
+struct SpectrumKernel {
+  // Multiplies `samples` by the window function and writes the result to `out`
+  // as FFT input. All spans have the same size. `window` holds the window
+  // function's values; specialized kernels use their own copy instead.
+  void (*apply_window)(std::span<const std::int16_t> samples,
+                       std::span<const double> window,
+                       std::span<std::complex<double>> out);
+
+  // Writes the one-sided PSD of FFT output `spectrum` to `out`, which has
+  // spectrum.size() / 2 + 1 elements. Bins other than DC and Nyquist include
+  // the power of their negative-frequency conjugate.
+  void (*power)(std::span<const std::complex<double>> spectrum,
+                double psd_scale_factor, std::span<double> out);
+};
+
+inline constexpr std::size_t kMinFixedSpectrumSize = 256;
+inline constexpr std::size_t kMaxFixedSpectrumSize = 8192;
+
+// Kernel for spectra of `n` samples, specialized if possible.
+const SpectrumKernel& SelectSpectrumKernel(std::size_t n,
+                                           WindowFunction window_function);
+
+// Kernel that supports any even size.
+const SpectrumKernel& GenericSpectrumKernel();
@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "spectrum_kernel.h"
+
+// Window and power stages of a Hann-windowed spectrum of `n` samples, with the
+// generic kernel (fixed=0) or the kernel specialized for `n` (fixed=1).
+static void BM_Kernel(benchmark::State& state) {
+  const std::size_t n = state.range(0);
+  const SpectrumKernel& kernel =
+      state.range(1) ? SelectSpectrumKernel(n, WindowFunction::kHann)
+                     : GenericSpectrumKernel();
+  std::vector<double> window(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const double w = std::sin(std::numbers::pi * i / n);
+    window[i] = w * w;
+  }
+  std::mt19937 rng{std::random_device{}()};
+  std::uniform_int_distribution<std::int16_t> distribution;
+  std::vector<std::int16_t> samples(n);
+  std::ranges::generate(samples, [&] { return distribution(rng); });
+  std::vector<std::complex<double>> spectrum(n);
+  std::vector<double> power(n / 2 + 1);
+
+  for (auto _ : state) {
+    kernel.apply_window(samples, window, spectrum);
+    kernel.power(spectrum, 1e-3, power);
+    benchmark::DoNotOptimize(power.data());
+  }
+  state.SetItemsProcessed(n * state.iterations());
+}
+BENCHMARK(BM_Kernel)
+    ->ArgNames({"n", "fixed"})
+    ->ArgsProduct({benchmark::CreateRange(256, 8192, /*multi=*/2), {0, 1}});
@@ -0,0 +1,74 @@
+#include "spectrum_kernel.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using testing::Combine;
+using testing::Values;
+
+TEST(SpectrumKernelTest, Dispatch) {
+  const SpectrumKernel* generic = &GenericSpectrumKernel();
+  EXPECT_NE(&SelectSpectrumKernel(256, WindowFunction::kHann), generic);
+  EXPECT_NE(&SelectSpectrumKernel(8192, WindowFunction::kRectangular), generic);
+  EXPECT_NE(&SelectSpectrumKernel(1024, WindowFunction::kHann),
+            &SelectSpectrumKernel(1024, WindowFunction::kRectangular));
+  EXPECT_NE(&SelectSpectrumKernel(1024, WindowFunction::kHann),
+            &SelectSpectrumKernel(2048, WindowFunction::kHann));
+
+  EXPECT_EQ(&SelectSpectrumKernel(128, WindowFunction::kHann), generic);
+  EXPECT_EQ(&SelectSpectrumKernel(16384, WindowFunction::kHann), generic);
+  EXPECT_EQ(&SelectSpectrumKernel(2028, WindowFunction::kHann), generic);
+}
+
+class FixedSpectrumKernelTest
+    : public testing::TestWithParam<std::tuple<std::size_t, WindowFunction>> {
+};
+
+// Specialized kernels match the generic kernel.
+TEST_P(FixedSpectrumKernelTest, MatchesGeneric) {
+  const auto [n, window_function] = GetParam();
+  std::vector<double> window(n, 1);
+  if (window_function == WindowFunction::kHann) {
+    for (std::size_t i = 0; i < n; ++i) {
+      const double w = std::sin(std::numbers::pi * i / n);
+      window[i] = w * w;
+    }
+  }
+  std::mt19937 rng(n);
+  std::uniform_int_distribution<std::int16_t> distribution;
+  std::vector<std::int16_t> samples(n);
+  for (std::int16_t& s : samples) {
+    s = distribution(rng);
+  }
+
+  const SpectrumKernel& generic = GenericSpectrumKernel();
+  const SpectrumKernel& fixed = SelectSpectrumKernel(n, window_function);
+  ASSERT_NE(&fixed, &generic);
+
+  std::vector<std::complex<double>> expected_windowed(n);
+  std::vector<std::complex<double>> windowed(n);
+  generic.apply_window(samples, window, expected_windowed);
+  fixed.apply_window(samples, window, windowed);
+  for (std::size_t i = 0; i < n; ++i) {
+    EXPECT_NEAR(windowed[i].real(), expected_windowed[i].real(), 1e-9) << i;
+    EXPECT_EQ(windowed[i].imag(), 0) << i;
+  }
+
+  // The power stage doesn't care whether its input is an actual spectrum.
+  std::vector<double> expected_power(n / 2 + 1);
+  std::vector<double> power(n / 2 + 1);
+  generic.power(expected_windowed, 0.25, expected_power);
+  fixed.power(expected_windowed, 0.25, power);
+  EXPECT_EQ(power, expected_power);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Sizes, FixedSpectrumKernelTest,
+    Combine(Values(256, 512, 1024, 2048, 4096, 8192),
+            Values(WindowFunction::kRectangular, WindowFunction::kHann)));
@@ -4,9 +4,14 @@
 #include <gtest/gtest.h>
 
 #include <ranges>
+#include <utility>
+#include <vector>
 
+using testing::DoubleNear;
+using testing::Each;
 using testing::ElementsAre;
 using testing::IsNull;
+using testing::Pair;
 using testing::Pointee;
 using testing::SizeIs;
 
@@ -77,6 +82,17 @@ TEST(SpectrumTest, Sine) {
   EXPECT_THAT(gen.Wait(), IsNull());
 }
 
+// Uses a specialized kernel.
+TEST(SpectrumTest, FixedSizeDc) {
+  auto gen =
+      PowerSpectrum({.sample_rate = 2, .window_size = 256},
+                    SingleFrameSource(std::vector<std::int16_t>(256, 1)));
+  Buffer<double>* spectrum = gen.Wait();
+  ASSERT_THAT(spectrum, Pointee(SizeIs(129)));
+  EXPECT_DOUBLE_EQ(spectrum->front(), 64);
+  EXPECT_THAT(spectrum->span().subspan(1), Each(DoubleNear(0, 1e-9)));
+}
+
 TEST(SpectrumTest, MergesFrames) {
   auto gen = PowerSpectrum(
       {.sample_rate = 2, .window_size = 4},
@@ -108,6 +124,160 @@ TEST(SpectrumTest, TruncatedInput) {
   EXPECT_THAT(gen.Wait(), IsNull());
 }
 
+TEST(SpectrumTest, OverlappingWindows) {
+  auto gen = PowerSpectrum({.sample_rate = 2, .window_size = 4, .hop_size = 2},
+                           SingleFrameSource({1, 1, 1, 1, 1, -1, 1, -1}));
+  EXPECT_THAT(gen.Wait(), Pointee(ElementsAre(1, 0, 0)));
+  EXPECT_THAT(gen.Wait(), Pointee(ElementsAre(0.25, 0.5, 0.25)));
+  EXPECT_THAT(gen.Wait(), Pointee(ElementsAre(0, 0, 1)));
+  EXPECT_THAT(gen.Wait(), IsNull());
+}
+
+TEST(SpectrumTest, HopSizeLargerThanWindowThrowsError) {
+  auto gen = PowerSpectrum({.sample_rate = 2, .window_size = 4, .hop_size = 6},
+                           SingleFrameSource({0}));
+  EXPECT_THROW(gen.Wait(), std::invalid_argument);
+}
+
+TEST(SpectrumTest, Reconfigure) {
+  SpectrumConfig config({.sample_rate = 2, .window_size = 4});
+  auto gen = PowerSpectrum(
+      config, SingleFrameSource({1, 1, 1, 1, 1, -1, 1, -1, 1, -1}));
+  EXPECT_THAT(gen.Wait(), Pointee(ElementsAre(1, 0, 0)));
+
+  config.Set({.sample_rate = 2, .window_size = 2});
+  EXPECT_THAT(gen.Wait(), Pointee(ElementsAre(0, 0.5)));
+
+  config.Set({.sample_rate = 2, .window_size = 4});
+  EXPECT_THAT(gen.Wait(), Pointee(ElementsAre(0, 0, 1)));
+  EXPECT_THAT(gen.Wait(), IsNull());
+}
+
+AsyncGenerator<std::vector<Buffer<std::int16_t>>> MultichannelSource(
+    std::vector<std::vector<std::vector<std::int16_t>>> frames) {
+  for (const auto& frame : frames) {
+    std::vector<Buffer<std::int16_t>> channels;
+    for (const auto& channel : frame) {
+      channels.push_back(AdoptAsBuffer(channel));
+    }
+    co_yield std::move(channels);
+  }
+}
+
+TEST(MultichannelSpectrumTest, ChannelsAreIndependent) {
+  SpectrumConfig config({.sample_rate = 2, .window_size = 4});
+  FftPlanCache plans;
+  WorkerPool pool(2);
+  auto gen = MultichannelPowerSpectrum(
+      config, plans, pool,
+      MultichannelSource({{{1, 1}, {1, -1}, {0, 0}},
+                          {{1, 1, 1, -1, 1, -1},
+                           {1, -1, 1, 1, 1, 1},
+                           {0, 0, 0, 0, 0, 0}}}));
+  auto* spectra = gen.Wait();
+  ASSERT_NE(spectra, nullptr);
+  ASSERT_THAT(*spectra, SizeIs(3));
+  EXPECT_THAT((*spectra)[0], ElementsAre(1, 0, 0));
+  EXPECT_THAT((*spectra)[1], ElementsAre(0, 0, 1));
+  EXPECT_THAT((*spectra)[2], ElementsAre(0, 0, 0));
+  spectra = gen.Wait();
+  ASSERT_NE(spectra, nullptr);
+  EXPECT_THAT((*spectra)[0], ElementsAre(0, 0, 1));
+  EXPECT_THAT((*spectra)[1], ElementsAre(1, 0, 0));
+  EXPECT_THAT((*spectra)[2], ElementsAre(0, 0, 0));
+  EXPECT_THAT(gen.Wait(), IsNull());
+}
+
+TEST(MultichannelSpectrumTest, KeepsComplexSpectra) {
+  SpectrumConfig config({.sample_rate = 2, .window_size = 4});
+  FftPlanCache plans;
+  WorkerPool pool(1);
+  auto gen =
+      MultichannelSpectra(config, plans, pool,
+                          MultichannelSource({{{1, 1, 1, 1}, {1, -1, 1, -1}}}));
+  auto* spectra = gen.Wait();
+  ASSERT_NE(spectra, nullptr);
+  ASSERT_THAT(spectra->fft, SizeIs(2));
+  ASSERT_THAT(spectra->power, SizeIs(2));
+  for (std::size_t c = 0; c < 2; ++c) {
+    EXPECT_THAT(spectra->fft[c], SizeIs(4));
+    EXPECT_THAT(spectra->power[c], SizeIs(3));
+  }
+}
+
+TEST(MultichannelSpectrumTest, WindowSampleRange) {
+  SpectrumConfig config({.sample_rate = 2, .window_size = 4, .hop_size = 2});
+  FftPlanCache plans;
+  WorkerPool pool(0);
+  const std::vector<std::int16_t> samples(4);
+  auto gen = MultichannelSpectra(
+      config, plans, pool,
+      MultichannelSource({{samples}, {samples}, {samples}, {samples}}));
+  std::vector<std::pair<std::int64_t, std::int64_t>> windows;
+  while (ChannelSpectra* spectra = gen.Wait()) {
+    windows.emplace_back(spectra->window_start, spectra->window_end);
+    if (windows.size() == 2) {
+      // The next window still starts one old hop later.
+      config.Set({.sample_rate = 2, .window_size = 4, .hop_size = 4});
+    }
+  }
+  EXPECT_THAT(windows, ElementsAre(Pair(0, 4), Pair(2, 6), Pair(4, 8),
+                                   Pair(8, 12), Pair(12, 16)));
+}
+
+TEST(MultichannelSpectrumTest, MismatchedLengthsThrow) {
+  SpectrumConfig config({.sample_rate = 2, .window_size = 4});
+  FftPlanCache plans;
+  WorkerPool pool(0);
+  auto gen = MultichannelPowerSpectrum(config, plans, pool,
+                                       MultichannelSource({{{1, 1}, {1}}}));
+  EXPECT_THROW(gen.Wait(), std::invalid_argument);
+}
+
+TEST(MultichannelSpectrumTest, ChannelCountChangeThrows) {
+  SpectrumConfig config({.sample_rate = 2, .window_size = 4});
+  FftPlanCache plans;
+  WorkerPool pool(0);
+  auto gen = MultichannelPowerSpectrum(
+      config, plans, pool, MultichannelSource({{{1, 1}, {1, 1}}, {{1, 1}}}));
+  EXPECT_THROW(gen.Wait(), std::invalid_argument);
+}
+
+TEST(SpectrumConfigTest, InvalidOptionsAreRejected) {
+  SpectrumConfig config({.window_size = 4});
+  EXPECT_THROW(config.Set({.window_size = 3}), std::invalid_argument);
+  EXPECT_THROW(config.Set({.window_size = 4, .hop_size = 8}),
+               std::invalid_argument);
+  EXPECT_EQ(config.version(), 0);
+  EXPECT_EQ(config.Get().window_size, 4);
+
+  config.Set({.window_size = 8, .hop_size = 2});
+  EXPECT_EQ(config.version(), 1);
+  EXPECT_EQ(config.Get().window_size, 8);
+  EXPECT_EQ(config.Get().hop_size, 2);
+}
+
+TEST(ResampleSpectrumTest, SameSize) {
+  const std::vector<double> in = {1, 2, 3};
+  std::vector<double> out(3);
+  ResampleSpectrum(in, out);
+  EXPECT_THAT(out, ElementsAre(1, 2, 3));
+}
+
+TEST(ResampleSpectrumTest, DownsampleKeepsPeaks) {
+  const std::vector<double> in = {0, 0, 0, 5, 0, 0, 0, 0, 7};
+  std::vector<double> out(3);
+  ResampleSpectrum(in, out);
+  EXPECT_THAT(out, ElementsAre(0, 5, 7));
+}
+
+TEST(ResampleSpectrumTest, UpsampleInterpolates) {
+  const std::vector<double> in = {0, 4, 8};
+  std::vector<double> out(5);
+  ResampleSpectrum(in, out);
+  EXPECT_THAT(out, ElementsAre(0, 2, 4, 6, 8));
+}
+
 TEST(BinsTest, EvenSize) {
   EXPECT_THAT(FrequencyBins(10, 1000), ElementsAre(0, 100, 200, 300, 400, 500));
 }
@@ -0,0 +1,182 @@
+#include "tone_bank.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <stdexcept>
+
+namespace {
+// Longest run of samples applied to the filters at once, which bounds the
+// scratch buffers for long output intervals.
+constexpr std::size_t kMaxRun = 4096;
+
+constexpr std::size_t kLanes = 4;
+
+// Filters are updated in pairs of AVX2 vectors.
+std::size_t Padded(std::size_t n) {
+  return (n + 2 * kLanes - 1) / (2 * kLanes) * (2 * kLanes);
+}
+}  // namespace
+
+ToneBank::ToneBank(double sample_rate, std::span<const double> frequencies,
+                   ToneBankOptions options)
+    : sample_rate_(sample_rate),
+      options_(options),
+      tones_(frequencies.size()),
+      sum_re_(Padded(tones_)),
+      sum_im_(Padded(tones_)),
+      rotation_re_(Padded(tones_)),
+      rotation_im_(Padded(tones_)),
+      removal_re_(Padded(tones_)),
+      removal_im_(Padded(tones_)),
+      window_(options.window_size),
+      until_output_(options.output_interval),
+      amplitudes_(tones_) {
+  if (frequencies.empty()) {
+    throw std::invalid_argument("No tones to track.");
+  }
+  if (options_.window_size == 0 || options_.output_interval == 0) {
+    throw std::invalid_argument(
+        "Window size and output interval must be positive.");
+  }
+  if (options_.channel >= options_.channels) {
+    throw std::invalid_argument("Tracked channel out of range.");
+  }
+  for (std::size_t k = 0; k < tones_; ++k) {
+    const double frequency = frequencies[k];
+    if (!(frequency > 0 && frequency < sample_rate_ / 2)) {
+      throw std::invalid_argument("Tone frequency out of range.");
+    }
+    const std::complex<double> rotation =
+        std::polar(1.0, 2 * std::numbers::pi * frequency / sample_rate_);
+    // Raised to the window size by the same multiplications that rotate each
+    // sample's contribution, so that it cancels when it leaves the window.
+    std::complex<double> removal = 1;
+    for (std::size_t i = 0; i < options_.window_size; ++i) {
+      removal *= rotation;
+    }
+    rotation_re_[k] = rotation.real();
+    rotation_im_[k] = rotation.imag();
+    removal_re_[k] = removal.real();
+    removal_im_[k] = removal.imag();
+  }
+}
+
+void ToneBank::Gather(std::span<const std::int16_t> samples, std::size_t n) {
+  if (added_.size() < n) {
+    added_.resize(n);
+    removed_.resize(n);
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    const double sample = samples[i * options_.channels + options_.channel];
+    added_[i] = sample;
+    removed_[i] = window_[window_position_];
+    window_[window_position_] = sample;
+    if (++window_position_ == window_.size()) {
+      window_position_ = 0;
+    }
+  }
+}
+
+void ToneBank::Advance(std::size_t n) {
+  const std::size_t filters = sum_re_.size();
+  std::size_t f = 0;
+#ifdef __AVX2__
+  // Two groups of four filters stay in registers for the whole run, so that
+  // each group's updates overlap the latency of the other's.
+  struct Group {
+    __m256d c_re, c_im, d_re, d_im, re, im;
+  };
+  auto load = [&](std::size_t first) {
+    return Group{.c_re = _mm256_loadu_pd(rotation_re_.data() + first),
+                 .c_im = _mm256_loadu_pd(rotation_im_.data() + first),
+                 .d_re = _mm256_loadu_pd(removal_re_.data() + first),
+                 .d_im = _mm256_loadu_pd(removal_im_.data() + first),
+                 .re = _mm256_loadu_pd(sum_re_.data() + first),
+                 .im = _mm256_loadu_pd(sum_im_.data() + first)};
+  };
+  auto store = [&](std::size_t first, const Group& g) {
+    _mm256_storeu_pd(sum_re_.data() + first, g.re);
+    _mm256_storeu_pd(sum_im_.data() + first, g.im);
+  };
+  // S = c S + x - d y
+  auto update = [](Group& g, __m256d x, __m256d y) {
+    const __m256d re = _mm256_fmadd_pd(
+        g.c_re, g.re,
+        _mm256_fnmadd_pd(g.c_im, g.im, _mm256_fnmadd_pd(g.d_re, y, x)));
+    g.im = _mm256_fmadd_pd(
+        g.c_re, g.im, _mm256_fnmadd_pd(g.d_im, y, _mm256_mul_pd(g.c_im, g.re)));
+    g.re = re;
+  };
+  for (; f < filters; f += 2 * kLanes) {
+    Group a = load(f);
+    Group b = load(f + kLanes);
+    for (std::size_t i = 0; i < n; ++i) {
+      const __m256d x = _mm256_broadcast_sd(&added_[i]);
+      const __m256d y = _mm256_broadcast_sd(&removed_[i]);
+      update(a, x, y);
+      update(b, x, y);
+    }
+    store(f, a);
+    store(f + kLanes, b);
+  }
+#endif
+  for (; f < filters; ++f) {
+    const std::complex<double> c(rotation_re_[f], rotation_im_[f]);
+    const std::complex<double> d(removal_re_[f], removal_im_[f]);
+    std::complex<double> sum(sum_re_[f], sum_im_[f]);
+    for (std::size_t i = 0; i < n; ++i) {
+      sum = c * sum + added_[i] - d * removed_[i];
+    }
+    sum_re_[f] = sum.real();
+    sum_im_[f] = sum.imag();
+  }
+}
+
+void ToneBank::Process(
+    std::span<const std::int16_t> samples,
+    absl::FunctionRef<void(absl::Duration, std::span<const double>)> output) {
+  assert(samples.size() % options_.channels == 0);
+  const std::size_t frames = samples.size() / options_.channels;
+  // A sinusoid of amplitude A contributes about A N / 2 to its filter.
+  const double scale = 2.0 / options_.window_size;
+  for (std::size_t i = 0; i < frames;) {
+    const std::size_t n = std::min({frames - i, until_output_, kMaxRun});
+    Gather(samples.subspan(i * options_.channels), n);
+    Advance(n);
+    i += n;
+    samples_ += n;
+    until_output_ -= n;
+    if (until_output_ > 0) {
+      continue;
+    }
+    until_output_ = options_.output_interval;
+    for (std::size_t k = 0; k < tones_; ++k) {
+      amplitudes_[k] = scale * std::hypot(sum_re_[k], sum_im_[k]);
+    }
+    output(absl::Seconds(samples_) / sample_rate_, amplitudes_);
+  }
+}
+
+AsyncGenerator<ToneFrame> TrackTones(
+    double sample_rate, std::vector<double> frequencies,
+    ToneBankOptions options, AsyncGenerator<Buffer<std::int16_t>> source) {
+  ToneBank bank(sample_rate, frequencies, options);
+  std::vector<ToneFrame> frames;
+  while (Buffer<std::int16_t>* samples = co_await source) {
+    bank.Process(samples->span(), [&](absl::Duration timestamp,
+                                      std::span<const double> amplitudes) {
+      auto copy = Buffer<double>::Uninitialized(amplitudes.size());
+      std::ranges::copy(amplitudes, copy.span().begin());
+      frames.push_back({.timestamp = timestamp, .amplitudes = std::move(copy)});
+    });
+    for (ToneFrame& frame : frames) {
+      co_yield std::move(frame);
+    }
+    frames.clear();
+  }
+}
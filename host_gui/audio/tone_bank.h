@@ -0,0 +1,96 @@
+#pragma once
+
+#include <absl/functional/function_ref.h>
+#include <absl/time/time.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "diy/buffer.h"
+#include "diy/coro/async_generator.h"
+
+struct ToneBankOptions {
+  // Length of the sliding rectangular window, in samples. Tones closer than
+  // sample_rate / window_size leak into each other's amplitudes.
+  std::size_t window_size = 1024;
+  // Samples between outputs. Each output covers the latest window, so outputs
+  // may be as frequent as every sample.
+  std::size_t output_interval = 64;
+  // Input buffers hold interleaved frames of `channels` samples, of which only
+  // `channel` is tracked.
+  std::size_t channels = 1;
+  std::size_t channel = 0;
+};
+
+// Amplitudes of the tracked tones over the window ending at `timestamp`.
+struct ToneFrame {
+  // End of the window, from the start of the stream.
+  absl::Duration timestamp;
+  // Amplitude of each tone, in sample units, in the order of the tone
+  // frequencies.
+  Buffer<double> amplitudes;
+};
+
+// Bank of sliding DFT filters, each tracking the amplitude of one tone over a
+// window of the most recent samples. Each sample updates every filter in
+// O(1) time, which for a few dozen tones is much cheaper than a full spectrum
+// per output.
+//
+// Each filter computes S(n) = c S(n-1) + x(n) - c^N x(n-N), the DFT of the
+// last N samples at the tone's frequency, where c rotates by the tone's phase
+// increment per sample. Because the frequencies needn't be multiples of the
+// bin width, both c and c^N are kept per filter. Filters are updated eight at
+// a time with AVX2, across each run of samples between outputs.
+class ToneBank {
+ public:
+  // Throws std::invalid_argument if `frequencies` is empty or has frequencies
+  // outside (0, sample_rate / 2), or if `options` are invalid.
+  ToneBank(double sample_rate, std::span<const double> frequencies,
+           ToneBankOptions options = {});
+
+  // Feeds the interleaved frames `samples`, and calls `output` with the
+  // window's end and the tone amplitudes every `output_interval` samples.
+  // Before the first `window_size` samples, the window is padded with
+  // silence.
+  void Process(std::span<const std::int16_t> samples,
+               absl::FunctionRef<void(absl::Duration timestamp,
+                                      std::span<const double> amplitudes)>
+                   output);
+
+  std::size_t tones() const { return tones_; }
+
+ private:
+  // Copies the next `n` samples of the tracked channel from `samples` into
+  // `added_`, and the samples they push out of the window into `removed_`.
+  void Gather(std::span<const std::int16_t> samples, std::size_t n);
+  // Applies the first `n` samples of `added_` and `removed_` to all filters.
+  void Advance(std::size_t n);
+
+  const double sample_rate_;
+  const ToneBankOptions options_;
+  const std::size_t tones_;
+  // Per-filter state and coefficients, split into real and imaginary parts
+  // and padded to a multiple of eight filters.
+  std::vector<double> sum_re_;
+  std::vector<double> sum_im_;
+  std::vector<double> rotation_re_;
+  std::vector<double> rotation_im_;
+  std::vector<double> removal_re_;
+  std::vector<double> removal_im_;
+  // Last `window_size` samples, oldest at `window_position_`.
+  std::vector<double> window_;
+  std::size_t window_position_ = 0;
+  std::vector<double> added_;
+  std::vector<double> removed_;
+  std::int64_t samples_ = 0;
+  std::size_t until_output_;
+  std::vector<double> amplitudes_;
+};
+
+// Tracks the amplitudes of `frequencies` in a stream of interleaved frames,
+// yielding a ToneFrame every `options.output_interval` samples.
+AsyncGenerator<ToneFrame> TrackTones(
+    double sample_rate, std::vector<double> frequencies,
+    ToneBankOptions options, AsyncGenerator<Buffer<std::int16_t>> source);
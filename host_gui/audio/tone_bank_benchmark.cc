@@ -0,0 +1,28 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "tone_bank.h"
+
+// Per input sample, for a bank of `n` tones with an output every 64 samples.
+static void BM_ToneBank(benchmark::State& state) {
+  const std::size_t tones = state.range(0);
+  std::vector<double> frequencies(tones);
+  for (std::size_t k = 0; k < tones; ++k) {
+    frequencies[k] = 100 + 200 * k;
+  }
+  std::mt19937 rng{std::random_device{}()};
+  std::uniform_int_distribution<int> distribution(-32768, 32767);
+  std::vector<std::int16_t> samples(240);
+  std::ranges::generate(samples, [&] { return distribution(rng); });
+  ToneBank bank(24'000, frequencies);
+  for (auto _ : state) {
+    bank.Process(samples, [](absl::Duration, std::span<const double> a) {
+      benchmark::DoNotOptimize(a.data());
+    });
+  }
+  state.SetItemsProcessed(samples.size() * state.iterations());
+}
+BENCHMARK(BM_ToneBank)->Arg(8)->Arg(16)->Arg(32)->Arg(50);
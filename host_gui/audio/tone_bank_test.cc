@@ -0,0 +1,164 @@
+#include "tone_bank.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "diy/coro/task.h"
+
+using testing::DoubleNear;
+using testing::ElementsAre;
+using testing::SizeIs;
+
+namespace {
+// Windows of 80 samples, i.e. DFT bins 100 Hz apart.
+constexpr double kSampleRate = 8'000;
+constexpr ToneBankOptions kOptions = {.window_size = 80,
+                                      .output_interval = 80};
+
+std::vector<std::int16_t> Sinusoid(double frequency, double amplitude,
+                                   std::size_t n) {
+  std::vector<std::int16_t> samples(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    samples[i] = std::lround(amplitude * std::sin(2 * std::numbers::pi *
+                                                  frequency * i / kSampleRate));
+  }
+  return samples;
+}
+
+struct Output {
+  absl::Duration timestamp;
+  std::vector<double> amplitudes;
+};
+
+std::vector<Output> Process(ToneBank& bank,
+                            std::span<const std::int16_t> samples) {
+  std::vector<Output> outputs;
+  bank.Process(samples, [&](absl::Duration timestamp,
+                            std::span<const double> amplitudes) {
+    outputs.push_back({timestamp, {amplitudes.begin(), amplitudes.end()}});
+  });
+  return outputs;
+}
+}  // namespace
+
+TEST(ToneBankTest, BinCenteredTones) {
+  const double frequencies[] = {1000, 1100, 2500};
+  ToneBank bank(kSampleRate, frequencies, kOptions);
+  const std::vector<Output> outputs =
+      Process(bank, Sinusoid(1000, 10'000, 160));
+  ASSERT_THAT(outputs, SizeIs(2));
+  EXPECT_THAT(outputs[1].amplitudes,
+              ElementsAre(DoubleNear(10'000, 1), DoubleNear(0, 1),
+                          DoubleNear(0, 1)));
+}
+
+TEST(ToneBankTest, MatchesDft) {
+  // More tones than a multiple of the vector width, off the DFT bins.
+  const std::vector<double> frequencies = {130, 777, 1234.5, 2000,
+                                           3210, 3999};
+  ToneBank bank(kSampleRate, frequencies,
+                {.window_size = 80, .output_interval = 37});
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> distribution(-32768, 32767);
+  std::vector<std::int16_t> samples(1000);
+  std::ranges::generate(samples, [&] { return distribution(rng); });
+  const std::vector<Output> outputs = Process(bank, samples);
+  ASSERT_THAT(outputs, SizeIs(27));
+  for (const Output& output : outputs) {
+    const std::size_t end = std::lround(
+        absl::ToDoubleSeconds(output.timestamp) * kSampleRate);
+    for (std::size_t k = 0; k < frequencies.size(); ++k) {
+      std::complex<double> sum = 0;
+      for (std::size_t i = end > 80 ? end - 80 : 0; i < end; ++i) {
+        sum += std::polar<double>(samples[i], 2 * std::numbers::pi *
+                                                  frequencies[k] *
+                                                  (end - 1 - i) / kSampleRate);
+      }
+      EXPECT_NEAR(output.amplitudes[k], std::abs(sum) / 40, 1e-6)
+          << end << " " << k;
+    }
+  }
+}
+
+TEST(ToneBankTest, ForgetsEndedTone) {
+  const double frequencies[] = {1234.5};
+  ToneBank bank(kSampleRate, frequencies, kOptions);
+  Process(bank, Sinusoid(1234.5, 30'000, 100'000));
+  const std::vector<Output> outputs =
+      Process(bank, std::vector<std::int16_t>(80));
+  ASSERT_THAT(outputs, SizeIs(1));
+  EXPECT_NEAR(outputs[0].amplitudes[0], 0, 1e-6);
+}
+
+TEST(ToneBankTest, OutputTimestamps) {
+  const double frequencies[] = {1000};
+  ToneBank bank(kSampleRate, frequencies,
+                {.window_size = 80, .output_interval = 100});
+  std::vector<absl::Duration> timestamps;
+  for (int i = 0; i < 36; ++i) {
+    // Buffers that don't line up with the output interval.
+    for (const Output& output :
+         Process(bank, std::vector<std::int16_t>(7))) {
+      timestamps.push_back(output.timestamp);
+    }
+  }
+  EXPECT_THAT(timestamps, ElementsAre(absl::Milliseconds(12.5),
+                                      absl::Milliseconds(25)));
+}
+
+TEST(ToneBankTest, InterleavedChannel) {
+  const std::vector<std::int16_t> tone = Sinusoid(1000, 10'000, 80);
+  std::vector<std::int16_t> frames(2 * tone.size());
+  for (std::size_t i = 0; i < tone.size(); ++i) {
+    frames[2 * i + 1] = tone[i];
+  }
+  const double frequencies[] = {1000};
+  ToneBank left(kSampleRate, frequencies,
+                {.window_size = 80, .output_interval = 80, .channels = 2});
+  ToneBank right(
+      kSampleRate, frequencies,
+      {.window_size = 80, .output_interval = 80, .channels = 2, .channel = 1});
+  EXPECT_NEAR(Process(left, frames).at(0).amplitudes[0], 0, 1e-9);
+  EXPECT_NEAR(Process(right, frames).at(0).amplitudes[0], 10'000, 1);
+}
+
+TEST(ToneBankTest, InvalidArgumentsThrow) {
+  const double valid[] = {1000};
+  EXPECT_THROW(ToneBank(kSampleRate, {}), std::invalid_argument);
+  for (const double frequency :
+       {0.0, -100.0, 4000.0, std::numeric_limits<double>::quiet_NaN()}) {
+    const double frequencies[] = {frequency};
+    EXPECT_THROW(ToneBank(kSampleRate, frequencies), std::invalid_argument)
+        << frequency;
+  }
+  EXPECT_THROW(ToneBank(kSampleRate, valid, {.window_size = 0}),
+               std::invalid_argument);
+  EXPECT_THROW(ToneBank(kSampleRate, valid, {.output_interval = 0}),
+               std::invalid_argument);
+  EXPECT_THROW(ToneBank(kSampleRate, valid, {.channels = 2, .channel = 2}),
+               std::invalid_argument);
+}
+
+TEST(ToneBankTest, Stream) {
+  auto source = [](std::vector<std::int16_t> samples)
+      -> AsyncGenerator<Buffer<std::int16_t>> {
+    co_yield AdoptAsBuffer(std::move(samples));
+  }(Sinusoid(1000, 10'000, 200));
+  auto frames = TrackTones(kSampleRate, {1000}, kOptions, std::move(source));
+  for (const absl::Duration timestamp :
+       {absl::Milliseconds(10), absl::Milliseconds(20)}) {
+    ToneFrame* frame = Task(frames).Wait();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->timestamp, timestamp);
+    EXPECT_THAT(frame->amplitudes.span(), ElementsAre(DoubleNear(10'000, 1)));
+  }
+  EXPECT_EQ(Task(frames).Wait(), nullptr);
+}
@@ -0,0 +1,43 @@
+#include "fast_log.h"
+
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// Computes `scale * log2(x + offset)` for each value, using FastLog2() for
+// whole vectors and libm for the remainder.
+void ScaledLog2(std::span<const double> values, std::span<double> out,
+                double offset, double scale) {
+  assert(values.size() == out.size());
+  const std::size_t n = values.size();
+  std::size_t i = 0;
+#ifdef __AVX2__
+  const __m256d offset_vec = _mm256_set1_pd(offset);
+  const __m256d scale_vec = _mm256_set1_pd(scale);
+  for (; i + 4 <= n; i += 4) {
+    const __m256d x =
+        _mm256_add_pd(_mm256_loadu_pd(values.data() + i), offset_vec);
+    _mm256_storeu_pd(out.data() + i, _mm256_mul_pd(FastLog2(x), scale_vec));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = scale * std::log2(values[i] + offset);
+  }
+}
+
+}  // namespace
+
+void FastLog2(std::span<const double> values, std::span<double> logs) {
+  ScaledLog2(values, logs, 0, 1);
+}
+
+void FastLog2p1(std::span<const double> values, std::span<double> logs) {
+  ScaledLog2(values, logs, 1, 1);
+}
+
+void PowerToDecibels(std::span<const double> power,
+                     std::span<double> decibels) {
+  // 10 * log10(x) = 10 * log10(2) * log2(x)
+  ScaledLog2(power, decibels, 0, 10 * std::numbers::ln2 / std::numbers::ln10);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <numbers>
+#include <span>
+
+// Vectorized approximations of logarithms of positive normal doubles, accurate
+// to within ~1e-9 in absolute terms. This is far finer than the precision that
+// spectrum values are displayed with, while being several times faster than
+// calling libm per value. Zero and denormal inputs produce a large negative
+// value near -1023 rather than -infinity. Negative, infinite, and NaN inputs
+// produce unspecified results.
+
+#ifdef __AVX2__
+inline __m256d FastLog2(__m256d x) {
+  const __m256i bits = _mm256_castpd_si256(x);
+  // Split x into exponent e and mantissa m in [1, 2). Adding 2^52 to the biased
+  // exponent as a bit pattern and then subtracting it as a double converts the
+  // 64-bit integer to a double without AVX-512.
+  const __m256i magic = _mm256_set1_epi64x(0x4330000000000000);
+  __m256d e = _mm256_sub_pd(
+      _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), magic)),
+      _mm256_set1_pd(4503599627370496.0 + 1023));
+  const __m256i mantissa_bits =
+      _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFF));
+  __m256d m = _mm256_castsi256_pd(
+      _mm256_or_si256(mantissa_bits, _mm256_set1_epi64x(0x3FF0000000000000)));
+  // Re-center the mantissa to [sqrt(1/2), sqrt(2)) to keep the series short.
+  const __m256d too_big =
+      _mm256_cmp_pd(m, _mm256_set1_pd(std::numbers::sqrt2), _CMP_GT_OQ);
+  m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), too_big);
+  e = _mm256_add_pd(e, _mm256_and_pd(too_big, _mm256_set1_pd(1.0)));
+  // ln(m) = 2 * atanh(t), with t = (m - 1) / (m + 1) and |t| < 0.172.
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d t =
+      _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+  const __m256d t2 = _mm256_mul_pd(t, t);
+  __m256d p = _mm256_set1_pd(1.0 / 11);
+  p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(1.0 / 9));
+  p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(1.0 / 7));
+  p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(1.0 / 5));
+  p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(1.0 / 3));
+  p = _mm256_fmadd_pd(p, t2, one);
+  // log2(m) = ln(m) / ln(2)
+  const __m256d log2_m =
+      _mm256_mul_pd(_mm256_mul_pd(p, t), _mm256_set1_pd(2 / std::numbers::ln2));
+  return _mm256_add_pd(e, log2_m);
+}
+#endif
+
+// Computes log2(x) for each value in `values`, writing the results to the
+// equal-length output `logs`. `logs` may alias `values`.
+void FastLog2(std::span<const double> values, std::span<double> logs);
+
+// Computes log2(x + 1) for each value in `values`, writing the results to the
+// equal-length output `logs`. `logs` may alias `values`.
+void FastLog2p1(std::span<const double> values, std::span<double> logs);
+
+// Converts each power value in `power` to decibels, i.e. 10 * log10(x), writing
+// the results to the equal-length output `decibels`. `decibels` may alias
+// `power`.
+void PowerToDecibels(std::span<const double> power,
+                     std::span<double> decibels);
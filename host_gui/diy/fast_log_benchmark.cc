@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <ranges>
+#include <vector>
+
+#include "fast_log.h"
+
+auto RandomPowers(std::size_t n) {
+  std::mt19937 rng{std::random_device{}()};
+  std::uniform_real_distribution<double> exponent(-20.0, 40.0);
+
+  std::vector<double> values(n);
+  std::ranges::generate(values, [&] { return std::exp2(exponent(rng)); });
+  return values;
+}
+
+static void BM_Log2Libm(benchmark::State& state) {
+  const std::size_t n = state.range(0);
+  const std::vector<double> values = RandomPowers(n);
+  std::vector<double> logs(n);
+
+  for (auto _ : state) {
+    std::ranges::transform(values, logs.begin(),
+                           [](double v) { return std::log2(v + 1); });
+    benchmark::DoNotOptimize(logs.data());
+  }
+  state.SetItemsProcessed(n * state.iterations());
+}
+
+static void BM_FastLog2p1(benchmark::State& state) {
+  const std::size_t n = state.range(0);
+  const std::vector<double> values = RandomPowers(n);
+  std::vector<double> logs(n);
+
+  for (auto _ : state) {
+    FastLog2p1(values, logs);
+    benchmark::DoNotOptimize(logs.data());
+  }
+  state.SetItemsProcessed(n * state.iterations());
+}
+
+static void BM_DecibelsLibm(benchmark::State& state) {
+  const std::size_t n = state.range(0);
+  const std::vector<double> values = RandomPowers(n);
+  std::vector<double> decibels(n);
+
+  for (auto _ : state) {
+    std::ranges::transform(values, decibels.begin(),
+                           [](double v) { return 10 * std::log10(v); });
+    benchmark::DoNotOptimize(decibels.data());
+  }
+  state.SetItemsProcessed(n * state.iterations());
+}
+
+static void BM_PowerToDecibels(benchmark::State& state) {
+  const std::size_t n = state.range(0);
+  const std::vector<double> values = RandomPowers(n);
+  std::vector<double> decibels(n);
+
+  for (auto _ : state) {
+    PowerToDecibels(values, decibels);
+    benchmark::DoNotOptimize(decibels.data());
+  }
+  state.SetItemsProcessed(n * state.iterations());
+}
+
+BENCHMARK(BM_Log2Libm)->Arg(256)->Arg(1024)->Arg(4096)->Arg(16384);
+BENCHMARK(BM_FastLog2p1)->Arg(256)->Arg(1024)->Arg(4096)->Arg(16384);
+BENCHMARK(BM_DecibelsLibm)->Arg(256)->Arg(1024)->Arg(4096)->Arg(16384);
+BENCHMARK(BM_PowerToDecibels)->Arg(256)->Arg(1024)->Arg(4096)->Arg(16384);
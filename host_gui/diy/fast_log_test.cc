@@ -0,0 +1,59 @@
+#include "fast_log.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+using testing::ElementsAre;
+
+constexpr double kMaxError = 1e-8;
+
+// Logarithmically spaced values over the range of normal doubles. An odd
+// length exercises both the vectorized and scalar paths.
+std::vector<double> LogSpacedValues() {
+  std::vector<double> values;
+  for (double e = -1000; e <= 1000; e += 0.37) {
+    values.push_back(std::exp2(e));
+  }
+  return values;
+}
+
+TEST(FastLogTest, Log2MatchesLibm) {
+  const std::vector<double> values = LogSpacedValues();
+  std::vector<double> logs(values.size());
+  FastLog2(values, logs);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    EXPECT_NEAR(logs[i], std::log2(values[i]), kMaxError) << values[i];
+  }
+}
+
+// Spectrum values are displayed from log2(x + 1), so the region just above 0
+// matters most.
+TEST(FastLogTest, Log2p1MatchesLibm) {
+  std::vector<double> values;
+  for (int i = 0; i < 10'001; ++i) {
+    values.push_back(std::exp2(i * 0.004) - 1);
+  }
+  std::vector<double> logs(values.size());
+  FastLog2p1(values, logs);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    EXPECT_NEAR(logs[i], std::log2(values[i] + 1), kMaxError) << values[i];
+  }
+}
+
+TEST(FastLogTest, ExactPowersOfTwo) {
+  std::vector<double> values = {0.25, 0.5, 1, 2, 4, 1024, 0x1p100};
+  FastLog2(values, values);
+  EXPECT_THAT(values, ElementsAre(-2, -1, 0, 1, 2, 10, 100));
+}
+
+TEST(FastLogTest, Decibels) {
+  std::vector<double> power = {1e-12, 1e-3, 0.5, 1, 10, 100, 1e6};
+  std::vector<double> decibels(power.size());
+  PowerToDecibels(power, decibels);
+  for (std::size_t i = 0; i < power.size(); ++i) {
+    EXPECT_NEAR(decibels[i], 10 * std::log10(power[i]), 10 * kMaxError);
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock for publishing small trivially copyable values
+// to any number of readers. The writer never waits; readers retry if they
+// overlap with a write.
+//
+// The value is stored as relaxed atomic words rather than plain memory, so
+// that racing reads are well-defined and merely discarded.
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+ public:
+  SeqLock() : SeqLock(T{}) {}
+  explicit SeqLock(const T& value) { Store(value); }
+
+  // Must only be called from one thread at a time.
+  void Store(const T& value) {
+    std::array<std::uint64_t, kWords> words = {};
+    std::memcpy(words.data(), &value, sizeof(T));
+    const std::uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    // An odd sequence number marks a write in progress.
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < kWords; ++i) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  // May be called from any thread.
+  T Load() const {
+    std::array<std::uint64_t, kWords> words;
+    while (true) {
+      const std::uint64_t before = sequence_.load(std::memory_order_acquire);
+      if (before % 2 != 0) {
+        continue;
+      }
+      for (std::size_t i = 0; i < kWords; ++i) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == before) {
+        break;
+      }
+    }
+    T value;
+    std::memcpy(&value, words.data(), sizeof(T));
+    return value;
+  }
+
+ private:
+  static constexpr std::size_t kWords = (sizeof(T) + 7) / 8;
+
+  std::atomic<std::uint64_t> sequence_ = 0;
+  std::array<std::atomic<std::uint64_t>, kWords> words_ = {};
+};
@@ -0,0 +1,55 @@
+#include "seqlock.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+struct Value {
+  std::int64_t a;
+  std::int64_t b;
+  double c;
+  int d;
+};
+
+TEST(SeqLockTest, DefaultValue) {
+  SeqLock<Value> lock;
+  const Value value = lock.Load();
+  EXPECT_EQ(value.a, 0);
+  EXPECT_EQ(value.d, 0);
+}
+
+TEST(SeqLockTest, StoreLoad) {
+  SeqLock<Value> lock({1, 2, 3.5, 4});
+  lock.Store({5, 6, 7.5, 8});
+  const Value value = lock.Load();
+  EXPECT_EQ(value.a, 5);
+  EXPECT_EQ(value.b, 6);
+  EXPECT_EQ(value.c, 7.5);
+  EXPECT_EQ(value.d, 8);
+}
+
+// Readers never observe a partially written value.
+TEST(SeqLockTest, ConcurrentReadsConsistent) {
+  SeqLock<Value> lock;
+  constexpr std::int64_t kWrites = 200'000;
+  std::jthread writer([&] {
+    for (std::int64_t i = 1; i <= kWrites; ++i) {
+      lock.Store({i, -i, static_cast<double>(i), static_cast<int>(i)});
+    }
+  });
+  std::vector<std::jthread> readers;
+  for (int r = 0; r < 2; ++r) {
+    readers.emplace_back([&] {
+      std::int64_t previous = 0;
+      while (previous < kWrites) {
+        const Value value = lock.Load();
+        ASSERT_EQ(value.b, -value.a);
+        ASSERT_EQ(value.c, value.a);
+        ASSERT_EQ(value.d, value.a);
+        ASSERT_GE(value.a, previous);
+        previous = value.a;
+      }
+    });
+  }
+}
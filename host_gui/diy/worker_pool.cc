@@ -0,0 +1,78 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(std::size_t threads) {
+  workers_.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back(&WorkerPool::WorkerLoop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  workers_.clear();
+}
+
+void WorkerPool::ParallelFor(std::size_t n,
+                             absl::FunctionRef<void(std::size_t)> fn) {
+  if (n == 0) {
+    return;
+  }
+  if (workers_.empty() || n == 1) {
+    for (std::size_t i = 0; i < n; ++i) {
+      fn(i);
+    }
+    return;
+  }
+  absl::MutexLock call_lock(&call_mutex_);
+  {
+    absl::MutexLock lock(&mutex_);
+    fn_ = &fn;
+    size_ = n;
+    next_ = 0;
+    completed_ = 0;
+  }
+  RunIterations();
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &WorkerPool::LoopDone));
+  fn_ = nullptr;
+}
+
+void WorkerPool::RunIterations() {
+  while (true) {
+    const absl::FunctionRef<void(std::size_t)>* fn;
+    std::size_t i;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (fn_ == nullptr || next_ == size_) {
+        return;
+      }
+      fn = fn_;
+      i = next_++;
+    }
+    (*fn)(i);
+    absl::MutexLock lock(&mutex_);
+    ++completed_;
+  }
+}
+
+bool WorkerPool::WorkReady() const {
+  return stopping_ || (fn_ != nullptr && next_ < size_);
+}
+
+bool WorkerPool::LoopDone() const { return completed_ == size_; }
+
+void WorkerPool::WorkerLoop() {
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &WorkerPool::WorkReady));
+      if (stopping_) {
+        return;
+      }
+    }
+    RunIterations();
+  }
+}
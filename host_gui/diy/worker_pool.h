@@ -0,0 +1,53 @@
+#pragma once
+
+#include <absl/base/thread_annotations.h>
+#include <absl/functional/function_ref.h>
+#include <absl/synchronization/mutex.h>
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads for data-parallel loops, e.g. per-channel work that is
+// too short-lived to justify spawning threads for.
+class WorkerPool {
+ public:
+  // Starts `threads` workers. The thread calling ParallelFor() also takes part,
+  // so zero workers runs everything inline.
+  explicit WorkerPool(std::size_t threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Number of threads that run ParallelFor() iterations, including the caller.
+  std::size_t concurrency() const noexcept { return workers_.size() + 1; }
+
+  // Calls `fn(i)` for each i in [0, n), in no particular order and possibly
+  // concurrently, and returns once all calls have returned. `fn` must not
+  // throw. Concurrent calls from different threads are serialized.
+  void ParallelFor(std::size_t n, absl::FunctionRef<void(std::size_t)> fn)
+      ABSL_LOCKS_EXCLUDED(mutex_, call_mutex_);
+
+ private:
+  // Runs iterations of the current loop until none are left unclaimed.
+  void RunIterations() ABSL_LOCKS_EXCLUDED(mutex_);
+  bool WorkReady() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool LoopDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void WorkerLoop() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Held for the duration of each ParallelFor().
+  absl::Mutex call_mutex_;
+
+  absl::Mutex mutex_;
+  // Body of the current loop; null between loops.
+  const absl::FunctionRef<void(std::size_t)>* fn_ ABSL_GUARDED_BY(mutex_) =
+      nullptr;
+  std::size_t size_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Index of the next unclaimed iteration.
+  std::size_t next_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::size_t completed_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::vector<std::jthread> workers_;
+};
@@ -0,0 +1,64 @@
+#include "worker_pool.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+using testing::Each;
+using testing::Eq;
+
+TEST(WorkerPoolTest, Concurrency) {
+  EXPECT_EQ(WorkerPool(0).concurrency(), 1);
+  EXPECT_EQ(WorkerPool(3).concurrency(), 4);
+}
+
+TEST(WorkerPoolTest, EmptyLoop) {
+  WorkerPool pool(2);
+  pool.ParallelFor(0, [](std::size_t) { FAIL(); });
+}
+
+TEST(WorkerPoolTest, InlineWithoutWorkers) {
+  WorkerPool pool(0);
+  std::vector<std::size_t> order;
+  pool.ParallelFor(4, [&](std::size_t i) { order.push_back(i); });
+  EXPECT_THAT(order, testing::ElementsAre(0, 1, 2, 3));
+}
+
+TEST(WorkerPoolTest, EachIterationRunsOnce) {
+  WorkerPool pool(3);
+  for (std::size_t n : {1, 2, 4, 7, 100}) {
+    std::vector<std::atomic<int>> calls(n);
+    pool.ParallelFor(n, [&](std::size_t i) { ++calls[i]; });
+    std::vector<int> counts(calls.begin(), calls.end());
+    EXPECT_THAT(counts, Each(Eq(1))) << "n=" << n;
+  }
+}
+
+TEST(WorkerPoolTest, ResultsVisibleAfterReturn) {
+  WorkerPool pool(3);
+  std::vector<std::int64_t> squares(1000);
+  pool.ParallelFor(squares.size(),
+                   [&](std::size_t i) { squares[i] = i * i; });
+  std::int64_t sum = std::accumulate(squares.begin(), squares.end(),
+                                     std::int64_t{0});
+  EXPECT_EQ(sum, 332'833'500);
+}
+
+TEST(WorkerPoolTest, ConcurrentCallers) {
+  WorkerPool pool(2);
+  std::atomic<int> total = 0;
+  {
+    std::vector<std::jthread> callers;
+    for (int c = 0; c < 4; ++c) {
+      callers.emplace_back([&] {
+        for (int k = 0; k < 50; ++k) {
+          pool.ParallelFor(8, [&](std::size_t) { ++total; });
+        }
+      });
+    }
+  }
+  EXPECT_EQ(total, 4 * 50 * 8);
+}
@@ -1,22 +1,32 @@
 #include "./image_viewer.h"
 
 #include <QColor>
+#include <QEvent>
 #include <QImage>
 #include <QPaintEvent>
 #include <QPainter>
+#include <QPen>
 #include <QRect>
 #include <QRectF>
+#include <QRegion>
 #include <QTransform>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
 #include <mutex>
+#include <utility>
 
 #include "colormaps.h"
+#include "image/frame_geometry.h"
 
 ImageViewer::ImageViewer(QSize image_size)
     : image_size_(image_size),
-      primary_(image_size, QImage::Format_RGB32),
+      primary_{.image = QImage(image_size, QImage::Format_RGB32)},
       cursor_(new Cursor(this)) {
-  primary_.fill(0xFF'00'00'00);
-  secondary_ = primary_.copy();
+  primary_.image.fill(0xFF'00'00'00);
+  secondary_.image = primary_.image.copy();
+  shown_ = primary_;
   setMouseTracking(true);
   setAttribute(Qt::WA_NoSystemBackground);
   setAttribute(Qt::WA_OpaquePaintEvent);
@@ -34,6 +44,18 @@ QTransform ImageViewer::widgetToLogicalTransform() const {
       static_cast<double>(image_size_.height()) / height());
 }
 
+int ImageViewer::levelOfDetail() const {
+  if (width() <= 0 || height() <= 0) {
+    return 0;
+  }
+  // Integer downscaling factor along each axis that still leaves at least one
+  // image pixel per widget pixel.
+  const int x_factor = std::max(1, image_size_.width() / width());
+  const int y_factor = std::max(1, image_size_.height() / height());
+  return std::bit_width(static_cast<unsigned>(std::min(x_factor, y_factor))) -
+         1;
+}
+
 auto ImageViewer::UpdateImage() -> ScopedUpdate {
   absl::MutexLock lock(&mutex_);
   return ScopedUpdate{*this, secondary_};
@@ -42,12 +64,135 @@ auto ImageViewer::UpdateImage() -> ScopedUpdate {
 void ImageViewer::EndUpdateImage() {
   {
     absl::MutexLock lock(&mutex_);
+    if (SameDisplayFrame(primary_, secondary_)) {
+      return;
+    }
     std::swap(primary_, secondary_);
   }
+  // Widget contents may only be scrolled from the GUI thread. Frames swapped
+  // in before it gets to them are presented at once.
+  QMetaObject::invokeMethod(this, [this] { Present(); }, Qt::QueuedConnection);
+}
+
+void ImageViewer::Present() {
+  DisplayFrame frame;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (SameDisplayFrame(shown_, primary_)) {
+      return;
+    }
+    frame = primary_;
+  }
+  const std::optional<int> distance = ScrollDistance(shown_, frame);
+  if (!distance) {
+    // Covers both the new frame and anything the old frame left behind.
+    const QRectF dirty_rect =
+        LogicalFrameRect(shown_) | LogicalFrameRect(frame);
+    shown_ = std::move(frame);
+    // Snapping to device pixels can move the frame by up to a pixel.
+    update(logicalToWidgetTransform()
+               .mapRect(dirty_rect)
+               .toAlignedRect()
+               .adjusted(-1, -1, 1, 1));
+    return;
+  }
+  // After scrolling, the old frame's pixels are still right from the new
+  // frame's left edge up to where the scrolled-in columns start. The strip
+  // left of the new frame and the scrolled-in columns are repainted.
+  const double ratio = devicePixelRatioF();
+  const QRect before = DeviceFrameRect(shown_);
+  const QRect after = DeviceFrameRect(frame);
+  const int kept_end = before.right() + 1 + std::lround(*distance * ratio);
+  const QRect kept(QPoint(std::ceil(after.left() / ratio),
+                          std::ceil(after.top() / ratio)),
+                   QPoint(std::floor(kept_end / ratio) - 1,
+                          std::floor((after.bottom() + 1) / ratio) - 1));
+  shown_ = std::move(frame);
+  // Passing a rectangle keeps the cursor child widget in place.
+  scroll(*distance, 0, rect());
+  update(QRegion(rect()).subtracted(kept));
+}
+
+QRect ImageViewer::DeviceFrameRect(const DisplayFrame& frame) const {
+  const double ratio = devicePixelRatioF();
+  const QRectF frame_rect =
+      logicalToWidgetTransform().mapRect(LogicalFrameRect(frame));
+  return QRect(QPoint(std::lround(frame_rect.x() * ratio),
+                      std::lround(frame_rect.y() * ratio)),
+               (frame_rect.size() * ratio).toSize());
+}
+
+std::optional<int> ImageViewer::ScrollDistance(
+    const DisplayFrame& before, const DisplayFrame& after) const {
+  const std::int64_t columns =
+      FrameScrollPosition(after.image) - FrameScrollPosition(before.image);
+  // The overlay is drawn in logical coordinates, so it mustn't move with the
+  // pixels under it.
+  if (!overlay_.isEmpty() || !SameFrameGeometry(before.image, after.image) ||
+      columns <= 0 || columns >= after.image.width()) {
+    return std::nullopt;
+  }
+  // Scaled frames are only shifted copies of each other if every column scales
+  // to the same whole number of pixels.
+  const QRect before_rect = DeviceFrameRect(before);
+  const QRect after_rect = DeviceFrameRect(after);
+  if (after_rect.width() % after.image.width() != 0) {
+    return std::nullopt;
+  }
+  const int column_width = after_rect.width() / after.image.width();
+  const int pixels = after_rect.x() - before_rect.x() -
+                     static_cast<int>(columns) * column_width;
+  const double widget_pixels = pixels / devicePixelRatioF();
+  if (widget_pixels != std::round(widget_pixels)) {
+    return std::nullopt;
+  }
+  return static_cast<int>(widget_pixels);
+}
+
+void ImageViewer::setOverlay(QPainterPath overlay) {
+  if (overlay == overlay_) {
+    return;
+  }
+  overlay_ = std::move(overlay);
   update();
 }
 
+void ImageViewer::UpdateVisibleRect() {
+  QRect visible = rect();
+  if (const QWidget* parent = parentWidget()) {
+    visible &= QRect(-pos(), parent->size());
+  }
+  const QRect logical =
+      widgetToLogicalTransform().mapRect(QRectF(visible)).toAlignedRect();
+  if (logical != visible_rect_) {
+    visible_rect_ = logical;
+    emit visibleRectChanged(logical);
+  }
+}
+
+bool ImageViewer::event(QEvent* event) {
+  // The visible rect also depends on the parent's size, e.g. that of a scroll
+  // area's viewport, so the parent's resizes are watched as well.
+  if (event->type() == QEvent::ParentAboutToChange && parentWidget()) {
+    parentWidget()->removeEventFilter(this);
+  } else if (event->type() == QEvent::ParentChange) {
+    if (parentWidget()) {
+      parentWidget()->installEventFilter(this);
+    }
+    UpdateVisibleRect();
+  }
+  return QWidget::event(event);
+}
+
+bool ImageViewer::eventFilter(QObject* watched, QEvent* event) {
+  if (watched == parentWidget() && event->type() == QEvent::Resize) {
+    UpdateVisibleRect();
+  }
+  return QWidget::eventFilter(watched, event);
+}
+
 void ImageViewer::moveEvent(QMoveEvent* event) {
+  UpdateVisibleRect();
   update();
   QWidget::moveEvent(event);
 }
@@ -74,10 +219,56 @@ void ImageViewer::mouseMoveEvent(QMouseEvent* event) {
 
 void ImageViewer::paintEvent(QPaintEvent* event) {
   QPainter painter(this);
-  const QRect dest_rect = event->rect();
-  absl::MutexLock lock(&mutex_);
-  const QRect source_rect =
-      widgetToLogicalTransform().mapRect(QRectF(dest_rect)).toAlignedRect();
-  painter.setWindow(primary_.rect());
-  painter.drawImage(source_rect.topLeft(), primary_, source_rect);
+  // The image may be a downscaled crop of the logical image. It's pre-scaled
+  // to device resolution, and drawn in device pixels with scroll displacements
+  // snapped to whole pixels, so that drawing it is a blit rather than a
+  // resample.
+  const double ratio = devicePixelRatioF();
+  painter.scale(1 / ratio, 1 / ratio);
+  const QRect frame_rect = DeviceFrameRect(shown_);
+  const QPoint origin = frame_rect.topLeft();
+  const QRect dest_rect = QRectF(QPointF(event->rect().topLeft()) * ratio,
+                                 QSizeF(event->rect().size()) * ratio)
+                              .toAlignedRect();
+  const QImage& scaled =
+      paint_cache_.Scale(shown_.image, frame_rect.size(), ratio);
+  // Clamped to the scaled image, so that the source rectangle never reaches
+  // past it.
+  const QRect image_rect = dest_rect & QRect(origin, scaled.size());
+  if (!image_rect.isEmpty()) {
+    painter.drawImage(image_rect, scaled, image_rect.translated(-origin));
+  }
+  // A frame displaced by a scroll leaves the columns that scrolled out of it
+  // uncovered on its left. Its first column is stretched over that strip, so
+  // that the edge continues rather than showing the background.
+  const int crop_left = DeviceFrameRect({.image = shown_.image}).x();
+  const QRect strip_rect =
+      dest_rect & QRect(crop_left, origin.y(), origin.x() - crop_left,
+                        scaled.height());
+  if (!strip_rect.isEmpty()) {
+    painter.drawImage(strip_rect, scaled,
+                      QRect(0, strip_rect.y() - origin.y(), 1,
+                            strip_rect.height()));
+  }
+  for (const QRect& rect :
+       QRegion(dest_rect).subtracted(image_rect).subtracted(strip_rect)) {
+    painter.fillRect(rect, Qt::black);
+  }
+  if (!overlay_.isEmpty()) {
+    QPen pen(Qt::white, 1.5);
+    pen.setCosmetic(true);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setTransform(logicalToWidgetTransform());
+    painter.strokePath(overlay_, pen);
+  }
+}
+
+void ImageViewer::resizeEvent(QResizeEvent* event) {
+  UpdateVisibleRect();
+  const int level = levelOfDetail();
+  if (level != level_of_detail_) {
+    level_of_detail_ = level;
+    emit levelOfDetailChanged(level);
+  }
+  QWidget::resizeEvent(event);
 }
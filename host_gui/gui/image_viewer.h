@@ -3,11 +3,15 @@
 #include <absl/synchronization/mutex.h>
 
 #include <QImage>
+#include <QPainterPath>
 #include <QSize>
 #include <QTransform>
 #include <QWidget>
+#include <optional>
 
 #include "cursor.h"
+#include "image/frame_geometry.h"
+#include "image/scaled_frame_cache.h"
 
 // Double-buffered widget for rendering a QImage.
 class ImageViewer : public QWidget {
@@ -20,37 +24,77 @@ class ImageViewer : public QWidget {
   QTransform logicalToWidgetTransform() const;
   QTransform widgetToLogicalTransform() const;
 
+  // The pyramid level whose resolution best matches the current widget size,
+  // i.e. the coarsest level that is still at least as detailed as the widget.
+  // Level N is downscaled by 2^N along each axis relative to the logical image
+  // size.
+  int levelOfDetail() const;
+
   struct ScopedUpdate {
     ImageViewer& viewer;
-    // Image to draw into. This will already have the correct size and format,
-    // but unspecified contents.
-    QImage& image;
+    // Frame to draw into, with unspecified contents. The new image may be a
+    // downscaled crop of the logical image, described by frame_geometry.h
+    // metadata; see levelOfDetail() and visibleRectChanged().
+    DisplayFrame& frame;
 
     ~ScopedUpdate() { viewer.EndUpdateImage(); }
   };
 
   // RAII handle to the double-buffer's secondary image. Once the return value
-  // is destructed, this double-buffer is rotated and the newly rendered image
-  // will be painted to the widget.
+  // is destructed, this double-buffer is rotated and the new frame is shown on
+  // the GUI thread. If it's the shown frame scrolled by whole pixels, the
+  // widget contents are scrolled and only the exposed columns are repainted;
+  // otherwise the region covered by the old and new frames is repainted.
+  // Frames identical to the current one (see SameDisplayFrame()) are ignored.
   ScopedUpdate UpdateImage();
 
+  // Replaces the path stroked over the image, in logical image coordinates,
+  // e.g. a track of the dominant frequency. An empty path removes the overlay.
+  // Must be called from the GUI thread.
+  void setOverlay(QPainterPath overlay);
+
  signals:
   void binHovered(QPoint);
+  void levelOfDetailChanged(int level);
+  // Region of the logical image visible through the parent widget changed.
+  void visibleRectChanged(QRect rect);
 
  protected:
+  bool event(QEvent* event) override;
+  bool eventFilter(QObject* watched, QEvent* event) override;
   void moveEvent(QMoveEvent* event) override;
   void enterEvent(QEnterEvent* event) override;
   void mouseMoveEvent(QMouseEvent* event) override;
   void paintEvent(QPaintEvent* event) override;
+  void resizeEvent(QResizeEvent* event) override;
 
  private:
   void EndUpdateImage();
+  // Shows the latest frame. Must be called from the GUI thread.
+  void Present();
+  // Device pixels that `frame` is painted at.
+  QRect DeviceFrameRect(const DisplayFrame& frame) const;
+  // Widget pixels by which the painted contents of `before` move
+  // horizontally when `after` replaces it, if `after` paints exactly those
+  // pixels shifted, apart from the columns it scrolls in; nullopt otherwise.
+  std::optional<int> ScrollDistance(const DisplayFrame& before,
+                                    const DisplayFrame& after) const;
+  void UpdateVisibleRect();
 
   const QSize image_size_;
   Cursor* const cursor_;
+  int level_of_detail_ = 0;
+  QRect visible_rect_;
+  QPainterPath overlay_;
   // We double-buffer the images so that the caller can write to one image while
   // we're rendering the previous one without competing for the mutex.
   absl::Mutex mutex_;
-  QImage primary_ ABSL_GUARDED_BY(mutex_);
-  QImage secondary_ ABSL_GUARDED_BY(mutex_);
+  DisplayFrame primary_ ABSL_GUARDED_BY(mutex_);
+  DisplayFrame secondary_ ABSL_GUARDED_BY(mutex_);
+  // Frame on screen, taken from `primary_` by Present(). Repaints draw it
+  // rather than `primary_`, so that they match the scrolled pixels around
+  // them. Only used on the GUI thread.
+  DisplayFrame shown_;
+  // Device resolution copy of `shown_`, maintained by paintEvent().
+  ScaledFrameCache paint_cache_;
 };
@@ -4,12 +4,25 @@
 #include <absl/strings/str_format.h>
 #include <absl/time/time.h>
 
+#include <QAction>
+#include <QComboBox>
+#include <QFileDialog>
 #include <QGuiApplication>
 #include <QLabel>
+#include <QPainterPath>
+#include <QPixmap>
 #include <QScreen>
+#include <QScrollBar>
 #include <QShortcut>
+#include <QStandardPaths>
 #include <QStatusBar>
+#include <QTimer>
 #include <QToolBar>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <optional>
 #include <stop_token>
 #include <thread>
 
@@ -21,11 +34,22 @@
 #include "scroll_area.h"
 
 namespace {
+// Channels of the simulated microphone array.
+constexpr std::size_t kChannels = 4;
+
 Rational DefaultRefreshPeriod() {
   const double refresh_rate = QGuiApplication::primaryScreen()->refreshRate();
   LOG(INFO) << "Primary screen refresh rate: " << refresh_rate;
   return Rational{1, static_cast<int>(refresh_rate)};
 }
+
+// FFT plans tuned on previous runs are kept here.
+std::filesystem::path FftWisdomPath() {
+  return std::filesystem::path(
+             QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                 .toStdString()) /
+         "fftw_wisdom";
+}
 }  // namespace
 
 struct MainWindow::Impl {
@@ -33,7 +57,12 @@ struct MainWindow::Impl {
   ~Impl();
 
   void initViewer();
+  void initDoaView(QVBoxLayout& layout);
+  void initHistoryBar();
   void initToolBar();
+  void initSpectrumPickers(QToolBar& tool_bar);
+  void initChannelPicker(QToolBar& tool_bar);
+  void initOverlays(QToolBar& tool_bar);
   void initStatusBar();
   void initShortcuts();
 
@@ -44,13 +73,21 @@ struct MainWindow::Impl {
   MainWindow* window;
   ImageViewer* viewer;
   ScrollArea* scroll_area;
+  // Scrolls through recorded history. The value is the index one past the
+  // rightmost visible column, and the maximum value follows the live view.
+  QScrollBar* history_bar;
 
   std::jthread update_thread;
 };
 
 MainWindow::Impl::Impl(MainWindow* window)
-    : window(window), model({.refresh_period = DefaultRefreshPeriod()}) {
+    : window(window),
+      model({.channels = kChannels,
+             .fft_wisdom_path = FftWisdomPath(),
+             .fft_planner_effort = PlannerEffort::kMeasure,
+             .refresh_period = DefaultRefreshPeriod()}) {
   initViewer();
+  initHistoryBar();
   initToolBar();
   initStatusBar();
   initShortcuts();
@@ -67,7 +104,63 @@ void MainWindow::Impl::initViewer() {
   viewer = new ImageViewer(model.imageSize());
   scroll_area = new ScrollArea();
   scroll_area->setWidget(viewer);
-  window->setCentralWidget(scroll_area);
+  history_bar = new QScrollBar(Qt::Horizontal);
+
+  auto* central = new QWidget();
+  auto* layout = new QVBoxLayout(central);
+  layout->setContentsMargins(0, 0, 0, 0);
+  layout->setSpacing(0);
+  layout->addWidget(scroll_area);
+  layout->addWidget(history_bar);
+  if (kChannels > 1) {
+    initDoaView(*layout);
+  }
+  window->setCentralWidget(central);
+
+  QObject::connect(viewer, &ImageViewer::levelOfDetailChanged,
+                   [this](int level) { model.SetLevelOfDetail(level); });
+  QObject::connect(viewer, &ImageViewer::visibleRectChanged,
+                   [this](QRect rect) { model.SetViewport(rect); });
+}
+
+void MainWindow::Impl::initDoaView(QVBoxLayout& layout) {
+  auto* doa_view = new QLabel();
+  doa_view->setScaledContents(true);
+  doa_view->setFixedHeight(64);
+  doa_view->setToolTip(
+      "Time difference of arrival between channel pairs, from the second "
+      "channel leading (bottom) to lagging (top).");
+  layout.addWidget(doa_view);
+
+  auto* timer = new QTimer(window);
+  QObject::connect(timer, &QTimer::timeout, [this, doa_view] {
+    doa_view->setPixmap(QPixmap::fromImage(model.RenderDoa()));
+  });
+  timer->start(100);
+}
+
+void MainWindow::Impl::initHistoryBar() {
+  // Periodically extend the scroll range to cover newly recorded history.
+  auto* timer = new QTimer(window);
+  QObject::connect(timer, &QTimer::timeout, [this] {
+    const bool following = history_bar->value() == history_bar->maximum();
+    const int width = model.imageSize().width();
+    const int columns = static_cast<int>(model.HistoryColumns());
+    history_bar->setRange(std::min(width, columns), columns);
+    history_bar->setPageStep(width);
+    if (following) {
+      history_bar->setValue(history_bar->maximum());
+    }
+  });
+  timer->start(250);
+
+  QObject::connect(history_bar, &QScrollBar::valueChanged, [this](int value) {
+    if (value == history_bar->maximum()) {
+      model.FollowLive();
+    } else {
+      model.ScrollHistory(value);
+    }
+  });
 }
 
 void MainWindow::Impl::initToolBar() {
@@ -85,6 +178,168 @@ void MainWindow::Impl::initToolBar() {
                    set_colormap);
   QObject::connect(colormap_picker, &ColormapPicker::currentIndexChanged,
                    window, set_colormap);
+
+  initSpectrumPickers(tool_bar);
+  initChannelPicker(tool_bar);
+  initOverlays(tool_bar);
+}
+
+void MainWindow::Impl::initSpectrumPickers(QToolBar& tool_bar) {
+  const SpectrumOptions options = model.CurrentSpectrumOptions();
+
+  auto* size_picker = new QComboBox();
+  // Only sizes planned up front are offered, so that switching doesn't wait
+  // for the FFT planner.
+  for (const std::size_t size : model.FftWindowSizes()) {
+    size_picker->addItem(QString::fromStdString(absl::StrFormat("N=%d", size)),
+                         static_cast<qulonglong>(size));
+  }
+  size_picker->setCurrentIndex(
+      size_picker->findData(static_cast<qulonglong>(options.window_size)));
+  tool_bar.addWidget(size_picker);
+
+  auto* window_picker = new QComboBox();
+  window_picker->addItem("Rectangular",
+                         static_cast<int>(WindowFunction::kRectangular));
+  window_picker->addItem("Hann", static_cast<int>(WindowFunction::kHann));
+  window_picker->setCurrentIndex(
+      window_picker->findData(static_cast<int>(options.window_function)));
+  tool_bar.addWidget(window_picker);
+
+  // Items hold the number of hops per window.
+  auto* overlap_picker = new QComboBox();
+  overlap_picker->addItem("No overlap", 1);
+  overlap_picker->addItem("50% overlap", 2);
+  overlap_picker->addItem("75% overlap", 4);
+  const int hops_per_window =
+      options.hop_size == 0
+          ? 1
+          : static_cast<int>(options.window_size / options.hop_size);
+  overlap_picker->setCurrentIndex(
+      std::max(0, overlap_picker->findData(hops_per_window)));
+  tool_bar.addWidget(overlap_picker);
+
+  auto apply = [=, this] {
+    const std::size_t size = size_picker->currentData().toULongLong();
+    model.SetSpectrumOptions(
+        {.window_size = size,
+         .window_function =
+             static_cast<WindowFunction>(window_picker->currentData().toInt()),
+         .hop_size = size / overlap_picker->currentData().toInt()});
+  };
+  for (QComboBox* picker : {size_picker, window_picker, overlap_picker}) {
+    QObject::connect(picker, &QComboBox::currentIndexChanged, window, apply);
+  }
+
+  QAction* reduce_noise = tool_bar.addAction("Reduce noise");
+  reduce_noise->setCheckable(true);
+  reduce_noise->setChecked(model.NoiseReductionEnabled());
+  reduce_noise->setToolTip("Subtract the steady background noise of each "
+                           "channel from the spectrogram.");
+  QObject::connect(reduce_noise, &QAction::toggled, window,
+                   [this](bool checked) { model.SetNoiseReduction(checked); });
+}
+
+void MainWindow::Impl::initChannelPicker(QToolBar& tool_bar) {
+  if (model.channels() == 1) {
+    return;
+  }
+  // Items hold the channel index, or -1 to stack all channels.
+  auto* channel_picker = new QComboBox();
+  channel_picker->addItem("All channels", -1);
+  for (std::size_t c = 0; c < model.channels(); ++c) {
+    channel_picker->addItem(
+        QString::fromStdString(absl::StrFormat("Channel %d", c)),
+        static_cast<int>(c));
+  }
+  tool_bar.addWidget(channel_picker);
+
+  QObject::connect(channel_picker, &QComboBox::currentIndexChanged, window,
+                   [=, this] {
+                     const int channel = channel_picker->currentData().toInt();
+                     if (channel < 0) {
+                       model.ShowAllChannels();
+                     } else {
+                       model.ShowChannel(channel);
+                     }
+                   });
+}
+
+void MainWindow::Impl::initOverlays(QToolBar& tool_bar) {
+  QAction* show_track = tool_bar.addAction("Peak track");
+  show_track->setCheckable(true);
+  show_track->setToolTip("Overlay the dominant frequency of channel 0.");
+  QAction* show_onsets = tool_bar.addAction("Onsets");
+  show_onsets->setCheckable(true);
+  show_onsets->setToolTip("Mark onsets detected in channel 0.");
+
+  // Rebuilds the overlay from the events of the displayed columns.
+  auto* timer = new QTimer(window);
+  QObject::connect(timer, &QTimer::timeout, [=, this] {
+    const Model::Snapshot snapshot = model.CurrentSnapshot();
+    const std::int64_t view_begin = snapshot.view_end - snapshot.width;
+    const std::int64_t first = std::max<std::int64_t>(view_begin, 0);
+    // Center of `column`'s pixels.
+    auto x = [&](std::int64_t column) { return column - view_begin + 0.5; };
+    QPainterPath path;
+    if (show_track->isChecked()) {
+      bool connected = false;
+      const std::vector<TrackPoint> track =
+          model.PeakTrack(first, snapshot.view_end);
+      for (std::size_t i = 0; i < track.size(); ++i) {
+        const std::int64_t column = first + static_cast<std::int64_t>(i);
+        const std::optional<double> row =
+            track[i].frequency > 0
+                ? model.FrequencyRow(column, 0, track[i].frequency)
+                : std::nullopt;
+        if (!row) {
+          connected = false;
+          continue;
+        }
+        // Flip Y-axis from math convention to graphical convention.
+        const QPointF point(x(column), snapshot.height - *row - 0.5);
+        if (connected) {
+          path.lineTo(point);
+        } else {
+          path.moveTo(point);
+        }
+        connected = true;
+      }
+    }
+    if (show_onsets->isChecked()) {
+      for (const Model::Onset& onset :
+           model.Onsets(first, snapshot.view_end)) {
+        path.moveTo(x(onset.column), 0);
+        path.lineTo(x(onset.column), snapshot.height);
+      }
+    }
+    viewer->setOverlay(path);
+  });
+  timer->start(100);
+
+  QAction* export_events = tool_bar.addAction("Export");
+  export_events->setToolTip(
+      "Save the peak and pitch track, and the onsets, as CSV files.");
+  QObject::connect(export_events, &QAction::triggered, window, [this] {
+    const QString directory =
+        QFileDialog::getExistingDirectory(window, "Export to directory");
+    if (directory.isEmpty()) {
+      return;
+    }
+    const std::filesystem::path path = directory.toStdString();
+    const std::int64_t columns = model.HistoryColumns();
+    std::ofstream track_file(path / "track.csv");
+    WriteTrackCsv(model.PeakTrack(0, columns), track_file);
+    std::vector<OnsetEvent> onsets;
+    for (const Model::Onset& onset : model.Onsets(0, columns)) {
+      onsets.push_back(onset.event);
+    }
+    std::ofstream onsets_file(path / "onsets.csv");
+    WriteOnsetsCsv(onsets, onsets_file);
+    if (!track_file || !onsets_file) {
+      LOG(ERROR) << "Failed to export to " << path;
+    }
+  });
 }
 
 void MainWindow::Impl::initStatusBar() {
@@ -100,18 +355,49 @@ void MainWindow::Impl::initStatusBar() {
   time_label->setFont(font);
   status_bar->addPermanentWidget(time_label);
 
+  auto* pacing_label = new QLabel();
+  pacing_label->setFont(font);
+  status_bar->addPermanentWidget(pacing_label);
+  auto* pacing_timer = new QTimer(window);
+  QObject::connect(pacing_timer, &QTimer::timeout, [=, this] {
+    const FrameCounters& counters = model.PacingCounters();
+    pacing_label->setText(QString::fromStdString(
+        absl::StrFormat("late=%d dropped=%d", counters.late.load(),
+                        counters.dropped.load())));
+  });
+  pacing_timer->start(1000);
+
+  auto* power_label = new QLabel();
+  power_label->setFont(font);
+  status_bar->addPermanentWidget(power_label);
+
   QObject::connect(viewer, &ImageViewer::binHovered, [=, this](QPoint p) {
-    const std::span<const double> bins = model.FrequencyBins();
+    // Read model state from a snapshot, since the pipeline is concurrently
+    // modifying it.
+    const Model::Snapshot snapshot = model.CurrentSnapshot();
+    if (p.y() < 0 || p.y() >= snapshot.height) {
+      return;
+    }
     // Flip Y-axis from graphical convention to math convention.
-    const double f = *(bins.rbegin() + p.y());
-    frequency_label->setText(
-        QString::fromStdString(absl::StrFormat("%.2f Hz", f)));
+    const std::size_t bin = snapshot.height - 1 - p.y();
+    const std::int64_t column = snapshot.view_end - snapshot.width + p.x();
+    const Model::RowInfo row = model.DescribeRow(column, bin);
+    frequency_label->setText(QString::fromStdString(
+        model.channels() == 1
+            ? absl::StrFormat("%.2f Hz", row.frequency)
+            : absl::StrFormat("ch%d %.2f Hz", row.channel, row.frequency)));
 
-    const int t_index = p.x() - model.imageSize().width() - 1;
-    const absl::Duration t =
-        absl::Floor(model.TimeDelta(t_index), absl::Milliseconds(1));
+    const absl::Duration t = absl::Floor(
+        model.TimeDelta(column - (snapshot.history_columns - 1)),
+        absl::Milliseconds(1));
     time_label->setText(QString::fromStdString(
         absl::StrFormat("T=%s", absl::FormatDuration(t))));
+
+    const std::optional<double> decibels = model.PowerDecibels(column, bin);
+    power_label->setText(
+        decibels
+            ? QString::fromStdString(absl::StrFormat("%.1f dB", *decibels))
+            : QString());
   });
 }
 
@@ -123,12 +409,12 @@ void MainWindow::Impl::initShortcuts() {
 void MainWindow::Impl::UpdateLoop(std::stop_token stop_token) {
   [this](std::stop_token stop_token) -> Task<> {
     auto frames = model.Run();
-    while (QImage* frame = co_await frames) {
+    while (DisplayFrame* frame = co_await frames) {
       if (stop_token.stop_requested()) {
         co_return;
       }
       ImageViewer::ScopedUpdate update = viewer->UpdateImage();
-      update.image = std::move(*frame);
+      update.frame = std::move(*frame);
     }
   }(stop_token)
                                             .Wait();
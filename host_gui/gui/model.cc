@@ -4,72 +4,555 @@
 #include <absl/time/clock.h>
 #include <absl/time/time.h>
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+#include <limits>
 #include <ranges>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
+#include "audio/deinterleave.h"
+#include "audio/gcc_phat.h"
 #include "audio/source.h"
 #include "audio/spectrum.h"
 #include "diy/coro/executor.h"
+#include "diy/fast_log.h"
+#include "image/frame_geometry.h"
 #include "image/frame_scheduler.h"
 #include "image/interpolate.h"
 #include "image/lut.h"
 #include "image/qimage_eigen.h"
 
+namespace {
+// Number of history pyramid levels, i.e. downscaling factors of 1x to 8x.
+constexpr std::size_t kPyramidLevels = 4;
+
+// Expands `viewport` by a margin on each side, so that small scrolls can be
+// painted from already rendered pixels until the next frame arrives. The
+// result is converted to the coordinates of pyramid `level` and clipped to the
+// level's bounds.
+QRect LevelCrop(QRect viewport, QSize image_size, int level,
+                QSize level_size) {
+  const int margin_x = viewport.width() / 4;
+  const int margin_y = viewport.height() / 4;
+  viewport = viewport.adjusted(-margin_x, -margin_y, margin_x, margin_y)
+                 .intersected(QRect(QPoint(0, 0), image_size));
+  const int scale = 1 << level;
+  const QPoint top_left(viewport.x() / scale, viewport.y() / scale);
+  const QPoint bottom_right(
+      (viewport.x() + viewport.width() + scale - 1) / scale,
+      (viewport.y() + viewport.height() + scale - 1) / scale);
+  return QRect(top_left, QSize(bottom_right.x() - top_left.x(),
+                               bottom_right.y() - top_left.y()))
+      .intersected(QRect(QPoint(0, 0), level_size));
+}
+
+// Maps the region `crop` of the image formed by horizontally concatenating
+// `older` and `newer` to `image`, which must have the same size as `crop`.
+template <typename Older, typename Newer>
+void RenderCrop(const Older& older, const Newer& newer, QRect crop,
+                std::span<const std::uint32_t, kLogLevels> lut,
+                QImage& image) {
+  // We render the data upside-down so that higher frequencies are on the
+  // top. Note: our image has the opposite orientation compared to Eigen
+  // convention.
+  auto dest = EigenView(image).colwise().reverse();
+  const Eigen::Index first_row = older.rows() - crop.y() - crop.height();
+  const Eigen::Index rows = crop.height();
+  const Eigen::Index x0 = crop.x();
+  const Eigen::Index x1 = crop.x() + crop.width();
+  const Eigen::Index older_cols = older.cols();
+  if (x0 < older_cols) {
+    const Eigen::Index n = std::min(x1, older_cols) - x0;
+    LutMap(older.middleCols(x0, n).middleRows(first_row, rows),
+           dest.leftCols(n), lut);
+  }
+  if (x1 > older_cols) {
+    const Eigen::Index start = std::max(x0, older_cols);
+    const Eigen::Index n = x1 - start;
+    LutMap(newer.middleCols(start - older_cols, n).middleRows(first_row, rows),
+           dest.rightCols(n), lut);
+  }
+}
+
+// Threads in addition to the pipeline's for per-channel work: one per channel,
+// up to the number of cores.
+std::size_t SpectrumWorkers(std::size_t channels) {
+  const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+  return std::clamp<std::size_t>(channels, 1, cores) - 1;
+}
+
+// Sorted, distinct sizes of `options.fft_window_sizes` and the initial size.
+std::vector<std::size_t> PlannedFftSizes(const Model::Options& options) {
+  std::vector<std::size_t> sizes = options.fft_window_sizes;
+  sizes.push_back(options.fft_window_size);
+  std::ranges::sort(sizes);
+  const auto duplicates = std::ranges::unique(sizes);
+  sizes.erase(duplicates.begin(), duplicates.end());
+  return sizes;
+}
+
+}  // namespace
+
 Model::Model() : Model(Options()) {}
 
 Model::Model(const Options& options)
     : sample_rate_(options.sample_rate),
+      channels_(options.channels),
       fft_window_size_(options.fft_window_size),
+      fft_window_sizes_(PlannedFftSizes(options)),
       refresh_period_(options.refresh_period),
-      frequency_bins_(::FrequencyBins(fft_window_size_, sample_rate_)),
+      interpolation_(options.interpolation),
+      spectrum_config_({.sample_rate = sample_rate_,
+                        .window_size = fft_window_size_,
+                        .window_function = options.window_function,
+                        .hop_size = options.hop_size}),
+      fft_plans_({.wisdom_path = options.fft_wisdom_path,
+                  .tuning_effort = options.fft_planner_effort}),
+      spectrum_pool_(SpectrumWorkers(channels_)),
+      noise_reducers_(channels_, NoiseReducer(options.noise_reduction)),
+      reduce_noise_(options.reduce_noise),
+      gcc_phat_options_({.max_lag = options.doa_max_lag}),
+      frequency_bins_(
+          ::FrequencyBins(fft_window_sizes_.back(), sample_rate_)),
       width_(1440),
       height_(frequency_bins_.size()),
-      spectrum_data_(width_, height_),
-      indexed_data_(width_, height_) {}
+      level_data_(width_, height_, kPyramidLevels),
+      history_(height_, options.history),
+      recent_columns_(width_, height_),
+      auto_range_(options.auto_range),
+      display_lut_min_(std::numeric_limits<double>::infinity()),
+      display_lut_max_(-std::numeric_limits<double>::infinity()),
+      doa_data_(width_, channels_ > 1 ? 2 * options.doa_max_lag + 1 : 0),
+      peak_tracker_(sample_rate_, options.peak_tracker),
+      onset_detector_(sample_rate_, options.onset_detector),
+      viewport_(QPoint(0, 0), imageSize()) {
+  if (channels_ == 0 || channels_ > height_) {
+    throw std::invalid_argument("Unsupported number of channels: " +
+                                std::to_string(channels_));
+  }
+  fft_plans_.Prepare(fft_window_sizes_);
+  BuildDisplayLut(active_colormap_->entries, display_lut_min_,
+                  display_lut_max_, display_lut_);
+  PublishSnapshot(0);
+  analysis_thread_ = std::jthread([this] { AnalysisLoop(); });
+}
+
+Model::~Model() {
+  {
+    absl::MutexLock lock(&analysis_mutex_);
+    analysis_stopping_ = true;
+  }
+  analysis_thread_.join();
+}
+
+namespace {
+std::size_t HopSize(const SpectrumOptions& options) {
+  return options.hop_size == 0 ? options.window_size : options.hop_size;
+}
+}  // namespace
 
 absl::Duration Model::TimeDelta(std::int64_t n) const {
-  return absl::Seconds(n * fft_window_size_) / sample_rate_;
+  const auto current_hop =
+      static_cast<std::int64_t>(HopSize(spectrum_config_.Get()));
+  if (n >= 0) {
+    return absl::Seconds(n * current_hop) / sample_rate_;
+  }
+  absl::MutexLock lock(&hops_mutex_);
+  // Sum the hops of columns [first, last], which lead up to the latest one.
+  const std::int64_t last = hop_columns_ - 1;
+  const std::int64_t first = last + n + 1;
+  // Columns without a recorded hop, before column 1.
+  std::int64_t samples =
+      std::max<std::int64_t>(0, std::min<std::int64_t>(last + 1, 1) - first) *
+      current_hop;
+  for (std::size_t i = 0; i < hop_runs_.size(); ++i) {
+    const std::int64_t begin = std::max(hop_runs_[i].column, first);
+    const std::int64_t end =
+        i + 1 < hop_runs_.size() ? hop_runs_[i + 1].column : last + 1;
+    if (begin < end) {
+      samples += (end - begin) * hop_runs_[i].hop;
+    }
+  }
+  return -absl::Seconds(samples) / sample_rate_;
 }
 
-void Model::AppendSpectrum(Buffer<double> spectrum) {
-  std::ranges::for_each(spectrum, [&](double& v) {
-    v = std::log2(v + 1);
-    min_value_ = std::min(v, min_value_);
-    max_value_ = std::max(v, max_value_);
-  });
+void Model::RecordHop(std::int64_t window_end) {
+  absl::MutexLock lock(&hops_mutex_);
+  if (hop_columns_ > 0) {
+    const std::int64_t hop = window_end - last_window_end_;
+    if (hop_runs_.empty() || hop_runs_.back().hop != hop) {
+      hop_runs_.push_back({.column = hop_columns_, .hop = hop});
+    }
+  }
+  last_window_end_ = window_end;
+  ++hop_columns_;
+}
+
+void Model::SetSpectrumOptions(SpectrumOptions options) {
+  options.sample_rate = sample_rate_;
+  spectrum_config_.Set(options);
+}
+
+Rational Model::SpectrumPeriod() const {
+  return {static_cast<std::int64_t>(HopSize(spectrum_config_.Get())),
+          static_cast<std::int64_t>(sample_rate_)};
+}
+
+Model::ChannelBand Model::StackedBand(std::size_t channel) const {
+  // The top channel takes any leftover rows.
+  const std::size_t rows = height_ / channels_;
+  return {.first = channel * rows,
+          .rows = channel + 1 == channels_ ? height_ - channel * rows : rows};
+}
+
+int Model::ColumnLayout(std::int64_t column) const {
+  int channel = displayed_channel_;
+  {
+    absl::MutexLock lock(&layout_mutex_);
+    if (column < layout_columns_) {
+      const auto run = std::ranges::upper_bound(layout_runs_, column, {},
+                                                &LayoutRun::column);
+      if (run != layout_runs_.begin()) {
+        return std::prev(run)->channel;
+      }
+    }
+  }
+  return channel == kAllChannels
+             ? kAllChannels
+             : std::clamp(channel, 0, static_cast<int>(channels_) - 1);
+}
+
+Model::RowInfo Model::DescribeRow(std::int64_t column, std::size_t row) const {
+  if (const int channel = ColumnLayout(column); channel != kAllChannels) {
+    return {.channel = channel, .frequency = FrequencyBin(row)};
+  }
+  const std::size_t channel =
+      std::min(row / (height_ / channels_), channels_ - 1);
+  const ChannelBand band = StackedBand(channel);
+  const double nyquist = frequency_bins_.back();
+  return {.channel = static_cast<int>(channel),
+          .frequency = band.rows == 1 ? 0
+                                      : nyquist * (row - band.first) /
+                                            (band.rows - 1)};
+}
+
+std::optional<double> Model::FrequencyRow(std::int64_t column,
+                                          std::size_t channel,
+                                          double frequency) const {
+  const double nyquist = frequency_bins_.back();
+  if (const int displayed = ColumnLayout(column); displayed != kAllChannels) {
+    if (displayed != static_cast<int>(channel)) {
+      return std::nullopt;
+    }
+    return frequency / nyquist * (height_ - 1);
+  }
+  if (channel >= channels_) {
+    return std::nullopt;
+  }
+  const ChannelBand band = StackedBand(channel);
+  return band.first + frequency / nyquist * (band.rows - 1);
+}
+
+void Model::AppendSpectra(std::vector<Buffer<double>> spectra) {
+  assert(spectra.size() == channels_);
+  // Spectra of all FFT sizes are mapped onto the display's frequency axis, so
+  // that columns recorded before and after a size change line up without
+  // re-rendering the history.
+  auto column = Buffer<double>::Uninitialized(height_);
+  int layout = displayed_channel_;
+  if (layout != kAllChannels) {
+    layout = std::clamp(layout, 0, static_cast<int>(channels_) - 1);
+    ResampleSpectrum(spectra[layout].span(), column.span());
+  } else {
+    for (std::size_t c = 0; c < channels_; ++c) {
+      const ChannelBand band = StackedBand(c);
+      ResampleSpectrum(spectra[c].span(),
+                       column.span().subspan(band.first, band.rows));
+    }
+  }
   // TODO(dhrosa): Expose a CircularBuffer method to directly write to a new
   // column.
-  auto indexed = Buffer<std::uint8_t>::Uninitialized(spectrum.size());
-  ToIndexed(spectrum, indexed, min_value_, max_value_);
+  auto levels = Buffer<std::uint16_t>::Uninitialized(column.size());
+  ToLogLevels(column, levels);
+  auto_range_.Add(levels);
+  level_data_.AppendColumn(levels);
+  history_.AppendColumn(levels);
+  recent_columns_.AppendColumn(levels);
 
-  spectrum_data_.AppendColumn(spectrum);
-  indexed_data_.AppendColumn(indexed);
+  absl::MutexLock lock(&layout_mutex_);
+  if (layout_runs_.empty() || layout_runs_.back().channel != layout) {
+    layout_runs_.push_back({.column = layout_columns_, .channel = layout});
+  }
+  ++layout_columns_;
 }
 
-QImage Model::Render() {
-  QImage image(imageSize(), QImage::Format_RGB32);
-  auto lut = active_colormap_->entries;
+void Model::SubtractNoise(std::span<Buffer<double>> spectra) {
+  const bool enabled = reduce_noise_;
+  spectrum_pool_.ParallelFor(spectra.size(), [&](std::size_t c) {
+    if (enabled) {
+      noise_reducers_[c].Process(spectra[c].span());
+    } else {
+      noise_reducers_[c].Update(spectra[c].span());
+    }
+  });
+}
 
-  // We render the data upside-down so that higher frequencies are on the
-  // top. Note: our image has the opposite orientation compared to Eigen
-  // convention.
-  auto dest = EigenView(image).colwise().reverse();
+void Model::AppendDoa(std::span<const Buffer<std::complex<double>>> fft) {
+  std::vector<std::uint8_t> levels(2 * gcc_phat_options_.max_lag + 1, 0);
+  if (2 * gcc_phat_options_.max_lag < fft.front().size()) {
+    const TdoaFrame frame = GccPhat(fft, gcc_phat_options_, fft_plans_,
+                                    spectrum_pool_, gcc_phat_scratch_);
+    const double pairs = ChannelPairs(channels_);
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+      levels[i] = std::lround(255 * std::min(1.0, frame.histogram[i] / pairs));
+    }
+  }
+  absl::MutexLock lock(&doa_mutex_);
+  doa_data_.AppendColumn(levels);
+}
 
-  auto newer = indexed_data_.Newer();
-  auto older = indexed_data_.Older();
+void Model::QueueAnalysis(std::int64_t column, const ChannelSpectra& spectra) {
+  const Buffer<double>& power = spectra.power.front();
+  auto psd = Buffer<double>::Uninitialized(power.size());
+  std::ranges::copy(power, psd.begin());
+  absl::MutexLock lock(&analysis_mutex_);
+  analysis_queue_.push_back({.column = column,
+                             .window_end = spectra.window_end,
+                             .psd = std::move(psd)});
+}
 
-  LutMap(newer, dest.rightCols(newer.cols()), lut);
+bool Model::AnalysisReady() const {
+  return analysis_stopping_ || !analysis_queue_.empty();
+}
+
+bool Model::AnalysisIdle() const {
+  return analysis_stopping_ || (analysis_queue_.empty() && !analysing_);
+}
+
+void Model::WaitForAnalysis() {
+  absl::MutexLock lock(&analysis_mutex_);
+  analysis_mutex_.Await(absl::Condition(this, &Model::AnalysisIdle));
+}
+
+void Model::AnalysisLoop() {
+  while (true) {
+    AnalysisInput input;
+    {
+      absl::MutexLock lock(&analysis_mutex_);
+      analysis_mutex_.Await(absl::Condition(this, &Model::AnalysisReady));
+      if (analysis_stopping_) {
+        return;
+      }
+      input = std::move(analysis_queue_.front());
+      analysis_queue_.pop_front();
+      analysing_ = true;
+    }
+    AppendPeak(input);
+    AppendOnset(input);
+    absl::MutexLock lock(&analysis_mutex_);
+    analysing_ = false;
+  }
+}
+
+void Model::AppendPeak(const AnalysisInput& input) {
+  const TrackPoint point =
+      peak_tracker_.Track(input.psd.span(), input.window_end);
+  absl::MutexLock lock(&peak_track_mutex_);
+  peak_track_.push_back(point);
+}
+
+std::vector<TrackPoint> Model::PeakTrack(std::int64_t begin,
+                                         std::int64_t end) const {
+  absl::MutexLock lock(&peak_track_mutex_);
+  const auto size = static_cast<std::int64_t>(peak_track_.size());
+  begin = std::clamp<std::int64_t>(begin, 0, size);
+  end = std::clamp<std::int64_t>(end, begin, size);
+  return std::vector<TrackPoint>(peak_track_.begin() + begin,
+                                 peak_track_.begin() + end);
+}
+
+void Model::AppendOnset(const AnalysisInput& input) {
+  const std::optional<OnsetEvent> onset =
+      onset_detector_.Add(input.psd.span(), input.window_end);
+  if (!onset) {
+    return;
+  }
+  // The onset belongs to the previous column.
+  absl::MutexLock lock(&onsets_mutex_);
+  onsets_.push_back({.column = input.column - 1, .event = *onset});
+}
+
+std::vector<Model::Onset> Model::Onsets(std::int64_t begin,
+                                        std::int64_t end) const {
+  absl::MutexLock lock(&onsets_mutex_);
+  auto column = [](const Onset& onset) { return onset.column; };
+  const auto first = std::ranges::lower_bound(onsets_, begin, {}, column);
+  const auto last = std::ranges::lower_bound(first, onsets_.end(),
+                                             std::max(begin, end), {}, column);
+  return std::vector<Onset>(first, last);
+}
+
+QImage Model::RenderDoa() const {
+  if (channels_ == 1) {
+    return QImage();
+  }
+  absl::MutexLock lock(&doa_mutex_);
+  QImage image(doa_data_.width(), doa_data_.height(), QImage::Format_RGB32);
+  // Negative lags at the bottom, like low frequencies.
+  auto dest = EigenView(image).colwise().reverse();
+  const auto older = doa_data_.Older();
+  const auto newer = doa_data_.Newer();
+  const std::span<const std::uint32_t, 256> lut = active_colormap_->entries;
   LutMap(older, dest.leftCols(older.cols()), lut);
+  LutMap(newer, dest.rightCols(newer.cols()), lut);
   return image;
 }
 
+void Model::PublishSnapshot(std::int64_t view_end) {
+  const SpectrumOptions spectrum_options = spectrum_config_.Get();
+  snapshot_.Store({.sample_rate = sample_rate_,
+                   .fft_window_size = spectrum_options.window_size,
+                   .hop_size = HopSize(spectrum_options),
+                   .width = static_cast<int>(width_),
+                   .height = static_cast<int>(height_),
+                   .history_columns = history_.columns(),
+                   .view_end = view_end});
+}
+
+std::optional<double> Model::Power(std::int64_t column,
+                                   std::size_t bin) const {
+  if (const auto level = recent_columns_.Read(column, bin)) {
+    return PowerFromLogLevel(*level);
+  }
+  return std::nullopt;
+}
+
+std::optional<double> Model::PowerDecibels(std::int64_t column,
+                                           std::size_t bin) const {
+  const std::optional<double> power = Power(column, bin);
+  if (!power) {
+    return std::nullopt;
+  }
+  const double powers[] = {*power, PowerFromLogLevel(1)};
+  double decibels[2];
+  PowerToDecibels(powers, decibels);
+  return std::max(decibels[0], decibels[1]);
+}
+
+void Model::UpdateDisplayLut() {
+  const double min = auto_range_.min();
+  const double max = auto_range_.max();
+  if (min != display_lut_min_ || max != display_lut_max_) {
+    display_lut_min_ = min;
+    display_lut_max_ = max;
+    BuildDisplayLut(active_colormap_->entries, display_lut_min_,
+                    display_lut_max_, display_lut_);
+    ++display_lut_version_;
+  }
+}
+
+void Model::SetViewport(QRect viewport) {
+  absl::MutexLock lock(&viewport_mutex_);
+  viewport_ = viewport;
+}
+
+QRect Model::Viewport() {
+  absl::MutexLock lock(&viewport_mutex_);
+  return viewport_;
+}
+
+bool Model::CanReuseFrame(int level, QRect crop,
+                          std::int64_t scroll_position) const {
+  return last_frame_lut_version_ == display_lut_version_ &&
+         !last_frame_.isNull() && FrameLevel(last_frame_) == level &&
+         last_frame_.offset() == crop.topLeft() &&
+         last_frame_.size() == crop.size() &&
+         FrameScrollPosition(last_frame_) == scroll_position;
+}
+
+QImage Model::RememberFrame(QImage image) {
+  last_frame_ = image;
+  last_frame_lut_version_ = display_lut_version_;
+  return image;
+}
+
+QImage Model::Render() {
+  UpdateDisplayLut();
+  if (const std::int64_t end = history_end_; end != kFollowLive) {
+    return RenderHistory(end);
+  }
+  PublishSnapshot(history_.columns());
+  const int level = std::clamp(level_of_detail_.load(), 0,
+                               static_cast<int>(level_data_.levels()) - 1);
+  const CircularBuffer<std::uint16_t>& data = level_data_.level(level);
+  const QRect crop = LevelCrop(Viewport(), imageSize(), level,
+                               QSize(data.width(), data.height()));
+  const std::int64_t scroll_position = history_.columns() >> level;
+  if (CanReuseFrame(level, crop, scroll_position)) {
+    return last_frame_;
+  }
+  QImage image = frame_pool_.Acquire(crop.size());
+  SetFrameGeometry(image, level, crop.topLeft());
+  SetFrameScrollPosition(image, scroll_position);
+  SetFrameColors(image, display_lut_version_);
+  RenderCrop(data.Older(), data.Newer(), crop, display_lut_, image);
+  return RememberFrame(std::move(image));
+}
+
+QImage Model::RenderHistory(std::int64_t end) {
+  end = std::clamp<std::int64_t>(end, 0, history_.columns());
+  PublishSnapshot(end);
+  const std::int64_t first = end - static_cast<std::int64_t>(width_);
+
+  // Load the tiles we're about to scroll into while the user is still looking
+  // at the current ones.
+  if (end < previous_history_end_) {
+    history_.Prefetch(std::max<std::int64_t>(first, 0), -1);
+  } else if (end > previous_history_end_) {
+    history_.Prefetch(end, 1);
+  }
+  previous_history_end_ = end;
+
+  // Only read the visible columns.
+  const QRect crop = LevelCrop(Viewport(), imageSize(), 0, imageSize());
+  if (CanReuseFrame(0, crop, end)) {
+    return last_frame_;
+  }
+  Eigen::Array<std::uint16_t, Eigen::Dynamic, Eigen::Dynamic> window(
+      height_, crop.width());
+  window.setZero();
+  for (int x = 0; x < crop.width(); ++x) {
+    const std::int64_t c = first + crop.x() + x;
+    if (c >= 0) {
+      history_.ReadColumn(c, std::span(window.col(x).data(), height_));
+    }
+  }
+
+  QImage image = frame_pool_.Acquire(crop.size());
+  SetFrameGeometry(image, 0, crop.topLeft());
+  SetFrameScrollPosition(image, end);
+  SetFrameColors(image, display_lut_version_);
+  RenderCrop(window, window.rightCols(0), crop.translated(-crop.x(), 0),
+             display_lut_, image);
+  return RememberFrame(std::move(image));
+}
+
 namespace {
-AsyncGenerator<QImage> PacedFrames(Rational refresh_rate,
-                                   AsyncGenerator<QImage> frames) {
-  FrameScheduler scheduler(refresh_rate);
+AsyncGenerator<DisplayFrame> PacedFrames(
+    Rational refresh_rate, FrameCounters& counters,
+    AsyncGenerator<DisplayFrame> frames) {
+  AdaptiveFrameScheduler scheduler(refresh_rate, {}, &counters);
   SerialExecutor executor;
-  while (QImage* frame = co_await frames) {
+  while (DisplayFrame* frame = co_await frames) {
     const absl::Time arrival_time = absl::Now();
-    const absl::Time render_time = scheduler.Schedule(arrival_time);
+    const auto [render_time, drop] = scheduler.Schedule(arrival_time);
+    if (drop) {
+      continue;
+    }
     co_await executor.Sleep(render_time);
     co_yield std::move(*frame);
   }
@@ -77,28 +560,42 @@ AsyncGenerator<QImage> PacedFrames(Rational refresh_rate,
 
 }  // namespace
 
-AsyncGenerator<QImage> Model::Run() {
-  auto source = RampSource({.sample_rate = sample_rate_,
-                            .ramp_period = absl::Seconds(10),
-                            .frequency_min = 100,
-                            .frequency_max = 5000,
-                            .pacing = SimulatedSourcePacing::kRealTime});
-  auto spectra = PowerSpectrum({.sample_rate = sample_rate_,
-                                .window_size = fft_window_size_,
-                                .window_function = WindowFunction::kHann},
-                               std::move(source));
-  const Rational source_frame_period = {
-      static_cast<std::int64_t>(fft_window_size_),
-      static_cast<std::int64_t>(sample_rate_)};
-  auto rendered = std::move(spectra).Map([this](Buffer<double> spectrum) {
-    AppendSpectrum(std::move(spectrum));
+AsyncGenerator<DisplayFrame> Model::Run() {
+  // Simulated channels form a linear array, which the sweep reaches one
+  // microphone after another, 2 samples apart.
+  return Run(RampSource({.sample_rate = sample_rate_,
+                         .ramp_period = absl::Seconds(10),
+                         .frequency_min = 100,
+                         .frequency_max = 5000,
+                         .pacing = SimulatedSourcePacing::kRealTime,
+                         .channels = channels_,
+                         .channel_delay = absl::Seconds(2) / sample_rate_}));
+}
+
+AsyncGenerator<DisplayFrame> Model::Run(
+    AsyncGenerator<Buffer<std::int16_t>> source) {
+  auto planar = Deinterleaved(channels_, std::move(source), &spectrum_pool_);
+  auto spectra = MultichannelSpectra(spectrum_config_, fft_plans_,
+                                     spectrum_pool_, std::move(planar));
+  // The direction of arrival reuses the FFTs of the spectrogram.
+  auto rendered = std::move(spectra).Map([this](ChannelSpectra spectra) {
+    if (channels_ > 1) {
+      AppendDoa(spectra.fft);
+    }
+    // Analysed on another thread, so that rendering doesn't wait for it.
+    QueueAnalysis(history_.columns(), spectra);
+    SubtractNoise(spectra.power);
+    RecordHop(spectra.window_end);
+    AppendSpectra(std::move(spectra.power));
     return Render();
   });
 
-  auto interpolated =
-      Interpolate(std::move(rendered), source_frame_period, refresh_period_);
+  auto interpolated = Interpolate(
+      std::move(rendered), [this] { return SpectrumPeriod(); },
+      refresh_period_, interpolation_);
 
-  auto paced = PacedFrames(refresh_period_, std::move(interpolated));
+  auto paced =
+      PacedFrames(refresh_period_, frame_counters_, std::move(interpolated));
 
   return std::move(paced);
 }
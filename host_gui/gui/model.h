@@ -1,56 +1,422 @@
 #pragma once
 
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
 #include <absl/time/time.h>
 
 #include <QImage>
+#include <QRect>
 #include <QSize>
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <thread>
 #include <vector>
 
+#include "audio/gcc_phat.h"
+#include "audio/noise_reduction.h"
+#include "audio/onset_detector.h"
+#include "audio/peak_tracker.h"
+#include "audio/spectrum.h"
 #include "colormaps.h"
 #include "diy/buffer.h"
 #include "diy/coro/async_generator.h"
 #include "diy/rational.h"
+#include "diy/seqlock.h"
+#include "diy/worker_pool.h"
+#include "image/auto_range.h"
 #include "image/circular_buffer.h"
+#include "image/frame_geometry.h"
+#include "image/frame_pool.h"
+#include "image/frame_scheduler.h"
+#include "image/interpolate.h"
+#include "image/lut.h"
+#include "image/mip_pyramid.h"
+#include "image/recent_columns.h"
+#include "image/tiled_history.h"
 
 class Model {
  public:
   struct Options {
     double sample_rate = 24'000;
+    // Number of input channels, whose spectra are computed in parallel.
+    std::size_t channels = 1;
+    // Range of time differences of arrival between channels, in samples, see
+    // RenderDoa().
+    std::size_t doa_max_lag = 8;
+    // Dominant frequency and pitch tracking of channel 0, see PeakTrack().
+    PeakTrackerOptions peak_tracker = {};
+    // Onset detection on channel 0, see Onsets().
+    OnsetDetectorOptions onset_detector = {};
+    // Spectral subtraction of each channel's noise floor from displayed
+    // spectra, see SetNoiseReduction(). Peak and onset tracking see the
+    // unmodified spectra.
+    NoiseReductionOptions noise_reduction = {};
+    bool reduce_noise = false;
+    // Initial FFT parameters.
     std::size_t fft_window_size = 2028;
+    WindowFunction window_function = WindowFunction::kHann;
+    std::size_t hop_size = 0;
+    // FFT sizes offered for SetSpectrumOptions(), along with the initial size.
+    // All of them are planned at startup, so that switching sizes never waits
+    // for the planner while it's tuning. The display has a row per frequency
+    // bin of the largest of them, see SetSpectrumOptions().
+    std::vector<std::size_t> fft_window_sizes = {512, 1024, 2048, 4096, 8192};
+    // FFTW wisdom file, see FftPlanCache. Empty disables persistence.
+    std::filesystem::path fft_wisdom_path;
+    // Effort of FFT plans tuned in the background.
+    PlannerEffort fft_planner_effort = PlannerEffort::kEstimate;
     Rational refresh_period = {1, 60};
+    InterpolationMode interpolation = InterpolationMode::kScroll;
+    AutoRange::Options auto_range = {};
+    TiledHistory::Options history = {};
+  };
+
+  // Parameters and view state published by the pipeline for other threads.
+  struct Snapshot {
+    double sample_rate = 0;
+    std::size_t fft_window_size = 0;
+    std::size_t hop_size = 0;
+    int width = 0;
+    int height = 0;
+    // Total number of spectrum columns recorded.
+    std::int64_t history_columns = 0;
+    // History column index just past the right edge of the displayed view.
+    std::int64_t view_end = 0;
   };
 
   Model();
   Model(const Options& options);
+  ~Model();
 
-  AsyncGenerator<QImage> Run();
+  // Runs the pipeline on a simulated recording of a repeating frequency sweep.
+  AsyncGenerator<DisplayFrame> Run();
+  // Runs the pipeline on `source`, which yields interleaved frames of
+  // `channels` samples at the sample rate.
+  AsyncGenerator<DisplayFrame> Run(AsyncGenerator<Buffer<std::int16_t>> source);
 
   double FrequencyBin(std::size_t i) const { return frequency_bins_.at(i); }
   std::span<const double> FrequencyBins() const { return frequency_bins_; }
 
-  absl::Duration TimeDelta(std::int64_t n) const;
+  std::size_t channels() const noexcept { return channels_; }
+
+  // Sorted FFT sizes planned at startup, including the initial size.
+  std::span<const std::size_t> FftWindowSizes() const {
+    return fft_window_sizes_;
+  }
+
+  // Fills future columns with the spectrum of `channel` alone. Out-of-range
+  // channels are clamped. May be called from any thread.
+  void ShowChannel(int channel) { displayed_channel_ = channel; }
+
+  // Stacks the spectra of all channels in future columns, each resampled onto
+  // its own band of rows, with channel 0 at the bottom. This is the initial
+  // layout. May be called from any thread.
+  void ShowAllChannels() { displayed_channel_ = kAllChannels; }
+
+  // Subtracts each channel's noise floor from future columns. The noise floor
+  // is learned whether or not this is enabled, so it takes effect immediately.
+  // May be called from any thread.
+  void SetNoiseReduction(bool enabled) { reduce_noise_ = enabled; }
+  bool NoiseReductionEnabled() const { return reduce_noise_; }
+
+  struct RowInfo {
+    int channel;
+    double frequency;
+  };
+
+  // Channel and frequency displayed in row `row`, counting from the bottom of
+  // the image, in the channel layout that history column `column` was
+  // recorded with. Columns not recorded yet have the current layout. May be
+  // called from any thread.
+  RowInfo DescribeRow(std::int64_t column, std::size_t row) const
+      ABSL_LOCKS_EXCLUDED(layout_mutex_);
+
+  // Time from the latest history column to `n` columns later, negative for
+  // earlier columns. Recorded columns count with the hop size they were
+  // computed with, and any others with the current one. May be called from
+  // any thread.
+  absl::Duration TimeDelta(std::int64_t n) const
+      ABSL_LOCKS_EXCLUDED(hops_mutex_);
+
+  // Changes the FFT size, window function and hop size of the running
+  // pipeline, from the next spectrum onwards. The sample rate is fixed, so
+  // `options.sample_rate` is ignored. Throws std::invalid_argument for invalid
+  // options. May be called from any thread.
+  //
+  // The display's frequency axis has a row per bin of the largest size in
+  // FftWindowSizes(), so that each of those sizes is shown at its full
+  // resolution, and history recorded with any of them lines up without being
+  // resampled. Spectra of smaller sizes are interpolated onto the axis, and
+  // those of sizes that weren't offered max-pooled if larger.
+  void SetSpectrumOptions(SpectrumOptions options);
+
+  // The FFT parameters most recently requested via SetSpectrumOptions(). May be
+  // called from any thread.
+  SpectrumOptions CurrentSpectrumOptions() const {
+    return spectrum_config_.Get();
+  }
 
   QSize imageSize() const noexcept { return QSize(width_, height_); }
 
+  // Selects the level of the history pyramid that future frames are rendered
+  // from. Level N frames are downscaled by 2^N along each axis. Out-of-range
+  // levels are clamped. May be called from any thread.
+  void SetLevelOfDetail(int level) { level_of_detail_ = level; }
+
+  // Total number of spectrum columns recorded, including those that have
+  // scrolled out of the live view. May be called from any thread.
+  std::int64_t HistoryColumns() const { return history_.columns(); }
+
+  // Renders future frames from recorded history instead of the live view, with
+  // the column before `end` at the right edge. May be called from any thread.
+  void ScrollHistory(std::int64_t end) { history_end_ = end; }
+
+  // Returns to rendering the live view. May be called from any thread.
+  void FollowLive() { history_end_ = kFollowLive; }
+
+  // Restricts future frames to the given region of the logical image, plus a
+  // margin, e.g. the part visible through a scroll area. Frames carry their
+  // position as frame_geometry.h metadata. May be called from any thread.
+  void SetViewport(QRect viewport) ABSL_LOCKS_EXCLUDED(viewport_mutex_);
+
+  // The most recently published Snapshot. May be called from any thread, and
+  // never blocks the pipeline.
+  Snapshot CurrentSnapshot() const { return snapshot_.Load(); }
+
+  // GCC-PHAT time differences of arrival between all pairs of channels, for
+  // the columns of the live view. Each row is one lag, from -doa_max_lag at
+  // the bottom to doa_max_lag at the top, and is brighter the more pairs
+  // agree on it. Columns of windows too short for the lag range are blank.
+  // Null with a single channel. May be called from any thread.
+  QImage RenderDoa() const ABSL_LOCKS_EXCLUDED(doa_mutex_);
+
+  // Dominant frequency and pitch of channel 0 in history columns [begin, end),
+  // clamped to the analysed columns. Columns are analysed on a separate
+  // thread, which may lag slightly behind the image. May be called from any
+  // thread.
+  std::vector<TrackPoint> PeakTrack(std::int64_t begin, std::int64_t end) const
+      ABSL_LOCKS_EXCLUDED(peak_track_mutex_);
+
+  // Blocks until the analysis thread has caught up with the columns recorded
+  // so far, see PeakTrack() and Onsets().
+  void WaitForAnalysis() ABSL_LOCKS_EXCLUDED(analysis_mutex_);
+
+  struct Onset {
+    // History column of the spectrum at which the onset was detected.
+    std::int64_t column;
+    OnsetEvent event;
+  };
+
+  // Onsets of channel 0 in history columns [begin, end). Onsets are confirmed
+  // one column late, see OnsetDetector, and analysed like PeakTrack(). May be
+  // called from any thread.
+  std::vector<Onset> Onsets(std::int64_t begin, std::int64_t end) const
+      ABSL_LOCKS_EXCLUDED(onsets_mutex_);
+
+  // Fractional row, counting from the bottom of the image, at which `channel`
+  // displays `frequency` in history column `column`, see DescribeRow(). Null
+  // if `channel` isn't displayed there. May be called from any thread.
+  std::optional<double> FrequencyRow(std::int64_t column, std::size_t channel,
+                                     double frequency) const
+      ABSL_LOCKS_EXCLUDED(layout_mutex_);
+
+  // PSD of frequency bin `bin` in history column `column`, if that column is
+  // recent enough to be read without blocking the pipeline. May be called from
+  // any thread.
+  std::optional<double> Power(std::int64_t column, std::size_t bin) const;
+
+  // Power() in decibels. Levels below the quietest that can be told apart
+  // from silence, including empty bins, read as that level rather than
+  // -infinity. May be called from any thread.
+  std::optional<double> PowerDecibels(std::int64_t column,
+                                      std::size_t bin) const;
+
+  // Counts of frames that were paced on time, late, or dropped. May be read
+  // from any thread.
+  const FrameCounters& PacingCounters() const { return frame_counters_; }
+
  private:
-  void AppendSpectrum(Buffer<double> spectrum);
+  static constexpr std::int64_t kFollowLive = -1;
+  static constexpr int kAllChannels = -1;
+
+  // Rows [first, first + rows) of a column show `channel` when all channels
+  // are stacked.
+  struct ChannelBand {
+    std::size_t first;
+    std::size_t rows;
+  };
+  ChannelBand StackedBand(std::size_t channel) const;
+  // Channel displayed alone in history column `column`, clamped to the
+  // available channels, or kAllChannels.
+  int ColumnLayout(std::int64_t column) const
+      ABSL_LOCKS_EXCLUDED(layout_mutex_);
+
+  // Input frame period of the interpolation stage, i.e. the current hop size.
+  Rational SpectrumPeriod() const;
+
+  // Updates the noise floor estimate of each channel's spectrum, and subtracts
+  // it if noise reduction is enabled.
+  void SubtractNoise(std::span<Buffer<double>> spectra);
+  // Records the hop from the previous column's window to that of the column
+  // about to be appended, which ends just before sample `window_end`.
+  void RecordHop(std::int64_t window_end) ABSL_LOCKS_EXCLUDED(hops_mutex_);
+  // Appends a column composed of one spectrum per channel.
+  void AppendSpectra(std::vector<Buffer<double>> spectra);
+  // Appends the GCC-PHAT histogram of one window's channel FFTs.
+  void AppendDoa(std::span<const Buffer<std::complex<double>>> fft)
+      ABSL_LOCKS_EXCLUDED(doa_mutex_);
+  // Channel 0's spectrum of a history column, queued for peak tracking and
+  // onset detection.
+  struct AnalysisInput {
+    std::int64_t column;
+    // See ChannelSpectra.
+    std::int64_t window_end;
+    Buffer<double> psd;
+  };
+  // Queues channel 0's spectrum of history column `column` for AnalysisLoop().
+  void QueueAnalysis(std::int64_t column, const ChannelSpectra& spectra)
+      ABSL_LOCKS_EXCLUDED(analysis_mutex_);
+  bool AnalysisReady() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(analysis_mutex_);
+  bool AnalysisIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(analysis_mutex_);
+  // Tracks peaks and detects onsets of queued spectra, off the pipeline
+  // thread.
+  void AnalysisLoop() ABSL_LOCKS_EXCLUDED(analysis_mutex_);
+  void AppendPeak(const AnalysisInput& input)
+      ABSL_LOCKS_EXCLUDED(peak_track_mutex_);
+  void AppendOnset(const AnalysisInput& input)
+      ABSL_LOCKS_EXCLUDED(onsets_mutex_);
+  void PublishSnapshot(std::int64_t view_end);
+
+  // Rebuilds `display_lut_` if the display range has changed.
+  void UpdateDisplayLut();
+
+  QRect Viewport() ABSL_LOCKS_EXCLUDED(viewport_mutex_);
+
+  // Whether `last_frame_` is identical to the frame that would be rendered
+  // with the given geometry and scroll position.
+  bool CanReuseFrame(int level, QRect crop, std::int64_t scroll_position) const;
+  QImage RememberFrame(QImage image);
 
   QImage Render();
+  QImage RenderHistory(std::int64_t end);
 
   const double sample_rate_;
+  const std::size_t channels_;
+  // Initial FFT size.
   const std::size_t fft_window_size_;
+  std::vector<std::size_t> fft_window_sizes_;
   const Rational refresh_period_;
+  const InterpolationMode interpolation_;
+  // FFT parameters of the PowerSpectrum() stage, which may be changed while
+  // it's running.
+  SpectrumConfig spectrum_config_;
+  FftPlanCache fft_plans_;
+  // Deinterleaves input and computes per-channel spectra.
+  WorkerPool spectrum_pool_;
+  std::atomic<int> displayed_channel_ = kAllChannels;
+  // One per channel.
+  std::vector<NoiseReducer> noise_reducers_;
+  std::atomic<bool> reduce_noise_;
+  const GccPhatOptions gcc_phat_options_;
+  // Only used by AppendDoa(), on the pipeline's thread.
+  GccPhatScratch gcc_phat_scratch_;
+  // Frequency axis of the display, that of the largest FFT size in
+  // `fft_window_sizes_`. Fixed, so that history recorded with different FFT
+  // sizes lines up.
   const std::vector<double> frequency_bins_;
   const std::size_t width_;
   const std::size_t height_;
 
-  // Audio data in log(psd) form.
-  CircularBuffer<double> spectrum_data_;
-  // Same data as above, but bucketed into [0, 255] values based on the global
-  // min and max observed spectrum values.
-  CircularBuffer<std::uint8_t> indexed_data_;
-  double min_value_;
-  double max_value_;
+  // Audio data in log(psd) form, quantized into the fixed ToLogLevels() domain.
+  // PowerFromLogLevel() recovers PSD values for readouts. Because this
+  // quantization doesn't depend on the observed range of values, changes to the
+  // display range only require rebuilding `display_lut_`.
+  // Downscaled copies are maintained for rendering zoomed-out views.
+  MipPyramid<std::uint16_t> level_data_;
+  std::atomic<int> level_of_detail_ = 0;
+  // Complete record of `level_data_` level 0, for scrolling back past the
+  // live view.
+  TiledHistory history_;
+  std::atomic<std::int64_t> history_end_ = kFollowLive;
+  // `end` of the previously rendered history frame, for determining the scroll
+  // direction.
+  std::int64_t previous_history_end_ = 0;
+  // Lock-free copy of the live view's columns, for readouts from other
+  // threads.
+  RecentColumns recent_columns_;
+  SeqLock<Snapshot> snapshot_;
+  // Tracks the recent noise floor and peak level of `level_data_`, which
+  // determine the display range.
+  AutoRange auto_range_;
   const ColorMap* active_colormap_ = &colormaps()[0];
+  // Maps `level_data_` values to colors according to the display range and
+  // colormap it was last built for.
+  std::array<std::uint32_t, kLogLevels> display_lut_;
+  double display_lut_min_;
+  double display_lut_max_;
+  // Incremented whenever `display_lut_` is rebuilt.
+  std::int64_t display_lut_version_ = 0;
+
+  // Most recently rendered frame, reused when nothing visible has changed
+  // (e.g. no new column at a downscaled level, or a parked history view).
+  QImage last_frame_;
+  std::int64_t last_frame_lut_version_ = -1;
+
+  // TDOA histograms of the live view's columns, scaled to [0, 255].
+  mutable absl::Mutex doa_mutex_;
+  CircularBuffer<std::uint8_t> doa_data_ ABSL_GUARDED_BY(doa_mutex_);
+
+  // Runs of history columns recorded with the same hop size, i.e. distance in
+  // samples from the previous column's window, each starting at `column`.
+  // Column 0 has no hop, so the first run starts at column 1.
+  struct HopRun {
+    std::int64_t column;
+    std::int64_t hop;
+  };
+  // Runs of history columns recorded with the same channel layout, each
+  // starting at `column`, see ColumnLayout().
+  struct LayoutRun {
+    std::int64_t column;
+    int channel;
+  };
+  mutable absl::Mutex layout_mutex_;
+  std::vector<LayoutRun> layout_runs_ ABSL_GUARDED_BY(layout_mutex_);
+  std::int64_t layout_columns_ ABSL_GUARDED_BY(layout_mutex_) = 0;
+
+  mutable absl::Mutex hops_mutex_;
+  std::vector<HopRun> hop_runs_ ABSL_GUARDED_BY(hops_mutex_);
+  std::int64_t hop_columns_ ABSL_GUARDED_BY(hops_mutex_) = 0;
+  std::int64_t last_window_end_ ABSL_GUARDED_BY(hops_mutex_) = 0;
+
+  absl::Mutex analysis_mutex_;
+  std::deque<AnalysisInput> analysis_queue_ ABSL_GUARDED_BY(analysis_mutex_);
+  // Whether the analysis thread is working on a dequeued column.
+  bool analysing_ ABSL_GUARDED_BY(analysis_mutex_) = false;
+  bool analysis_stopping_ ABSL_GUARDED_BY(analysis_mutex_) = false;
+
+  // Only used by the analysis thread.
+  PeakTracker peak_tracker_;
+  // One track point per history column.
+  mutable absl::Mutex peak_track_mutex_;
+  std::vector<TrackPoint> peak_track_ ABSL_GUARDED_BY(peak_track_mutex_);
+
+  // Only used by the analysis thread.
+  OnsetDetector onset_detector_;
+  // Ordered by column.
+  mutable absl::Mutex onsets_mutex_;
+  std::vector<Onset> onsets_ ABSL_GUARDED_BY(onsets_mutex_);
+
+  absl::Mutex viewport_mutex_;
+  QRect viewport_ ABSL_GUARDED_BY(viewport_mutex_);
+
+  FrameCounters frame_counters_;
+  // Rendered frames are returned here once the viewer is done with them.
+  FramePool frame_pool_;
+
+  std::jthread analysis_thread_;
 };
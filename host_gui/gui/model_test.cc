@@ -1,19 +1,387 @@
 #include "model.h"
 
+#include <absl/time/time.h>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "diy/coro/task.h"
+
+namespace {
+// 16-sample windows at 10 Hz, and no other FFT sizes, so that the display has
+// 9 rows from 0 to 5 Hz.
+Model::Options SmallOptions(std::size_t channels = 1) {
+  return {.sample_rate = 10.0,
+          .channels = channels,
+          .fft_window_size = 16,
+          .fft_window_sizes = {}};
+}
+}  // namespace
+
 TEST(ModelTest, FrequencyBins) {
-  Model model({.sample_rate = 10.0, .fft_window_size = 16});
+  Model model(SmallOptions());
   EXPECT_EQ(model.FrequencyBin(0), 0.0);
   EXPECT_EQ(model.FrequencyBin(4), 2.5);
   EXPECT_EQ(model.FrequencyBin(8), 5.0);
 }
 
 TEST(ModelTest, TimeDelta) {
-  Model model({.sample_rate = 10.0, .fft_window_size = 16});
+  Model model(SmallOptions());
   EXPECT_EQ(model.TimeDelta(0), absl::ZeroDuration());
   // 16 samples per window @ 10Hz
   EXPECT_EQ(model.TimeDelta(1), absl::Milliseconds(1600));
   EXPECT_EQ(model.TimeDelta(10), absl::Seconds(16));
 }
+
+TEST(ModelTest, TimeDeltaAcrossHopChange) {
+  Model model({.fft_window_size = 512, .hop_size = 128});
+  auto frames = model.Run();
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(Task(frames).Wait(), nullptr);
+  }
+  model.SetSpectrumOptions({.window_size = 512, .hop_size = 512});
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(Task(frames).Wait(), nullptr);
+  }
+  // The pipeline is paused between frames, so the analysis thread catches up
+  // with the recorded columns.
+  model.WaitForAnalysis();
+  const std::int64_t columns = model.CurrentSnapshot().history_columns;
+  const std::vector<TrackPoint> track = model.PeakTrack(0, columns);
+  ASSERT_EQ(std::ssize(track), columns);
+  // Track points are timestamped with the end of each column's window.
+  for (std::int64_t n = 1; n < columns; ++n) {
+    const absl::Duration expected =
+        track[columns - 1 - n].timestamp - track.back().timestamp;
+    EXPECT_LT(absl::AbsDuration(model.TimeDelta(-n) - expected),
+              absl::Microseconds(1))
+        << n;
+  }
+}
+
+TEST(ModelTest, SpectrumOptionsChange) {
+  Model model({.sample_rate = 10.0,
+               .fft_window_size = 16,
+               .fft_window_sizes = {32}});
+  // The display has a row per bin of the largest offered size.
+  EXPECT_EQ(model.imageSize().height(), 17);
+  EXPECT_EQ(model.FrequencyBin(16), 5.0);
+  model.SetSpectrumOptions({.window_size = 32, .hop_size = 8});
+  EXPECT_EQ(model.CurrentSpectrumOptions().sample_rate, 10.0);
+  EXPECT_EQ(model.CurrentSpectrumOptions().window_size, 32);
+  // 8 samples per hop @ 10Hz
+  EXPECT_EQ(model.TimeDelta(1), absl::Milliseconds(800));
+  EXPECT_EQ(model.imageSize().height(), 17);
+}
+
+TEST(ModelTest, LargerFftSizeResolvesMoreRows) {
+  Model model({.fft_window_size = 512, .fft_window_sizes = {1024}});
+  ASSERT_EQ(model.imageSize().height(), 513);
+  auto frames = model.Run();
+  // Rows within 6 dB of the sweep's peak in the latest column.
+  auto peak_rows = [&] {
+    const std::int64_t column = model.CurrentSnapshot().history_columns - 1;
+    std::vector<double> power;
+    for (int row = 0; row < model.imageSize().height(); ++row) {
+      power.push_back(model.Power(column, row).value_or(0));
+    }
+    const double peak = std::ranges::max(power);
+    return std::ranges::count_if(power, [&](double p) { return p > peak / 4; });
+  };
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_NE(Task(frames).Wait(), nullptr);
+  }
+  const auto coarse = peak_rows();
+  model.SetSpectrumOptions({.window_size = 1024});
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_NE(Task(frames).Wait(), nullptr);
+  }
+  EXPECT_LT(peak_rows(), coarse);
+}
+
+TEST(ModelTest, FftWindowSizes) {
+  Model model({.sample_rate = 10.0,
+               .fft_window_size = 16,
+               .fft_window_sizes = {64, 8, 16, 32}});
+  EXPECT_THAT(model.FftWindowSizes(), testing::ElementsAre(8, 16, 32, 64));
+}
+
+TEST(ModelTest, InvalidSpectrumOptionsThrow) {
+  Model model(SmallOptions());
+  EXPECT_THROW(model.SetSpectrumOptions({.window_size = 15}),
+               std::invalid_argument);
+  EXPECT_EQ(model.CurrentSpectrumOptions().window_size, 16);
+}
+
+TEST(ModelTest, InitialSnapshot) {
+  Model model(SmallOptions());
+  const Model::Snapshot snapshot = model.CurrentSnapshot();
+  EXPECT_EQ(snapshot.sample_rate, 10.0);
+  EXPECT_EQ(snapshot.fft_window_size, 16);
+  EXPECT_EQ(snapshot.hop_size, 16);
+  EXPECT_EQ(snapshot.width, model.imageSize().width());
+  EXPECT_EQ(snapshot.height, model.imageSize().height());
+  EXPECT_EQ(snapshot.history_columns, 0);
+  EXPECT_EQ(snapshot.view_end, 0);
+}
+
+TEST(ModelTest, NoPowerBeforeData) {
+  Model model(SmallOptions());
+  EXPECT_EQ(model.Power(0, 0), std::nullopt);
+  EXPECT_EQ(model.PowerDecibels(0, 0), std::nullopt);
+}
+
+TEST(ModelTest, PowerDecibelsAreFinite) {
+  Model model({.fft_window_size = 512});
+  auto frames = model.Run();
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_NE(Task(frames).Wait(), nullptr);
+  }
+  const Model::Snapshot snapshot = model.CurrentSnapshot();
+  const std::int64_t column = snapshot.history_columns - 1;
+  // The sweep leaves most bins near silence.
+  std::vector<double> decibels;
+  for (int bin = 0; bin < snapshot.height; ++bin) {
+    const std::optional<double> value = model.PowerDecibels(column, bin);
+    ASSERT_NE(value, std::nullopt);
+    ASSERT_TRUE(std::isfinite(*value)) << bin;
+    const double power = *model.Power(column, bin);
+    if (power > 1) {
+      EXPECT_NEAR(*value, 10 * std::log10(power), 1e-6) << bin;
+    }
+    decibels.push_back(*value);
+  }
+  EXPECT_GT(std::ranges::max(decibels), std::ranges::min(decibels));
+}
+
+TEST(ModelTest, MonoRows) {
+  Model model(SmallOptions());
+  EXPECT_EQ(model.channels(), 1);
+  const Model::RowInfo row = model.DescribeRow(0, 4);
+  EXPECT_EQ(row.channel, 0);
+  EXPECT_EQ(row.frequency, 2.5);
+}
+
+TEST(ModelTest, StackedChannelRows) {
+  Model model(SmallOptions(2));
+  // 9 rows: 4 for channel 0, and the remaining 5 for channel 1.
+  EXPECT_EQ(model.DescribeRow(0, 0).channel, 0);
+  EXPECT_EQ(model.DescribeRow(0, 0).frequency, 0.0);
+  EXPECT_EQ(model.DescribeRow(0, 3).channel, 0);
+  EXPECT_EQ(model.DescribeRow(0, 3).frequency, 5.0);
+  EXPECT_EQ(model.DescribeRow(0, 4).channel, 1);
+  EXPECT_EQ(model.DescribeRow(0, 4).frequency, 0.0);
+  EXPECT_EQ(model.DescribeRow(0, 6).frequency, 2.5);
+  EXPECT_EQ(model.DescribeRow(0, 8).channel, 1);
+  EXPECT_EQ(model.DescribeRow(0, 8).frequency, 5.0);
+}
+
+TEST(ModelTest, SelectedChannelRows) {
+  Model model(SmallOptions(2));
+  // Nothing is recorded yet, so rows follow the current layout.
+  model.ShowChannel(1);
+  EXPECT_EQ(model.DescribeRow(0, 0).channel, 1);
+  EXPECT_EQ(model.DescribeRow(0, 4).frequency, 2.5);
+  model.ShowChannel(5);
+  EXPECT_EQ(model.DescribeRow(0, 4).channel, 1);
+  model.ShowAllChannels();
+  EXPECT_EQ(model.DescribeRow(0, 0).channel, 0);
+}
+
+TEST(ModelTest, RowsFollowRecordedLayout) {
+  Model model({.channels = 2, .fft_window_size = 512});
+  auto frames = model.Run();
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_NE(Task(frames).Wait(), nullptr);
+  }
+  model.ShowChannel(1);
+  const std::int64_t stacked = model.CurrentSnapshot().history_columns;
+  ASSERT_GT(stacked, 0);
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_NE(Task(frames).Wait(), nullptr);
+  }
+  const std::int64_t columns = model.CurrentSnapshot().history_columns;
+  ASSERT_GT(columns, stacked);
+  // Channel 0 occupies the bottom half of columns recorded before the change.
+  const std::size_t row = 1;
+  EXPECT_EQ(model.DescribeRow(0, row).channel, 0);
+  EXPECT_EQ(model.DescribeRow(columns - 1, row).channel, 1);
+  EXPECT_NE(model.FrequencyRow(0, 0, 1000), std::nullopt);
+  EXPECT_EQ(model.FrequencyRow(columns - 1, 0, 1000), std::nullopt);
+}
+
+TEST(ModelTest, InvalidChannelCountThrows) {
+  EXPECT_THROW(Model({.channels = 0}), std::invalid_argument);
+}
+
+TEST(ModelTest, DoaImage) {
+  Model mono(SmallOptions());
+  EXPECT_TRUE(mono.RenderDoa().isNull());
+
+  Model::Options options = SmallOptions(4);
+  options.doa_max_lag = 3;
+  Model model(options);
+  const QImage doa = model.RenderDoa();
+  EXPECT_EQ(doa.width(), model.imageSize().width());
+  EXPECT_EQ(doa.height(), 7);
+}
+
+TEST(ModelTest, FrequencyRows) {
+  Model model(SmallOptions(2));
+  // Stacked bands of 4 and 5 rows, see StackedChannelRows.
+  EXPECT_EQ(model.FrequencyRow(0, 0, 5.0), 3.0);
+  EXPECT_EQ(model.FrequencyRow(0, 1, 2.5), 6.0);
+  EXPECT_EQ(model.FrequencyRow(0, 2, 2.5), std::nullopt);
+  model.ShowChannel(1);
+  EXPECT_EQ(model.FrequencyRow(0, 0, 2.5), std::nullopt);
+  EXPECT_EQ(model.FrequencyRow(0, 1, 2.5), 4.0);
+}
+
+TEST(ModelTest, PeakTrackFollowsSweep) {
+  constexpr double kSampleRate = 24'000;
+  constexpr std::size_t kWindowSize = 512;
+  Model model({.sample_rate = kSampleRate,
+               .fft_window_size = kWindowSize,
+               .fft_window_sizes = {}});
+  auto frames = model.Run();
+  for (int i = 0; i < 200 && model.CurrentSnapshot().history_columns < 20;
+       ++i) {
+    ASSERT_NE(Task(frames).Wait(), nullptr);
+  }
+  model.WaitForAnalysis();
+  const std::int64_t columns = model.CurrentSnapshot().history_columns;
+  ASSERT_GE(columns, 20);
+  const std::vector<TrackPoint> track = model.PeakTrack(0, columns);
+  // One point per history column.
+  ASSERT_EQ(std::ssize(track), columns);
+  const double bin_width = kSampleRate / kWindowSize;
+  for (std::int64_t column = 0; column < columns; ++column) {
+    const TrackPoint& point = track[column];
+    // RampSource's phase is that of a tone whose frequency rises linearly
+    // from 100 Hz to 5 kHz over 10 s, so its instantaneous frequency rises
+    // twice as fast.
+    const double center = absl::ToDoubleSeconds(point.timestamp) -
+                          kWindowSize / 2 / kSampleRate;
+    EXPECT_NEAR(point.frequency, 100 + 2 * 490 * center, bin_width) << column;
+    // The overlay draws the point on the column's brightest row.
+    const std::optional<double> row =
+        model.FrequencyRow(column, 0, point.frequency);
+    ASSERT_NE(row, std::nullopt);
+    std::size_t brightest = 0;
+    for (std::size_t bin = 0; bin < model.FrequencyBins().size(); ++bin) {
+      if (model.Power(column, bin) > model.Power(column, brightest)) {
+        brightest = bin;
+      }
+    }
+    EXPECT_NEAR(*row, brightest, 1) << column;
+  }
+}
+
+TEST(ModelTest, OnsetOnColumnOfFluxPeak) {
+  constexpr double kSampleRate = 24'000;
+  constexpr std::size_t kWindowSize = 512;
+  // Silence, then a tone from the start of window 10 onwards.
+  constexpr std::size_t kOnsetWindow = 10;
+  std::vector<std::int16_t> samples(30 * kWindowSize);
+  for (std::size_t i = kOnsetWindow * kWindowSize; i < samples.size(); ++i) {
+    samples[i] = std::lround(
+        10'000 * std::sin(2 * std::numbers::pi * 1000 * i / kSampleRate));
+  }
+  auto source = [](std::vector<std::int16_t> samples)
+      -> AsyncGenerator<Buffer<std::int16_t>> {
+    co_yield AdoptAsBuffer(std::move(samples));
+  }(std::move(samples));
+  Model model({.sample_rate = kSampleRate,
+               .fft_window_size = kWindowSize,
+               .fft_window_sizes = {}});
+  auto frames = model.Run(std::move(source));
+  while (Task(frames).Wait() != nullptr) {
+  }
+  model.WaitForAnalysis();
+  const std::int64_t columns = model.CurrentSnapshot().history_columns;
+  ASSERT_EQ(columns, 30);
+  // Confirmed by the next spectrum, but recorded on the column of the peak.
+  const std::vector<Model::Onset> onsets = model.Onsets(0, columns);
+  ASSERT_THAT(onsets, testing::SizeIs(1));
+  EXPECT_EQ(onsets[0].column, kOnsetWindow);
+  EXPECT_EQ(onsets[0].event.timestamp,
+            model.PeakTrack(0, columns).at(kOnsetWindow).timestamp);
+}
+
+TEST(ModelTest, NoiseReductionLearnsWhileDisabled) {
+  constexpr double kSampleRate = 24'000;
+  constexpr std::size_t kWindowSize = 512;
+  // White noise, joined by a tone on bin 20 from window 24 onwards.
+  constexpr std::size_t kToneWindow = 24;
+  constexpr std::size_t kWindows = 32;
+  constexpr std::size_t kToneBin = 20;
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise(0, 1000);
+  std::vector<std::int16_t> samples(kWindows * kWindowSize);
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    double sample = noise(rng);
+    if (i >= kToneWindow * kWindowSize) {
+      sample += 10'000 * std::sin(2 * std::numbers::pi * kToneBin * i /
+                                  kWindowSize);
+    }
+    samples[i] = std::lround(sample);
+  }
+  // Yields one window at a time. The pipeline drops the frames of such a
+  // burst, so noise reduction is enabled from here, once the tone has
+  // started, if `model` is given.
+  auto source = [&](Model* model) -> AsyncGenerator<Buffer<std::int16_t>> {
+    for (std::size_t w = 0; w < kWindows; ++w) {
+      if (model != nullptr && w == kToneWindow + 2) {
+        model->SetNoiseReduction(true);
+      }
+      co_yield AdoptAsBuffer(std::vector<std::int16_t>(
+          samples.begin() + w * kWindowSize,
+          samples.begin() + (w + 1) * kWindowSize));
+    }
+  };
+  const Model::Options options = {
+      .sample_rate = kSampleRate,
+      .noise_reduction = {.subwindows = 4, .subwindow_spectra = 4},
+      .fft_window_size = kWindowSize,
+      .fft_window_sizes = {}};
+  // Mean power of the last column's bins away from the tone, and the tone's
+  // level in decibels.
+  struct Levels {
+    double noise = 0;
+    double tone_decibels = 0;
+  };
+  auto run = [&](bool reduce) {
+    Model model(options);
+    auto frames = model.Run(source(reduce ? &model : nullptr));
+    while (Task(frames).Wait() != nullptr) {
+    }
+    const std::int64_t column = model.CurrentSnapshot().history_columns - 1;
+    EXPECT_EQ(column + 1, kWindows);
+    Levels levels;
+    const std::size_t bins = model.FrequencyBins().size();
+    levels.tone_decibels = model.PowerDecibels(column, kToneBin).value();
+    // Excludes the tone's leakage into its neighbours.
+    for (std::size_t bin = kToneBin + 3; bin < bins; ++bin) {
+      levels.noise += model.Power(column, bin).value() / (bins - kToneBin - 3);
+    }
+    return levels;
+  };
+  const Levels unreduced = run(false);
+  const Levels reduced = run(true);
+  EXPECT_LT(reduced.noise, 0.75 * unreduced.noise);
+  // The noise floor was learned before the tone started, while reduction was
+  // disabled, so the tone isn't mistaken for noise.
+  EXPECT_NEAR(reduced.tone_decibels, unreduced.tone_decibels, 3);
+}
+
+TEST(ModelTest, InvalidNoiseReductionOptionsThrow) {
+  EXPECT_THROW(Model({.noise_reduction = {.subwindows = 0}}),
+               std::invalid_argument);
+}
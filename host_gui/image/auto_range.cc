@@ -0,0 +1,76 @@
+#include "auto_range.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+// Once values are being added with this weight, the histogram is rescaled to
+// keep the weights within floating point range.
+constexpr double kRenormalizeWeight = 1e100;
+}  // namespace
+
+AutoRange::AutoRange(const Options& options)
+    : decay_(options.decay),
+      floor_{.quantile = options.floor_quantile},
+      peak_{.quantile = options.peak_quantile} {
+  if (!(decay_ > 0 && decay_ <= 1)) {
+    throw std::invalid_argument("Decay must be in range (0, 1].");
+  }
+}
+
+void AutoRange::Add(std::span<const std::uint16_t> levels) {
+  for (std::uint16_t level : levels) {
+    const std::size_t bucket = level >> kBucketShift;
+    histogram_[bucket] += weight_;
+    if (bucket < floor_.bucket) {
+      floor_.below += weight_;
+    }
+    if (bucket < peak_.bucket) {
+      peak_.below += weight_;
+    }
+  }
+  total_ += weight_ * levels.size();
+  Update(floor_);
+  Update(peak_);
+
+  weight_ /= decay_;
+  if (weight_ > kRenormalizeWeight) {
+    Renormalize();
+  }
+}
+
+void AutoRange::Update(Quantile& q) {
+  const double target = q.quantile * total_;
+  while (q.bucket > 0 && q.below > target) {
+    --q.bucket;
+    q.below -= histogram_[q.bucket];
+  }
+  while (q.bucket + 1 < kBuckets && q.below + histogram_[q.bucket] <= target) {
+    q.below += histogram_[q.bucket];
+    ++q.bucket;
+  }
+}
+
+void AutoRange::Renormalize() {
+  const double scale = 1 / weight_;
+  for (double& count : histogram_) {
+    count *= scale;
+  }
+  weight_ = 1;
+  // Recompute the sums from scratch rather than scaling them, which also
+  // discards any accumulated rounding error.
+  total_ = std::accumulate(histogram_.begin(), histogram_.end(), 0.0);
+  for (Quantile* q : {&floor_, &peak_}) {
+    q->below = std::accumulate(histogram_.begin(),
+                               histogram_.begin() + q->bucket, 0.0);
+  }
+}
+
+double AutoRange::min() const {
+  return FromLogLevel(floor_.bucket << kBucketShift);
+}
+
+double AutoRange::max() const {
+  return FromLogLevel(((peak_.bucket + 1) << kBucketShift) - 1);
+}
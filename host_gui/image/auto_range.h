@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "lut.h"
+
+// Tracks the noise floor and peak level of a stream of ToLogLevels() columns,
+// for use as an automatically adjusting display range.
+//
+// Values are accumulated into a histogram where older columns are
+// exponentially down-weighted, so that a single loud transient stops affecting
+// the range after a while. Rather than decaying every histogram bucket per
+// column, the weight of each new column is increased instead, and the histogram
+// is only renormalized once those weights grow large. Quantile estimates are
+// maintained incrementally by walking from their previous position, so the
+// per-column cost is one histogram increment per value plus a typically short
+// walk.
+class AutoRange {
+ public:
+  struct Options {
+    // Quantile of recent values treated as the noise floor, which becomes the
+    // bottom of the display range.
+    double floor_quantile = 0.5;
+    // Quantile of recent values treated as the peak level, which becomes the
+    // top of the display range.
+    double peak_quantile = 0.999;
+    // Relative weight a column retains for each subsequent column. Must be in
+    // (0, 1].
+    double decay = 0.995;
+  };
+
+  AutoRange() : AutoRange(Options()) {}
+  AutoRange(const Options& options);
+
+  void Add(std::span<const std::uint16_t> levels);
+
+  // Bottom of the display range, in log2(psd + 1) units.
+  double min() const;
+  // Top of the display range, in log2(psd + 1) units.
+  double max() const;
+
+ private:
+  // Each histogram bucket covers this many adjacent levels.
+  static constexpr int kBucketShift = 4;
+  static constexpr std::size_t kBuckets = kLogLevels >> kBucketShift;
+
+  struct Quantile {
+    double quantile;
+    // Bucket containing the quantile.
+    std::size_t bucket = 0;
+    // Total weight of all buckets below `bucket`.
+    double below = 0;
+  };
+
+  void Update(Quantile& quantile);
+  void Renormalize();
+
+  const double decay_;
+  std::array<double, kBuckets> histogram_ = {};
+  double total_ = 0;
+  // Weight of the next value added to the histogram.
+  double weight_ = 1;
+  Quantile floor_;
+  Quantile peak_;
+};
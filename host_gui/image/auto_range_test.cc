@@ -0,0 +1,65 @@
+#include "auto_range.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+// Width of a histogram bucket in log2(psd + 1) units.
+constexpr double kTolerance = FromLogLevel(16);
+
+TEST(AutoRangeTest, ConstantInput) {
+  AutoRange range;
+  const std::vector<std::uint16_t> column(100, 1000);
+  range.Add(column);
+  EXPECT_NEAR(range.min(), FromLogLevel(1000), kTolerance);
+  EXPECT_NEAR(range.max(), FromLogLevel(1000), kTolerance);
+  EXPECT_LT(range.min(), range.max());
+}
+
+TEST(AutoRangeTest, Quantiles) {
+  AutoRange range({.floor_quantile = 0.25, .peak_quantile = 0.75});
+  std::vector<std::uint16_t> column(kLogLevels);
+  for (std::size_t i = 0; i < column.size(); ++i) {
+    column[i] = i;
+  }
+  range.Add(column);
+  EXPECT_NEAR(range.min(), FromLogLevel(1024), kTolerance);
+  EXPECT_NEAR(range.max(), FromLogLevel(3072), kTolerance);
+}
+
+TEST(AutoRangeTest, TransientDecays) {
+  AutoRange range({.peak_quantile = 0.99, .decay = 0.9});
+  const std::vector<std::uint16_t> noise(100, 1000);
+  const std::vector<std::uint16_t> loud(100, 3000);
+  for (int i = 0; i < 10; ++i) {
+    range.Add(noise);
+  }
+  range.Add(loud);
+  EXPECT_NEAR(range.max(), FromLogLevel(3000), kTolerance);
+
+  for (int i = 0; i < 100; ++i) {
+    range.Add(noise);
+  }
+  EXPECT_NEAR(range.max(), FromLogLevel(1000), kTolerance);
+  EXPECT_NEAR(range.min(), FromLogLevel(1000), kTolerance);
+}
+
+// Many columns with a fast decay should trigger renormalization without
+// disturbing the estimates.
+TEST(AutoRangeTest, LongRunningStream) {
+  AutoRange range(
+      {.floor_quantile = 0.25, .peak_quantile = 0.99, .decay = 0.9});
+  const std::vector<std::uint16_t> quiet(100, 500);
+  const std::vector<std::uint16_t> loud(100, 2500);
+  for (int i = 0; i < 5000; ++i) {
+    range.Add(i % 2 == 0 ? quiet : loud);
+  }
+  EXPECT_NEAR(range.min(), FromLogLevel(500), kTolerance);
+  EXPECT_NEAR(range.max(), FromLogLevel(2500), kTolerance);
+}
+
+TEST(AutoRangeTest, RejectsInvalidDecay) {
+  EXPECT_THROW(AutoRange({.decay = 0}), std::invalid_argument);
+  EXPECT_THROW(AutoRange({.decay = 1.5}), std::invalid_argument);
+}
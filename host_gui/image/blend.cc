@@ -0,0 +1,45 @@
+#include "blend.h"
+
+#include <immintrin.h>
+
+#include <cassert>
+
+void BlendBytes(std::span<const std::uint8_t> a,
+                std::span<const std::uint8_t> b, std::uint8_t b_weight,
+                std::span<std::uint8_t> out) {
+  assert(a.size() == out.size());
+  assert(b.size() == out.size());
+  const std::size_t n = out.size();
+  const std::uint16_t a_weight = 0xFF - b_weight;
+  std::size_t i = 0;
+#ifdef __AVX2__
+  const __m256i a_weight_vec = _mm256_set1_epi16(a_weight);
+  const __m256i b_weight_vec = _mm256_set1_epi16(b_weight);
+  const __m256i zero = _mm256_setzero_si256();
+  // floor(x / 255) == (x * 0x8081) >> 23 for all x <= 255 * 255.
+  const __m256i div255 = _mm256_set1_epi16(static_cast<short>(0x8081));
+  // Weighted sum of the 16-bit lanes, divided by 255.
+  auto blend16 = [&](__m256i a16, __m256i b16) {
+    const __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(a16, a_weight_vec),
+                                         _mm256_mullo_epi16(b16, b_weight_vec));
+    return _mm256_srli_epi16(_mm256_mulhi_epu16(sum, div255), 7);
+  };
+  for (; i + 32 <= n; i += 32) {
+    const __m256i a8 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.data() + i));
+    const __m256i b8 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data() + i));
+    // The unpack and pack instructions both operate within 128-bit lanes, so
+    // the bytes end up back in their original order.
+    const __m256i lo = blend16(_mm256_unpacklo_epi8(a8, zero),
+                               _mm256_unpacklo_epi8(b8, zero));
+    const __m256i hi = blend16(_mm256_unpackhi_epi8(a8, zero),
+                               _mm256_unpackhi_epi8(b8, zero));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.data() + i),
+                        _mm256_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = (a[i] * a_weight + b[i] * b_weight) / 0xFF;
+  }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+// Cross-fades two arrays of 8-bit channel values in 16-bit fixed point:
+//
+//   out[i] = (a[i] * (255 - b_weight) + b[i] * b_weight) / 255
+//
+// rounded down. All spans must be the same size. `out` may alias `a` or `b`.
+void BlendBytes(std::span<const std::uint8_t> a,
+                std::span<const std::uint8_t> b, std::uint8_t b_weight,
+                std::span<std::uint8_t> out);
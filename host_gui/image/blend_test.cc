@@ -0,0 +1,54 @@
+#include "blend.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using testing::Each;
+using testing::ElementsAreArray;
+
+std::vector<std::uint8_t> RandomBytes(std::size_t n, std::mt19937& rng) {
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<std::uint8_t> bytes(n);
+  for (std::uint8_t& byte : bytes) {
+    byte = distribution(rng);
+  }
+  return bytes;
+}
+
+TEST(BlendBytesTest, Endpoints) {
+  const std::vector<std::uint8_t> a(100, 10);
+  const std::vector<std::uint8_t> b(100, 200);
+  std::vector<std::uint8_t> out(100);
+  BlendBytes(a, b, 0, out);
+  EXPECT_THAT(out, Each(10));
+  BlendBytes(a, b, 255, out);
+  EXPECT_THAT(out, Each(200));
+}
+
+TEST(BlendBytesTest, InPlace) {
+  std::vector<std::uint8_t> a(100, 100);
+  const std::vector<std::uint8_t> b(100, 200);
+  BlendBytes(a, b, 128, a);
+  EXPECT_THAT(a, Each((100 * 127 + 200 * 128) / 255));
+}
+
+// Vectorized and scalar tail paths must agree exactly with the scalar formula,
+// for every weight and a length that isn't a multiple of the vector size.
+TEST(BlendBytesTest, MatchesScalarFormula) {
+  std::mt19937 rng(0);
+  const std::size_t n = 1000;
+  const std::vector<std::uint8_t> a = RandomBytes(n, rng);
+  const std::vector<std::uint8_t> b = RandomBytes(n, rng);
+  std::vector<std::uint8_t> out(n);
+  std::vector<std::uint8_t> expected(n);
+  for (int weight = 0; weight <= 255; ++weight) {
+    for (std::size_t i = 0; i < n; ++i) {
+      expected[i] = (a[i] * (255 - weight) + b[i] * weight) / 255;
+    }
+    BlendBytes(a, b, weight, out);
+    ASSERT_THAT(out, ElementsAreArray(expected)) << "weight " << weight;
+  }
+}
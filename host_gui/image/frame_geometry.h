@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QImage>
+#include <QPoint>
+#include <QRectF>
+#include <QString>
+#include <cstdint>
+
+// Rendered frames may be a crop of a downscaled pyramid level (see
+// MipPyramid) rather than the full logical image. The frame's position within
+// the logical image is stored as metadata on the QImage itself, so that it
+// passes unchanged through the generator pipeline between the renderer and
+// the viewer. The crop origin is stored as QImage::offset(), in level
+// coordinates. Images without this metadata are treated as uncropped level 0
+// frames.
+
+inline const QString kFrameLevelKey = QStringLiteral("level");
+inline const QString kFrameScrollKey = QStringLiteral("scroll");
+inline const QString kFrameColorsKey = QStringLiteral("colors");
+
+// Records that `image` is the crop of pyramid level `level` whose top-left
+// pixel lies at `offset` in level coordinates.
+inline void SetFrameGeometry(QImage& image, int level, QPoint offset) {
+  image.setOffset(offset);
+  image.setText(kFrameLevelKey, QString::number(level));
+}
+
+inline int FrameLevel(const QImage& image) {
+  return image.text(kFrameLevelKey).toInt();
+}
+
+inline void CopyFrameGeometry(const QImage& from, QImage& to) {
+  SetFrameGeometry(to, FrameLevel(from), from.offset());
+}
+
+inline bool SameFrameGeometry(const QImage& a, const QImage& b) {
+  return a.size() == b.size() && a.offset() == b.offset() &&
+         FrameLevel(a) == FrameLevel(b);
+}
+
+// Records how many columns had been appended to the frame's pyramid level when
+// it was rendered. Two frames with the same geometry whose scroll positions
+// differ by N have the same contents, except for being shifted N columns to
+// the left with N new columns at the right edge.
+inline void SetFrameScrollPosition(QImage& image, std::int64_t columns) {
+  image.setText(kFrameScrollKey, QString::number(columns));
+}
+
+inline std::int64_t FrameScrollPosition(const QImage& image) {
+  return image.text(kFrameScrollKey).toLongLong();
+}
+
+// Records which version of the value-to-color mapping `image` was rendered
+// with. Frames with different versions may color the same data differently.
+inline void SetFrameColors(QImage& image, std::int64_t version) {
+  image.setText(kFrameColorsKey, QString::number(version));
+}
+
+inline std::int64_t FrameColors(const QImage& image) {
+  return image.text(kFrameColorsKey).toLongLong();
+}
+
+// Region of the logical image covered by `image`.
+inline QRectF LogicalFrameRect(const QImage& image) {
+  const double scale = 1 << FrameLevel(image);
+  return QRectF(QPointF(image.offset()) * scale, QSizeF(image.size()) * scale);
+}
+
+// A frame drawn displaced horizontally by a fraction of a pixel, for smooth
+// scrolling between rendered frames. The displacement is kept outside of the
+// QImage metadata because modifying a shared QImage deep copies its pixels.
+struct DisplayFrame {
+  QImage image;
+  // Horizontal displacement in level coordinates.
+  double shift = 0;
+};
+
+// Whether `a` and `b` would be drawn identically.
+inline bool SameDisplayFrame(const DisplayFrame& a, const DisplayFrame& b) {
+  return a.image.cacheKey() == b.image.cacheKey() && a.shift == b.shift;
+}
+
+inline QRectF LogicalFrameRect(const DisplayFrame& frame) {
+  const double scale = 1 << FrameLevel(frame.image);
+  return LogicalFrameRect(frame.image).translated(frame.shift * scale, 0);
+}
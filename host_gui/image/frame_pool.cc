@@ -0,0 +1,107 @@
+#include "frame_pool.h"
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+struct FramePool::State {
+  explicit State(const Options& options) : options(options) {}
+
+  const Options options;
+
+  mutable absl::Mutex mutex;
+  // Idle buffers, all of size `idle_bytes`. Buffers of other sizes are freed
+  // on return, since the frame size rarely changes back and forth.
+  std::vector<void*> idle ABSL_GUARDED_BY(mutex);
+  std::size_t idle_bytes ABSL_GUARDED_BY(mutex) = 0;
+  std::size_t allocations ABSL_GUARDED_BY(mutex) = 0;
+
+  ~State() {
+    for (void* buffer : idle) {
+      std::free(buffer);
+    }
+  }
+
+  void* Take(std::size_t bytes) ABSL_LOCKS_EXCLUDED(mutex);
+  void Return(void* buffer, std::size_t bytes) ABSL_LOCKS_EXCLUDED(mutex);
+};
+
+void* FramePool::State::Take(std::size_t bytes) {
+  {
+    absl::MutexLock lock(&mutex);
+    if (bytes == idle_bytes && !idle.empty()) {
+      void* buffer = idle.back();
+      idle.pop_back();
+      return buffer;
+    }
+    ++allocations;
+  }
+  void* buffer = std::aligned_alloc(options.alignment, bytes);
+  if (buffer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return buffer;
+}
+
+void FramePool::State::Return(void* buffer, std::size_t bytes) {
+  absl::MutexLock lock(&mutex);
+  if (bytes != idle_bytes) {
+    for (void* stale : idle) {
+      std::free(stale);
+    }
+    idle.clear();
+    idle_bytes = bytes;
+  }
+  if (idle.size() < options.max_idle) {
+    idle.push_back(buffer);
+  } else {
+    std::free(buffer);
+  }
+}
+
+// QImage cleanup info for a buffer borrowed from the pool. Keeps the pool state
+// alive until the buffer is returned.
+struct FramePool::Loan {
+  std::shared_ptr<State> state;
+  void* buffer;
+  std::size_t bytes;
+
+  static void Cleanup(void* info) {
+    auto* loan = static_cast<Loan*>(info);
+    loan->state->Return(loan->buffer, loan->bytes);
+    delete loan;
+  }
+};
+
+FramePool::FramePool(const Options& options)
+    : state_(std::make_shared<State>(options)) {
+  // Validate the alignment up front rather than on first use.
+  AlignedBytesPerLine(0, options.alignment);
+}
+
+QImage FramePool::Acquire(QSize size, QImage::Format format) {
+  if (size.isEmpty()) {
+    return QImage(size, format);
+  }
+  const int bytes_per_line =
+      AlignedBytesPerLine(size.width(), state_->options.alignment);
+  const std::size_t bytes =
+      static_cast<std::size_t>(bytes_per_line) * size.height();
+  auto* loan = new Loan{state_, state_->Take(bytes), bytes};
+  return QImage(static_cast<uchar*>(loan->buffer), size.width(),
+                size.height(), bytes_per_line, format, &Loan::Cleanup,
+                loan);
+}
+
+std::size_t FramePool::allocations() const {
+  absl::MutexLock lock(&state_->mutex);
+  return state_->allocations;
+}
+
+std::size_t FramePool::idle() const {
+  absl::MutexLock lock(&state_->mutex);
+  return state_->idle.size();
+}
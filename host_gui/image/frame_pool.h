@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <cstddef>
+#include <memory>
+
+#include "qimage_aligned.h"
+
+// Recycles the pixel buffers of AlignedQImage()-style frames.
+//
+// Images returned by Acquire() hand their buffer back to the pool once the
+// last copy of the image is destroyed, instead of freeing it. A pipeline that
+// keeps a bounded number of frames in flight therefore stops allocating (and
+// page faulting) once warmed up. Images may be destroyed from any thread, and
+// may outlive the pool.
+class FramePool {
+ public:
+  struct Options {
+    // Maximum number of idle buffers retained. Buffers returned beyond this
+    // are freed.
+    std::size_t max_idle = 8;
+    unsigned alignment = kDefaultQImageAlignment;
+  };
+
+  FramePool() : FramePool(Options()) {}
+  FramePool(const Options& options);
+
+  // Returns a 32-bit per pixel image with aligned scan lines and unspecified
+  // contents.
+  QImage Acquire(QSize size, QImage::Format format = QImage::Format_RGB32);
+
+  // Total number of buffers allocated, not counting reuse.
+  std::size_t allocations() const;
+
+  // Number of buffers waiting to be reused.
+  std::size_t idle() const;
+
+ private:
+  struct State;
+  struct Loan;
+
+  std::shared_ptr<State> state_;
+};
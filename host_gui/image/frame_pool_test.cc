@@ -0,0 +1,97 @@
+#include "frame_pool.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+std::uintptr_t ScanLineAddress(const QImage& image, int row) {
+  return reinterpret_cast<std::uintptr_t>(image.constScanLine(row));
+}
+
+TEST(FramePoolTest, ImageHasAlignedScanLines) {
+  FramePool pool({.alignment = 64});
+  const QImage image = pool.Acquire(QSize(500, 3));
+  EXPECT_EQ(image.width(), 500);
+  EXPECT_EQ(image.height(), 3);
+  EXPECT_EQ(image.bytesPerLine(), 2048);
+  EXPECT_EQ(image.format(), QImage::Format_RGB32);
+  EXPECT_EQ(ScanLineAddress(image, 0) % 64, 0);
+  EXPECT_EQ(ScanLineAddress(image, 1), ScanLineAddress(image, 0) + 2048);
+}
+
+TEST(FramePoolTest, RejectsBadAlignment) {
+  EXPECT_THROW(FramePool({.alignment = 9}), std::invalid_argument);
+}
+
+TEST(FramePoolTest, ReusesReleasedBuffer) {
+  FramePool pool;
+  const uchar* bits;
+  {
+    const QImage image = pool.Acquire(QSize(16, 16));
+    bits = image.constBits();
+    EXPECT_EQ(pool.idle(), 0);
+  }
+  EXPECT_EQ(pool.idle(), 1);
+  const QImage image = pool.Acquire(QSize(16, 16));
+  EXPECT_EQ(image.constBits(), bits);
+  EXPECT_EQ(pool.allocations(), 1);
+  EXPECT_EQ(pool.idle(), 0);
+}
+
+TEST(FramePoolTest, BufferReturnedAfterLastCopy) {
+  FramePool pool;
+  QImage image = pool.Acquire(QSize(16, 16));
+  QImage copy = image;
+  image = QImage();
+  EXPECT_EQ(pool.idle(), 0);
+  copy = QImage();
+  EXPECT_EQ(pool.idle(), 1);
+}
+
+TEST(FramePoolTest, OutstandingBuffersNotShared) {
+  FramePool pool;
+  const QImage a = pool.Acquire(QSize(16, 16));
+  const QImage b = pool.Acquire(QSize(16, 16));
+  EXPECT_NE(a.constBits(), b.constBits());
+  EXPECT_EQ(pool.allocations(), 2);
+}
+
+TEST(FramePoolTest, SizeChangeDiscardsIdleBuffers) {
+  FramePool pool;
+  pool.Acquire(QSize(16, 16));
+  pool.Acquire(QSize(16, 32));
+  EXPECT_EQ(pool.idle(), 1);
+  pool.Acquire(QSize(16, 16));
+  EXPECT_EQ(pool.allocations(), 3);
+}
+
+TEST(FramePoolTest, IdleBuffersBounded) {
+  FramePool pool({.max_idle = 2});
+  {
+    std::vector<QImage> images;
+    for (int i = 0; i < 4; ++i) {
+      images.push_back(pool.Acquire(QSize(16, 16)));
+    }
+  }
+  EXPECT_EQ(pool.idle(), 2);
+}
+
+TEST(FramePoolTest, ImageOutlivesPool) {
+  QImage image;
+  {
+    FramePool pool;
+    image = pool.Acquire(QSize(16, 16));
+  }
+  image.bits()[0] = 1;
+  image = QImage();
+}
+
+TEST(FramePoolTest, ReleaseFromOtherThread) {
+  FramePool pool;
+  QImage image = pool.Acquire(QSize(16, 16));
+  std::jthread([image = std::move(image)]() mutable { image = QImage(); });
+  EXPECT_EQ(pool.idle(), 1);
+}
@@ -0,0 +1,54 @@
+#include "frame_scheduler.h"
+
+#include <algorithm>
+
+absl::Duration AdaptiveFrameScheduler::latency() const {
+  return std::clamp(jitter_ * options_.jitter_multiple, options_.min_latency,
+                    options_.max_latency);
+}
+
+auto AdaptiveFrameScheduler::Schedule(absl::Time arrival_time) -> Decision {
+  if (epoch_ == absl::InfinitePast()) {
+    epoch_ = arrival_time;
+  }
+  const absl::Time nominal_time = epoch_ + period_ * frame_number_;
+  ++frame_number_;
+  const bool paced = arrival_time - last_arrival_time_ >= period_ / 2;
+  last_arrival_time_ = arrival_time;
+
+  // A frame that arrived before the previous render time was already waiting
+  // on the consumer, and its arrival time says nothing about the source clock.
+  if (arrival_time > last_render_time_) {
+    // Clamp outliers (e.g. a backlog after a stall) so that a single burst
+    // doesn't throw off the estimates.
+    const absl::Duration deviation = std::clamp(
+        arrival_time - nominal_time, offset_ - options_.max_latency,
+        offset_ + options_.max_latency);
+    offset_ += (deviation - offset_) * options_.smoothing;
+    jitter_ += (absl::AbsDuration(deviation - offset_) - jitter_) *
+               options_.smoothing;
+  }
+
+  absl::Time render_time = nominal_time + offset_ + latency();
+  if (arrival_time - render_time > options_.drop_threshold && paced &&
+      ++paced_drops_ >= options_.resync_drops) {
+    // Frames are arriving steadily, but too late for the grid to ever catch
+    // up. Shift the grid so that this frame is due on arrival.
+    epoch_ += arrival_time - (nominal_time + offset_);
+    render_time = arrival_time + latency();
+  }
+  if (render_time >= arrival_time) {
+    paced_drops_ = 0;
+    ++counters_.on_time;
+    last_render_time_ = render_time;
+    return {.render_time = render_time};
+  }
+  if (arrival_time - render_time > options_.drop_threshold) {
+    ++counters_.dropped;
+    return {.render_time = arrival_time, .drop = true};
+  }
+  paced_drops_ = 0;
+  ++counters_.late;
+  last_render_time_ = arrival_time;
+  return {.render_time = arrival_time};
+}
@@ -2,13 +2,17 @@
 
 #include <absl/time/time.h>
 
+#include <atomic>
+#include <cstdint>
+
 #include "diy/rational.h"
 
 // Given an expected average output frame rate (`timebase`, measured in frames
 // per second), calculates the time that each arriving frame should be rendered
 // at to maintain that frame rate.
 //
-// TODO(dhrosa): This doesn't handle bursty or delayed frame production.
+// This doesn't handle bursty or delayed frame production; see
+// AdaptiveFrameScheduler.
 class FrameScheduler {
  public:
   FrameScheduler(Rational timebase) : timebase_(timebase) {}
@@ -31,3 +35,95 @@ inline absl::Time FrameScheduler::Schedule(absl::Time arrival_time) {
   ++current_frame_number_;
   return render_time;
 }
+
+// Running totals of AdaptiveFrameScheduler decisions. May be read from any
+// thread.
+struct FrameCounters {
+  // Frames scheduled at or after their arrival time.
+  std::atomic<std::int64_t> on_time = 0;
+  // Frames that arrived after their scheduled time, and are rendered
+  // immediately.
+  std::atomic<std::int64_t> late = 0;
+  // Frames that arrived so late that they were skipped.
+  std::atomic<std::int64_t> dropped = 0;
+};
+
+// Variant of FrameScheduler that tolerates jittery, drifting, and bursty frame
+// arrival.
+//
+// Frames are nominally scheduled on a grid of `timebase` spaced slots. The
+// offset between arrival times and that grid is tracked with an exponential
+// moving average, which absorbs drift between the frame source's clock and the
+// local clock. Scheduled times are delayed by a jitter buffer proportional to
+// the observed arrival jitter. Frames arriving after their slot are rendered
+// immediately, and frames whose slot passed long ago (e.g. a backlog after a
+// stall) are dropped to get back to real time. If frames keep arriving late
+// without a backlog, the source permanently lost time, and the grid is
+// re-anchored to the latest arrival instead.
+//
+// Frames are expected to be pulled by the consumer, so frames arriving before
+// the previous frame's render time are treated as having been queued, and
+// don't contribute to the estimates. This means a source clock running faster
+// than `timebase` isn't compensated for; the source should be the one
+// adapting in that case.
+class AdaptiveFrameScheduler {
+ public:
+  struct Options {
+    // Bounds on the delay added to absorb arrival jitter.
+    absl::Duration min_latency = absl::ZeroDuration();
+    absl::Duration max_latency = absl::Milliseconds(50);
+    // The jitter buffer holds this multiple of the estimated jitter.
+    double jitter_multiple = 3;
+    // Frames arriving more than this long after their scheduled time are
+    // dropped.
+    absl::Duration drop_threshold = absl::Milliseconds(50);
+    // The grid is re-anchored after this many consecutive dropped frames that
+    // each arrived at least half a period after the previous frame. A backlog
+    // arrives all at once, and is dropped until the grid catches up.
+    int resync_drops = 3;
+    // Weight of each new arrival in the offset and jitter estimates.
+    double smoothing = 0.05;
+  };
+
+  struct Decision {
+    absl::Time render_time;
+    bool drop = false;
+  };
+
+  AdaptiveFrameScheduler(Rational timebase)
+      : AdaptiveFrameScheduler(timebase, Options()) {}
+  // If `counters` is null, the scheduler keeps its own counters.
+  AdaptiveFrameScheduler(Rational timebase, const Options& options,
+                         FrameCounters* counters = nullptr)
+      : period_(absl::Seconds(static_cast<double>(timebase))),
+        options_(options),
+        counters_(counters ? *counters : own_counters_) {}
+
+  // Not copyable or movable, as `counters_` may refer to `own_counters_`.
+  AdaptiveFrameScheduler(const AdaptiveFrameScheduler&) = delete;
+  AdaptiveFrameScheduler& operator=(const AdaptiveFrameScheduler&) = delete;
+
+  Decision Schedule(absl::Time arrival_time);
+
+  const FrameCounters& counters() const { return counters_; }
+
+  // Current estimate of the jitter buffer delay.
+  absl::Duration latency() const;
+
+ private:
+  const absl::Duration period_;
+  const Options options_;
+  FrameCounters own_counters_;
+  FrameCounters& counters_;
+
+  absl::Time epoch_ = absl::InfinitePast();
+  std::int64_t frame_number_ = 0;
+  absl::Time last_render_time_ = absl::InfinitePast();
+  absl::Time last_arrival_time_ = absl::InfinitePast();
+  // Consecutive dropped frames that didn't arrive as part of a backlog.
+  int paced_drops_ = 0;
+  // Smoothed offset of arrival times relative to the nominal grid.
+  absl::Duration offset_ = absl::ZeroDuration();
+  // Smoothed absolute deviation of arrival times from the offset grid.
+  absl::Duration jitter_ = absl::ZeroDuration();
+};
@@ -3,6 +3,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <ranges>
 #include <span>
 
@@ -33,3 +34,150 @@ TEST(FrameSchedulerTest, FramesOffsetByFirstFrame) {
                           absl::FromUnixMillis(503), absl::FromUnixMillis(753),
                           absl::FromUnixMillis(1003)));
 }
+
+// Simulated consumer: renders each frame at its scheduled time, and can't pick
+// up the next frame until then.
+struct SimulatedFrame {
+  absl::Time arrival_time;
+  AdaptiveFrameScheduler::Decision decision;
+};
+
+std::vector<SimulatedFrame> SimulateFrames(
+    AdaptiveFrameScheduler& scheduler,
+    std::span<const absl::Time> production_times) {
+  std::vector<SimulatedFrame> frames;
+  absl::Time now = absl::InfinitePast();
+  for (absl::Time production_time : production_times) {
+    now = std::max(now, production_time);
+    const auto decision = scheduler.Schedule(now);
+    frames.push_back({.arrival_time = now, .decision = decision});
+    if (!decision.drop) {
+      now = std::max(now, decision.render_time);
+    }
+  }
+  return frames;
+}
+
+std::vector<absl::Time> PeriodicTimes(int count, absl::Duration period,
+                                      absl::Time start = absl::UnixEpoch()) {
+  std::vector<absl::Time> times;
+  for (int i = 0; i < count; ++i) {
+    times.push_back(start + period * i);
+  }
+  return times;
+}
+
+TEST(AdaptiveFrameSchedulerTest, SteadyFramesOnTime) {
+  AdaptiveFrameScheduler scheduler({1, 4});
+  const auto frames =
+      SimulateFrames(scheduler, PeriodicTimes(5, absl::Milliseconds(250)));
+  std::vector<absl::Time> render_times;
+  for (const auto& frame : frames) {
+    EXPECT_FALSE(frame.decision.drop);
+    render_times.push_back(frame.decision.render_time);
+  }
+  EXPECT_THAT(render_times,
+              ElementsAre(absl::FromUnixMillis(0), absl::FromUnixMillis(250),
+                          absl::FromUnixMillis(500), absl::FromUnixMillis(750),
+                          absl::FromUnixMillis(1000)));
+  EXPECT_EQ(scheduler.counters().on_time, 5);
+  EXPECT_EQ(scheduler.counters().late, 0);
+  EXPECT_EQ(scheduler.counters().dropped, 0);
+}
+
+TEST(AdaptiveFrameSchedulerTest, BurstSpreadOverPeriods) {
+  AdaptiveFrameScheduler scheduler({1, 4});
+  // All frames produced at once, as Interpolate does.
+  const std::vector<absl::Time> production_times(4, absl::UnixEpoch());
+  const auto frames = SimulateFrames(scheduler, production_times);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(frames[i].decision.render_time,
+              absl::FromUnixMillis(250 * i));
+  }
+  EXPECT_EQ(scheduler.counters().on_time, 4);
+}
+
+TEST(AdaptiveFrameSchedulerTest, JitterAbsorbed) {
+  const absl::Duration period = absl::Milliseconds(16);
+  AdaptiveFrameScheduler scheduler({1, 60});
+  // Deterministic pseudo-random jitter of up to +/-4ms.
+  std::vector<absl::Time> production_times = PeriodicTimes(600, period);
+  for (int i = 0; i < production_times.size(); ++i) {
+    production_times[i] += absl::Microseconds((i * 7919) % 8000 - 4000);
+  }
+  const auto frames = SimulateFrames(scheduler, production_times);
+  EXPECT_EQ(scheduler.counters().dropped, 0);
+  // Once the jitter estimate settles, nearly all frames are on time.
+  EXPECT_GT(scheduler.counters().on_time, 550);
+  EXPECT_GT(scheduler.latency(), absl::Milliseconds(2));
+  EXPECT_LE(scheduler.latency(), absl::Milliseconds(50));
+  for (int i = 1; i < frames.size(); ++i) {
+    EXPECT_GE(frames[i].decision.render_time,
+              frames[i - 1].decision.render_time);
+  }
+}
+
+TEST(AdaptiveFrameSchedulerTest, TracksClockDrift) {
+  // Source clock runs 2% slow relative to the nominal frame rate.
+  const absl::Duration nominal_period = absl::Seconds(1) / 60;
+  AdaptiveFrameScheduler scheduler({1, 60});
+  const auto frames = SimulateFrames(
+      scheduler, PeriodicTimes(3000, nominal_period * 1.02));
+  EXPECT_EQ(scheduler.counters().dropped, 0);
+  // Lag between arrival and render stays bounded rather than growing.
+  for (int i = frames.size() - 100; i < frames.size(); ++i) {
+    EXPECT_LE(frames[i].decision.render_time - frames[i].arrival_time,
+              absl::Milliseconds(50));
+  }
+}
+
+TEST(AdaptiveFrameSchedulerTest, StallBacklogDropped) {
+  const absl::Duration period = absl::Milliseconds(10);
+  AdaptiveFrameScheduler scheduler({1, 100});
+  // 100 steady frames, then a 1 second stall after which the backlog of 100
+  // frames arrives at once, followed by steady frames again.
+  std::vector<absl::Time> production_times = PeriodicTimes(100, period);
+  const absl::Time resume_time = production_times.back() + absl::Seconds(1);
+  production_times.insert(production_times.end(), 100, resume_time);
+  for (absl::Time time : PeriodicTimes(100, period, resume_time + period)) {
+    production_times.push_back(time);
+  }
+  const auto frames = SimulateFrames(scheduler, production_times);
+  const auto& counters = scheduler.counters();
+  EXPECT_GT(counters.dropped, 50);
+  EXPECT_EQ(counters.on_time + counters.late + counters.dropped, 300);
+  // Back to real time by the end.
+  for (int i = frames.size() - 50; i < frames.size(); ++i) {
+    EXPECT_FALSE(frames[i].decision.drop);
+    EXPECT_LE(frames[i].decision.render_time - frames[i].arrival_time,
+              absl::Milliseconds(50));
+  }
+}
+
+TEST(AdaptiveFrameSchedulerTest, StallWithoutBacklogResyncs) {
+  const absl::Duration period = absl::Milliseconds(10);
+  AdaptiveFrameScheduler scheduler({1, 100});
+  // 100 steady frames, then a 1 second stall during which the source lost
+  // time: no backlog arrives, and steady frames resume on a later grid.
+  std::vector<absl::Time> production_times = PeriodicTimes(100, period);
+  for (absl::Time time : PeriodicTimes(
+           200, period, production_times.back() + absl::Seconds(1))) {
+    production_times.push_back(time);
+  }
+  const auto frames = SimulateFrames(scheduler, production_times);
+  // Only the frames needed to detect the stall are dropped.
+  EXPECT_EQ(scheduler.counters().dropped, 2);
+  for (int i = 103; i < frames.size(); ++i) {
+    EXPECT_FALSE(frames[i].decision.drop) << i;
+    EXPECT_LE(frames[i].decision.render_time - frames[i].arrival_time,
+              absl::Milliseconds(50));
+  }
+}
+
+TEST(AdaptiveFrameSchedulerTest, ExternalCounters) {
+  FrameCounters counters;
+  AdaptiveFrameScheduler scheduler({1, 4}, {}, &counters);
+  scheduler.Schedule(absl::UnixEpoch());
+  EXPECT_EQ(counters.on_time, 1);
+  EXPECT_EQ(&scheduler.counters(), &counters);
+}
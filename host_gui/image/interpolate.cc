@@ -1,41 +1,94 @@
 #include "interpolate.h"
 
 #include <cassert>
+#include <cstdlib>
 #include <deque>
-#include <sstream>
+#include <span>
 
+#include "blend.h"
 #include "diy/coro/task.h"
-#include "qimage_eigen.h"
+#include "frame_geometry.h"
+#include "frame_pool.h"
 
 namespace {
 
-// Linearly interpolate between `a` and `b` according to parameter `t`, which
-// must have range [0, 1].
-QImage Blend(double t, const QImage& image_a, const QImage& image_b) {
-  // We perform blends on 8-bit values using 16-bit fixed-point arithmetic.
-  constexpr std::uint16_t max8 = 0xFF;
-  const std::uint16_t a_weight = (1.0 - t) * max8;
-  const std::uint16_t b_weight = max8 - a_weight;
+// Output frames that would differ from the previous output frame by less than
+// these steps reuse the previous frame, so that consumers can recognize them
+// with SameDisplayFrame() and skip redrawing.
+//
+// Blend weight step, in units of 1/255.
+constexpr int kMinBlendStep = 2;
+// Scroll displacement step, in level pixels.
+constexpr double kMinScrollStep = 1.0 / 16;
+
+// We perform blends on 8-bit values using 16-bit fixed-point arithmetic. This
+// converts a blend parameter `t`, which must have range [0, 1], to the weight
+// of the second image.
+std::uint8_t BlendWeight(double t) {
+  constexpr std::uint8_t max8 = 0xFF;
+  const std::uint8_t a_weight = (1.0 - t) * max8;
+  return max8 - a_weight;
+}
 
-  QImage image(image_a.size(), image_a.format());
-  auto out = EigenView8(image);
-  auto a = EigenView8(image_a).template cast<std::uint16_t>() * a_weight;
-  auto b = EigenView8(image_b).template cast<std::uint16_t>() * b_weight;
-  out = ((a + b) / max8).template cast<std::uint8_t>();
+// Linearly interpolate between `a` and `b` according to BlendWeight()
+// `b_weight`. The output image is drawn from `pool`.
+QImage Blend(std::uint8_t b_weight, const QImage& image_a,
+             const QImage& image_b, FramePool& pool) {
+  if (!SameFrameGeometry(image_a, image_b)) {
+    // The source changed resolution or crop region; there's nothing
+    // meaningful to blend.
+    return image_b;
+  }
+  // Endpoints and identical inputs don't need a new image.
+  if (b_weight == 0) {
+    return image_a;
+  }
+  if (b_weight == 0xFF || image_a.cacheKey() == image_b.cacheKey()) {
+    return image_b;
+  }
+
+  QImage image = pool.Acquire(image_a.size(), image_a.format());
+  // Scan lines are blended separately, skipping the padding between them.
+  const std::size_t row_bytes = 4 * image.width();
+  for (int y = 0; y < image.height(); ++y) {
+    BlendBytes(std::span(image_a.constScanLine(y), row_bytes),
+               std::span(image_b.constScanLine(y), row_bytes), b_weight,
+               std::span(image.scanLine(y), row_bytes));
+  }
+  CopyFrameGeometry(image_b, image);
   return image;
 }
 
+// Scroll from `image_a` towards `image_b` according to parameter `t`, which
+// must have range [0, 1].
+DisplayFrame Scroll(double t, const QImage& image_a, const QImage& image_b) {
+  const std::int64_t distance =
+      FrameScrollPosition(image_b) - FrameScrollPosition(image_a);
+  if (!SameFrameGeometry(image_a, image_b) || distance <= 0 ||
+      distance >= image_b.width()) {
+    return {.image = image_b};
+  }
+  // Displacing `image_b` by the full distance lines its contents up with
+  // `image_a`, and its new columns hang off the right edge.
+  return {.image = image_b, .shift = (1 - t) * distance};
+}
+
 }  // namespace
 
-AsyncGenerator<QImage> Interpolate(AsyncGenerator<QImage> source,
-                                   Rational input_timebase,
-                                   Rational output_timebase) {
-  if (double(input_timebase) < double(output_timebase)) {
-    std::stringstream message;
-    message << "Input timebase " << input_timebase
-            << " is finer resolution than output timebase " << output_timebase;
-    throw std::logic_error(message.str());
-  }
+AsyncGenerator<DisplayFrame> Interpolate(AsyncGenerator<QImage> source,
+                                         Rational input_timebase,
+                                         Rational output_timebase,
+                                         InterpolationMode mode) {
+  return Interpolate(
+      std::move(source), [input_timebase] { return input_timebase; },
+      output_timebase, mode);
+}
+
+AsyncGenerator<DisplayFrame> Interpolate(
+    AsyncGenerator<QImage> source,
+    absl::AnyInvocable<Rational()> input_timebase_source,
+    Rational output_timebase, InterpolationMode mode) {
+  Rational input_timebase = input_timebase_source();
   // Input frames N and N+1.
   QImage input_frames[2];
   // Fill initial buffer of input frames.
@@ -46,15 +99,39 @@ AsyncGenerator<QImage> Interpolate(AsyncGenerator<QImage> source,
     }
     initial_frame = std::move(*frame);
   }
+  // Output frames are only held until the viewer has displayed them, so a
+  // handful of buffers is recycled indefinitely.
+  FramePool pool;
+  DisplayFrame previous_frame;
+  std::int64_t previous_input_frame_number = -1;
+  int previous_weight = 0;
   std::int64_t output_frame_number = 0;
+  // Input timestamps are computed relative to the most recent input timebase
+  // change, so that they stay exact while the timebase is constant.
+  std::int64_t segment_start_frame_number = 0;
+  double segment_start_timestamp = 0;
   for (std::int64_t input_frame_number = 0;; ++input_frame_number) {
+    if (input_frame_number > 0) {
+      if (const Rational latest = input_timebase_source();
+          !(latest == input_timebase)) {
+        segment_start_timestamp += static_cast<double>(
+            input_timebase * (input_frame_number - segment_start_frame_number));
+        segment_start_frame_number = input_frame_number;
+        input_timebase = latest;
+      }
+    }
+    const std::int64_t segment_frame_number =
+        input_frame_number - segment_start_frame_number;
     const double input_start_timestamp =
-        static_cast<double>(input_timebase * input_frame_number);
+        segment_start_timestamp +
+        static_cast<double>(input_timebase * segment_frame_number);
     const double input_end_timestamp =
-        static_cast<double>(input_timebase * (input_frame_number + 1));
+        segment_start_timestamp +
+        static_cast<double>(input_timebase * (segment_frame_number + 1));
     const double input_duration = input_end_timestamp - input_start_timestamp;
     // Produce as many output frames from the current set of input frames as
-    // possible.
+    // possible. Input frames shorter than the output timebase may produce
+    // none, so that the next output frame catches up by several input frames.
     for (;; ++output_frame_number) {
       const double output_start_timestamp =
           static_cast<double>(output_timebase * output_frame_number);
@@ -66,7 +143,26 @@ AsyncGenerator<QImage> Interpolate(AsyncGenerator<QImage> source,
       // buffered input frame.
       const double t =
           (output_start_timestamp - input_start_timestamp) / input_duration;
-      co_yield Blend(t, input_frames[0], input_frames[1]);
+      DisplayFrame frame;
+      if (mode == InterpolationMode::kScroll) {
+        frame = Scroll(t, input_frames[0], input_frames[1]);
+        if (frame.image.cacheKey() == previous_frame.image.cacheKey() &&
+            std::abs(frame.shift - previous_frame.shift) < kMinScrollStep) {
+          frame = previous_frame;
+        }
+      } else {
+        const std::uint8_t weight = BlendWeight(t);
+        if (input_frame_number == previous_input_frame_number &&
+            std::abs(weight - previous_weight) < kMinBlendStep) {
+          frame = previous_frame;
+        } else {
+          frame.image = Blend(weight, input_frames[0], input_frames[1], pool);
+          previous_input_frame_number = input_frame_number;
+          previous_weight = weight;
+        }
+      }
+      previous_frame = frame;
+      co_yield std::move(frame);
     }
     // Read next input frame.
     input_frames[0] = std::move(input_frames[1]);
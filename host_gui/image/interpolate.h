@@ -1,12 +1,35 @@
 #pragma once
 
+#include <absl/functional/any_invocable.h>
 #include <absl/time/time.h>
 
 #include <QtGui/QImage>
 
 #include "diy/coro/async_generator.h"
 #include "diy/rational.h"
+#include "frame_geometry.h"
 
-AsyncGenerator<QImage> Interpolate(AsyncGenerator<QImage> source,
-                                   Rational input_timebase,
-                                   Rational output_timebase);
+enum class InterpolationMode {
+  // Cross-fade between consecutive input frames.
+  kBlend,
+  // Input frames that are a horizontally scrolled copy of the previous input
+  // frame (see SetFrameScrollPosition()) are displaced by the remaining
+  // fraction of the scroll distance, without touching the pixel data. Other
+  // input frames are passed through as-is.
+  kScroll,
+};
+
+// Resamples `source`, whose frames last `input_timebase` each, to frames
+// lasting `output_timebase`. Input frames may be longer or shorter than output
+// frames; input frames that fall between two output frames are skipped.
+AsyncGenerator<DisplayFrame> Interpolate(
+    AsyncGenerator<QImage> source, Rational input_timebase,
+    Rational output_timebase,
+    InterpolationMode mode = InterpolationMode::kBlend);
+
+// As above, but the input frame rate may change while running:
+// `input_timebase` is queried for the duration of each input frame.
+AsyncGenerator<DisplayFrame> Interpolate(
+    AsyncGenerator<QImage> source,
+    absl::AnyInvocable<Rational()> input_timebase, Rational output_timebase,
+    InterpolationMode mode = InterpolationMode::kBlend);
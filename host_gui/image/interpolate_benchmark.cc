@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+
+#include <QImage>
+#include <span>
+#include <vector>
+
+#include "blend.h"
+#include "diy/coro/task.h"
+#include "frame_geometry.h"
+#include "frame_pool.h"
+#include "interpolate.h"
+#include "qimage_aligned.h"
+#include "qimage_eigen.h"
+
+constexpr int kWidth = 1440;
+constexpr int kHeight = 1025;
+constexpr std::int64_t kFrameBytes = std::int64_t{kWidth} * kHeight * 4;
+
+// A fresh frame per output, as Blend() allocated before FramePool.
+static void BM_AllocateFrame(benchmark::State& state) {
+  for (auto _ : state) {
+    QImage image(kWidth, kHeight, QImage::Format_RGB32);
+    image.fill(0);
+    benchmark::DoNotOptimize(image.constBits());
+  }
+  state.SetBytesProcessed(kFrameBytes * state.iterations());
+}
+BENCHMARK(BM_AllocateFrame);
+
+static void BM_PooledFrame(benchmark::State& state) {
+  FramePool pool;
+  for (auto _ : state) {
+    QImage image = pool.Acquire(QSize(kWidth, kHeight));
+    image.fill(0);
+    benchmark::DoNotOptimize(image.constBits());
+  }
+  state.SetBytesProcessed(kFrameBytes * state.iterations());
+}
+BENCHMARK(BM_PooledFrame);
+
+QImage FilledFrame(std::uint32_t value) {
+  QImage image = AlignedQImage(kWidth, kHeight);
+  image.fill(value);
+  return image;
+}
+
+// The Eigen expression Blend() used before BlendBytes().
+static void BM_BlendEigen(benchmark::State& state) {
+  const QImage image_a = FilledFrame(0xFF'20'40'60);
+  const QImage image_b = FilledFrame(0xFF'C0'A0'80);
+  QImage image = FilledFrame(0);
+  constexpr std::uint16_t max8 = 0xFF;
+  const std::uint16_t a_weight = 100;
+  const std::uint16_t b_weight = max8 - a_weight;
+  for (auto _ : state) {
+    auto out = EigenView8(image);
+    auto a = EigenView8(image_a).template cast<std::uint16_t>() * a_weight;
+    auto b = EigenView8(image_b).template cast<std::uint16_t>() * b_weight;
+    out = ((a + b) / max8).template cast<std::uint8_t>();
+    benchmark::DoNotOptimize(image.constBits());
+  }
+  state.SetBytesProcessed(kFrameBytes * state.iterations());
+}
+BENCHMARK(BM_BlendEigen);
+
+static void BM_BlendBytes(benchmark::State& state) {
+  const QImage image_a = FilledFrame(0xFF'20'40'60);
+  const QImage image_b = FilledFrame(0xFF'C0'A0'80);
+  QImage image = FilledFrame(0);
+  const std::size_t row_bytes = 4 * kWidth;
+  for (auto _ : state) {
+    for (int y = 0; y < kHeight; ++y) {
+      BlendBytes(std::span(image_a.constScanLine(y), row_bytes),
+                 std::span(image_b.constScanLine(y), row_bytes), 155,
+                 std::span(image.scanLine(y), row_bytes));
+    }
+    benchmark::DoNotOptimize(image.constBits());
+  }
+  state.SetBytesProcessed(kFrameBytes * state.iterations());
+}
+BENCHMARK(BM_BlendBytes);
+
+// Four output frames per input frame, e.g. 15 Hz spectra displayed at 60 Hz.
+static void BM_Interpolate(benchmark::State& state) {
+  const auto mode = static_cast<InterpolationMode>(state.range(0));
+  std::vector<QImage> source;
+  for (int i = 0; i < 16; ++i) {
+    QImage image(kWidth, kHeight, QImage::Format_RGB32);
+    image.fill(i % 2 ? 0xFF'FF'FF'FF : 0xFF'00'00'00);
+    SetFrameGeometry(image, 0, QPoint(0, 0));
+    SetFrameScrollPosition(image, i);
+    source.push_back(std::move(image));
+  }
+
+  std::int64_t frames = 0;
+  for (auto _ : state) {
+    [&]() -> Task<> {
+      auto interpolated = Interpolate(source, {1, 15}, {1, 60}, mode);
+      while (DisplayFrame* frame = co_await interpolated) {
+        benchmark::DoNotOptimize(frame->image.constBits());
+        ++frames;
+      }
+    }()
+                 .Wait();
+  }
+  state.SetItemsProcessed(frames);
+  state.SetBytesProcessed(frames * kFrameBytes);
+}
+BENCHMARK(BM_Interpolate)
+    ->ArgName("mode")
+    ->Arg(static_cast<int>(InterpolationMode::kBlend))
+    ->Arg(static_cast<int>(InterpolationMode::kScroll));
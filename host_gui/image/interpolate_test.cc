@@ -6,10 +6,12 @@
 #include <QtGui/QImage>
 
 #include "diy/coro/async_generator.h"
+#include "frame_geometry.h"
 
 constexpr std::size_t kWidth = 2;
 constexpr std::size_t kHeight = 2;
 
+using testing::_;
 using testing::ElementsAre;
 using testing::IsEmpty;
 using testing::IsNull;
@@ -21,7 +23,20 @@ QImage FilledImage(std::uint32_t value) {
   return image;
 }
 
-std::uint32_t Value(const QImage& image) { return image.pixel(0, 0); }
+// Image wide enough to be scrolled by a few columns, at the given
+// SetFrameScrollPosition() position.
+QImage ScrolledImage(std::uint32_t value, std::int64_t position) {
+  QImage image(8, kHeight, QImage::Format_ARGB32);
+  image.fill(value);
+  SetFrameScrollPosition(image, position);
+  return image;
+}
+
+std::uint32_t Value(const DisplayFrame& frame) {
+  return frame.image.pixel(0, 0);
+}
+
+double Shift(const DisplayFrame& frame) { return frame.shift; }
 
 TEST(InterpolateTest, EmptyInput) {
   auto gen = Interpolate(std::vector<QImage>(), Rational{1, 1}, Rational{1, 1});
@@ -46,3 +61,139 @@ TEST(InterpolateTest, Blend50) {
   EXPECT_THAT(Interpolate(source, {1, 1}, {1, 2}).Map(Value).ToVector(),
               ElementsAre(100, 150, 200, 225, 250));
 }
+
+TEST(InterpolateTest, InputTimebaseChange) {
+  std::vector<QImage> source = {
+      FilledImage(100),
+      FilledImage(200),
+      FilledImage(250),
+  };
+  // The second input frame interval is half as long as the first.
+  auto input_timebase = [calls = 0]() mutable -> Rational {
+    return ++calls == 1 ? Rational{1, 1} : Rational{1, 2};
+  };
+  EXPECT_THAT(
+      Interpolate(source, std::move(input_timebase), {1, 2}).Map(Value)
+          .ToVector(),
+      ElementsAre(100, 150, 200, 250));
+}
+
+TEST(InterpolateTest, InputFasterThanOutput) {
+  std::vector<QImage> source = {
+      FilledImage(100), FilledImage(200), FilledImage(210),
+      FilledImage(220), FilledImage(230), FilledImage(240),
+  };
+  // Switches to input frames half as long as output frames while running, as
+  // when the hop size is reduced below the refresh period.
+  auto input_timebase = [calls = 0]() mutable -> Rational {
+    return ++calls == 1 ? Rational{1, 1} : Rational{1, 4};
+  };
+  EXPECT_THAT(
+      Interpolate(source, std::move(input_timebase), {1, 2}).Map(Value)
+          .ToVector(),
+      ElementsAre(100, 150, 200, 220, 240));
+}
+
+TEST(InterpolateTest, BlendNotShifted) {
+  std::vector<QImage> source = {
+      ScrolledImage(100, 0),
+      ScrolledImage(200, 1),
+  };
+  EXPECT_THAT(Interpolate(source, {1, 1}, {1, 2}).Map(Shift).ToVector(),
+              ElementsAre(0, 0, 0));
+}
+
+TEST(InterpolateTest, Scroll50) {
+  std::vector<QImage> source = {
+      ScrolledImage(100, 0),
+      ScrolledImage(200, 1),
+      ScrolledImage(250, 3),
+  };
+  // Pixels are never blended; the newer frame is displaced instead.
+  EXPECT_THAT(Interpolate(source, {1, 1}, {1, 2}, InterpolationMode::kScroll)
+                  .Map(Value)
+                  .ToVector(),
+              ElementsAre(200, 200, 200, 250, 250));
+  EXPECT_THAT(Interpolate(source, {1, 1}, {1, 2}, InterpolationMode::kScroll)
+                  .Map(Shift)
+                  .ToVector(),
+              ElementsAre(1, 0.5, 0, 1, 0));
+}
+
+TEST(InterpolateTest, ScrollPassesThroughUnscrolledFrames) {
+  std::vector<QImage> source = {
+      ScrolledImage(100, 5),
+      ScrolledImage(200, 5),
+      // Scrolled backwards.
+      ScrolledImage(250, 4),
+  };
+  EXPECT_THAT(Interpolate(source, {1, 1}, {1, 2}, InterpolationMode::kScroll)
+                  .Map(Value)
+                  .ToVector(),
+              ElementsAre(200, 200, 200, 250, 250));
+  EXPECT_THAT(Interpolate(source, {1, 1}, {1, 2}, InterpolationMode::kScroll)
+                  .Map(Shift)
+                  .ToVector(),
+              ElementsAre(0, 0, 0, 0, 0));
+}
+
+TEST(InterpolateTest, ScrollPassesThroughGeometryChange) {
+  QImage cropped = ScrolledImage(200, 1);
+  cropped.setOffset(QPoint(1, 0));
+  std::vector<QImage> source = {
+      ScrolledImage(100, 0),
+      cropped,
+  };
+  EXPECT_THAT(Interpolate(source, {1, 1}, {1, 2}, InterpolationMode::kScroll)
+                  .Map(Shift)
+                  .ToVector(),
+              ElementsAre(0, 0, 0));
+}
+
+std::int64_t CacheKey(const DisplayFrame& frame) {
+  return frame.image.cacheKey();
+}
+
+std::size_t DistinctFrames(std::vector<DisplayFrame> frames) {
+  std::size_t distinct = 0;
+  for (std::size_t i = 0; i < frames.size(); ++i) {
+    if (i == 0 || !SameDisplayFrame(frames[i - 1], frames[i])) {
+      ++distinct;
+    }
+  }
+  return distinct;
+}
+
+TEST(InterpolateTest, BlendEndpointsReuseInputs) {
+  std::vector<QImage> source = {
+      FilledImage(100),
+      FilledImage(200),
+  };
+  EXPECT_THAT(Interpolate(source, {1, 1}, {1, 2}).Map(CacheKey).ToVector(),
+              ElementsAre(source[0].cacheKey(), _, source[1].cacheKey()));
+}
+
+// Consecutive output frames too similar to tell apart are the same frame.
+TEST(InterpolateTest, BlendReusesNearIdenticalFrames) {
+  std::vector<QImage> source = {
+      FilledImage(0),
+      FilledImage(255),
+  };
+  auto frames = Interpolate(source, {1, 1}, {1, 1000}).ToVector();
+  ASSERT_EQ(frames.size(), 1001);
+  const std::size_t distinct = DistinctFrames(std::move(frames));
+  EXPECT_LT(distinct, 200);
+  EXPECT_GT(distinct, 100);
+}
+
+TEST(InterpolateTest, ScrollReusesNearIdenticalFrames) {
+  std::vector<QImage> source = {
+      ScrolledImage(100, 0),
+      ScrolledImage(200, 1),
+  };
+  auto frames =
+      Interpolate(source, {1, 1}, {1, 1000}, InterpolationMode::kScroll)
+          .ToVector();
+  ASSERT_EQ(frames.size(), 1001);
+  EXPECT_LE(DistinctFrames(std::move(frames)), 17);
+}
@@ -0,0 +1,107 @@
+#include "lut.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "diy/fast_log.h"
+
+namespace {
+
+// Scalar version of the per-value LogLutMap() computation.
+std::uint32_t LogLutMapValue(double value, double min, double max,
+                             double scale_factor,
+                             std::span<const std::uint32_t, 256> lut_entries) {
+  const double clamped = std::min(std::max(std::log2(value + 1), min), max);
+  const auto index =
+      static_cast<std::uint8_t>((clamped - min) * scale_factor + 0.5);
+  return lut_entries[index];
+}
+
+}  // namespace
+
+void LogLutMap(std::span<const double> psd, std::span<std::uint32_t> dest,
+               double min, double max,
+               std::span<const std::uint32_t, 256> lut_entries) {
+  assert(psd.size() == dest.size());
+  const std::size_t n = psd.size();
+  // Scales from range [0, (max-min)] to range [0, 255]
+  const double scale_factor = 255.0 / (max - min);
+
+  std::size_t i = 0;
+#ifdef __AVX2__
+  const __m256d min_vec = _mm256_set1_pd(min);
+  const __m256d max_vec = _mm256_set1_pd(max);
+  const __m256d scale_vec = _mm256_set1_pd(scale_factor);
+  const __m256d half_vec = _mm256_set1_pd(0.5);
+  const __m256d one_vec = _mm256_set1_pd(1.0);
+  // Maps 4 PSD values starting at `offset` to 4 LUT indices.
+  auto indices = [&](std::size_t offset) {
+    __m256d v = _mm256_loadu_pd(psd.data() + offset);
+    v = FastLog2(_mm256_add_pd(v, one_vec));
+    v = _mm256_min_pd(_mm256_max_pd(v, min_vec), max_vec);
+    v = _mm256_mul_pd(_mm256_sub_pd(v, min_vec), scale_vec);
+    return _mm256_cvttpd_epi32(_mm256_add_pd(v, half_vec));
+  };
+  const auto* lut = reinterpret_cast<const int*>(lut_entries.data());
+  for (; i + 8 <= n; i += 8) {
+    const __m256i index_vec = _mm256_set_m128i(indices(i + 4), indices(i));
+    const __m256i pixels = _mm256_i32gather_epi32(lut, index_vec, 4);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest.data() + i), pixels);
+  }
+#endif
+  for (; i < n; ++i) {
+    dest[i] = LogLutMapValue(psd[i], min, max, scale_factor, lut_entries);
+  }
+}
+
+void ToLogLevels(std::span<const double> psd,
+                 std::span<std::uint16_t> levels) {
+  assert(psd.size() == levels.size());
+  const std::size_t n = psd.size();
+  constexpr double scale_factor = (kLogLevels - 1) / kLogDomainMax;
+
+  std::size_t i = 0;
+#ifdef __AVX2__
+  const __m256d one_vec = _mm256_set1_pd(1.0);
+  const __m256d scale_vec = _mm256_set1_pd(scale_factor);
+  const __m256d half_vec = _mm256_set1_pd(0.5);
+  const __m256d max_level_vec = _mm256_set1_pd(kLogLevels - 1);
+  // Maps 4 PSD values starting at `offset` to 4 levels.
+  auto to_levels = [&](std::size_t offset) {
+    __m256d v = _mm256_loadu_pd(psd.data() + offset);
+    v = _mm256_fmadd_pd(FastLog2(_mm256_add_pd(v, one_vec)), scale_vec,
+                        half_vec);
+    return _mm256_cvttpd_epi32(_mm256_min_pd(v, max_level_vec));
+  };
+  for (; i + 8 <= n; i += 8) {
+    const __m128i packed = _mm_packus_epi32(to_levels(i), to_levels(i + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(levels.data() + i), packed);
+  }
+#endif
+  for (; i < n; ++i) {
+    const double level = std::log2(psd[i] + 1) * scale_factor + 0.5;
+    levels[i] =
+        static_cast<std::uint16_t>(std::min(level, double{kLogLevels - 1}));
+  }
+}
+
+void BuildDisplayLut(std::span<const std::uint32_t, 256> colormap, double min,
+                     double max,
+                     std::span<std::uint32_t, kLogLevels> display_lut) {
+  if (!(min < max)) {
+    // Degenerate range; e.g. no data has been observed yet.
+    std::ranges::fill(display_lut, colormap[0]);
+    return;
+  }
+  std::array<double, kLogLevels> values;
+  for (std::size_t level = 0; level < kLogLevels; ++level) {
+    values[level] = FromLogLevel(level);
+  }
+  std::array<std::uint8_t, kLogLevels> indexed;
+  ToIndexed(values, indexed, min, max);
+  std::ranges::transform(indexed, display_lut.begin(),
+                         [&](std::uint8_t i) { return colormap[i]; });
+}
@@ -2,6 +2,8 @@
 
 #include <Eigen/Core>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <span>
 
 // Given the input `values` and an equal-length output `indexed`, maps each
@@ -28,16 +30,73 @@ inline void ToIndexed(std::span<const double> values,
   dest = (scaled + 0.5).template cast<std::uint8_t>();
 }
 
-// Given a 2D array of uint8_t `source`, and a matching dimension 2D array of
-// uint32_t `dest`, maps each input value to an output value using the given
-// lookup table.
-template <typename Source, typename Dest>
+// Fused equivalent of applying log2(v + 1), ToIndexed(), and a LUT lookup to
+// each value of the raw PSD column `psd`, writing the resulting RGB32 pixels to
+// the equal-length output `dest`. This makes a single pass over the data rather
+// than materializing the intermediate log and indexed columns. The logarithm
+// is approximated, so values lying right at the boundary between two indices
+// may land in the neighboring index compared to the staged computation.
+void LogLutMap(std::span<const double> psd, std::span<std::uint32_t> dest,
+               double min, double max,
+               std::span<const std::uint32_t, 256> lut_entries);
+
+// Number of levels in the stable quantized log-power domain.
+inline constexpr std::size_t kLogLevels = 4096;
+// log2(psd + 1) value represented by the highest level. Larger values are
+// clamped.
+inline constexpr double kLogDomainMax = 32;
+
+// Given the raw PSD column `psd` and an equal-length output `levels`, maps each
+// log2(psd + 1) value from the range [0, kLogDomainMax] to [0, kLogLevels).
+// Unlike ToIndexed(), this mapping doesn't depend on the observed range of
+// values, so levels stay valid as the display range changes.
+void ToLogLevels(std::span<const double> psd, std::span<std::uint16_t> levels);
+
+// Inverse of ToLogLevels(): returns the log2(psd + 1) value of `level`.
+constexpr double FromLogLevel(std::size_t level) {
+  return level * (kLogDomainMax / (kLogLevels - 1));
+}
+
+// Power spectral density value represented by `level`, for readouts.
+inline double PowerFromLogLevel(std::size_t level) {
+  return std::exp2(FromLogLevel(level)) - 1;
+}
+
+// Composes the log-level to display-range normalization with `colormap`,
+// producing a LUT that maps a ToLogLevels() output directly to a color. Values
+// outside of [min, max] (in log2(psd + 1) units) are clamped.
+void BuildDisplayLut(std::span<const std::uint32_t, 256> colormap, double min,
+                     double max,
+                     std::span<std::uint32_t, kLogLevels> display_lut);
+
+namespace internal {
+
+template <std::size_t N, typename Source, typename Dest>
 void LutMap(Source&& source, Dest&& dest,
-            std::span<const std::uint32_t, 256> lut_entries) {
+            std::span<const std::uint32_t, N> lut_entries) {
   using namespace Eigen;
-  auto lut = Map<const Array<std::uint32_t, 256, 1>>(lut_entries.data());
+  auto lut = Map<const Array<std::uint32_t, N, 1>>(lut_entries.data());
   const std::size_t rows = source.rows();
   for (std::size_t r = 0; r < rows; ++r) {
     dest.row(r) = lut(source.row(r));
   }
 }
+
+}  // namespace internal
+
+// Given a 2D array of uint8_t `source`, and a matching dimension 2D array of
+// uint32_t `dest`, maps each input value to an output value using the given
+// lookup table.
+template <typename Source, typename Dest>
+void LutMap(Source&& source, Dest&& dest,
+            std::span<const std::uint32_t, 256> lut_entries) {
+  internal::LutMap(source, dest, lut_entries);
+}
+
+// Same as above, but for a uint16_t `source` of ToLogLevels() outputs mapped
+// through a BuildDisplayLut() table.
+template <typename Source, typename Dest>
+void LutMap(Source&& source, Dest&& dest,
+            std::span<const std::uint32_t, kLogLevels> lut_entries) {
+  internal::LutMap(source, dest, lut_entries);
+}
@@ -2,6 +2,7 @@
 
 #include <Eigen/Core>
 #include <QImage>
+#include <cmath>
 #include <random>
 #include <ranges>
 
@@ -38,6 +39,39 @@ static void BM_ToIndexed(benchmark::State& state) {
   state.SetItemsProcessed(n * state.iterations());
 }
 
+// Staged equivalent of LogLutMap(): log2, ToIndexed(), then LUT lookup.
+static void BM_StagedLogLutMap(benchmark::State& state) {
+  static std::array<std::uint32_t, 256> lut = RandomLut();
+  const std::size_t n = state.range(0);
+  const std::vector<double> values = RandomDoubles(n);
+  std::vector<double> logs(n);
+  std::vector<std::uint8_t> indexed(n);
+  std::vector<std::uint32_t> pixels(n);
+
+  for (auto _ : state) {
+    std::ranges::transform(values, logs.begin(),
+                           [](double v) { return std::log2(v + 1); });
+    ToIndexed(logs, indexed, 0, 1);
+    std::ranges::transform(indexed, pixels.begin(),
+                           [](std::uint8_t i) { return lut[i]; });
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  state.SetItemsProcessed(n * state.iterations());
+}
+
+static void BM_LogLutMap(benchmark::State& state) {
+  static std::array<std::uint32_t, 256> lut = RandomLut();
+  const std::size_t n = state.range(0);
+  const std::vector<double> values = RandomDoubles(n);
+  std::vector<std::uint32_t> pixels(n);
+
+  for (auto _ : state) {
+    LogLutMap(values, pixels, 0, 1, lut);
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  state.SetItemsProcessed(n * state.iterations());
+}
+
 static void BM_LutMap(benchmark::State& state) {
   static std::array<std::uint32_t, 256> lut = RandomLut();
   const std::size_t width = state.range(0);
@@ -66,6 +100,22 @@ BENCHMARK(BM_ToIndexed)
     ->Arg(4096)
     ->Arg(8192);
 
+BENCHMARK(BM_StagedLogLutMap)
+    ->Arg(256)
+    ->Arg(512)
+    ->Arg(1024)
+    ->Arg(2048)
+    ->Arg(4096)
+    ->Arg(8192);
+
+BENCHMARK(BM_LogLutMap)
+    ->Arg(256)
+    ->Arg(512)
+    ->Arg(1024)
+    ->Arg(2048)
+    ->Arg(4096)
+    ->Arg(8192);
+
 BENCHMARK(BM_LutMap)
     ->ArgNames({"width", "height"})
     ->ArgsProduct({Sizes(), Sizes()});
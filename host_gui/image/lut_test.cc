@@ -3,7 +3,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <limits>
 #include <ranges>
+#include <vector>
 
 using testing::ElementsAre;
 
@@ -57,3 +60,113 @@ TEST(LutMapTest, LinearMapping) {
   EXPECT_THAT(dest,
               ArrayElementsAre({{0, 1001, 2002}, {253253, 254254, 255255}}));
 }
+
+TEST(LogLutMapTest, MatchesStagedPipeline) {
+  std::array<std::uint32_t, 256> lut;
+  for (int i = 0; i < lut.size(); ++i) {
+    lut[i] = 1001 * i;
+  }
+  // Odd length to exercise both the vectorized and the scalar tail paths.
+  // Includes values below and above the [min, max] range.
+  std::vector<double> psd;
+  for (int i = 0; i < 37; ++i) {
+    psd.push_back(std::pow(1.7, i) - 1);
+  }
+  const double min = 3.0;
+  const double max = 20.0;
+
+  std::vector<double> logs(psd.size());
+  std::ranges::transform(psd, logs.begin(),
+                         [](double v) { return std::log2(v + 1); });
+  std::vector<std::uint8_t> indexed(psd.size());
+  ToIndexed(logs, indexed, min, max);
+  std::vector<std::uint32_t> expected(psd.size());
+  std::ranges::transform(indexed, expected.begin(),
+                         [&](std::uint8_t i) { return lut[i]; });
+
+  std::vector<std::uint32_t> fused(psd.size());
+  LogLutMap(psd, fused, min, max, lut);
+  // The fused kernel approximates the logarithm, so allow off-by-one indices.
+  std::vector<testing::Matcher<std::uint32_t>> matchers;
+  for (std::uint32_t pixel : expected) {
+    matchers.push_back(testing::AnyOf(pixel, pixel - 1001, pixel + 1001));
+  }
+  EXPECT_THAT(fused, testing::ElementsAreArray(matchers));
+}
+
+TEST(LogLevelsTest, RoundTrips) {
+  // log2(psd + 1) values spanning the level domain, plus one out-of-range
+  // value which should be clamped to the highest level.
+  std::vector<double> logs;
+  for (int i = 0; i < 33; ++i) {
+    logs.push_back(i * 0.97);
+  }
+  logs.push_back(kLogDomainMax + 5);
+  std::vector<double> psd(logs.size());
+  std::ranges::transform(logs, psd.begin(),
+                         [](double l) { return std::exp2(l) - 1; });
+
+  std::vector<std::uint16_t> levels(psd.size());
+  ToLogLevels(psd, levels);
+
+  constexpr double kLevelWidth = kLogDomainMax / (kLogLevels - 1);
+  for (std::size_t i = 0; i + 1 < logs.size(); ++i) {
+    EXPECT_NEAR(FromLogLevel(levels[i]), logs[i], kLevelWidth) << i;
+  }
+  EXPECT_EQ(levels.back(), kLogLevels - 1);
+}
+
+TEST(LogLevelsTest, PowerRoundTrips) {
+  const std::vector<double> psd = {0, 1, 10, 1e3, 1e6, 1e9};
+  std::vector<std::uint16_t> levels(psd.size());
+  ToLogLevels(psd, levels);
+  // Half a level in log2 units is a relative error of ~0.3%.
+  for (std::size_t i = 0; i < psd.size(); ++i) {
+    EXPECT_NEAR(PowerFromLogLevel(levels[i]), psd[i], 0.003 * (psd[i] + 1))
+        << psd[i];
+  }
+}
+
+TEST(DisplayLutTest, MatchesToIndexed) {
+  std::array<std::uint32_t, 256> colormap;
+  for (int i = 0; i < colormap.size(); ++i) {
+    colormap[i] = 1001 * i;
+  }
+  const double min = 4.0;
+  const double max = 12.0;
+  std::array<std::uint32_t, kLogLevels> display_lut;
+  BuildDisplayLut(colormap, min, max, display_lut);
+
+  for (std::size_t level : {0, 100, 200, 1000, 1300, 2000, 4095}) {
+    const double value = FromLogLevel(level);
+    std::uint8_t index;
+    ToIndexed({&value, 1}, {&index, 1}, min, max);
+    EXPECT_EQ(display_lut[level], colormap[index]) << level;
+  }
+}
+
+TEST(DisplayLutTest, EmptyRange) {
+  std::array<std::uint32_t, 256> colormap;
+  colormap.fill(7);
+  colormap[0] = 3;
+  std::array<std::uint32_t, kLogLevels> display_lut;
+  BuildDisplayLut(colormap, std::numeric_limits<double>::infinity(),
+                  -std::numeric_limits<double>::infinity(), display_lut);
+  EXPECT_THAT(display_lut, testing::Each(3));
+}
+
+TEST(LutMapTest, DisplayLutMapping) {
+  using namespace Eigen;
+
+  std::array<std::uint32_t, kLogLevels> lut;
+  for (int i = 0; i < lut.size(); ++i) {
+    lut[i] = 3 * i;
+  }
+
+  const Array<std::uint16_t, Dynamic, Dynamic> source({{0, 1, 2},
+                                                       {1000, 4000, 4095}});
+  Array<std::uint32_t, Dynamic, Dynamic> dest(2, 3);
+  LutMap(source, dest, lut);
+
+  EXPECT_THAT(dest, ArrayElementsAre({{0, 3, 6}, {3000, 12000, 12285}}));
+}
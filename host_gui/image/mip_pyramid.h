@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "circular_buffer.h"
+
+// A stack of CircularBuffers where each level is half the width and height of
+// the level below it. Level 0 holds the full resolution data, and each
+// successive level is formed by max-pooling 2x2 blocks of the previous level,
+// so that peaks remain visible when viewing coarser levels. Levels are
+// updated incrementally as columns are appended.
+template <typename T>
+class MipPyramid {
+ public:
+  // Creates a pyramid of at most `levels` levels. Fewer levels are created if
+  // halving the dimensions would make a level empty.
+  MipPyramid(std::size_t width, std::size_t height, std::size_t levels,
+             T fill = T{});
+
+  void AppendColumn(std::span<const T> column) noexcept;
+
+  const CircularBuffer<T>& level(std::size_t i) const noexcept {
+    return levels_[i].data;
+  }
+  std::size_t levels() const noexcept { return levels_.size(); }
+
+  std::size_t columns() const noexcept { return level(0).columns(); }
+  std::size_t rows() const noexcept { return level(0).rows(); }
+
+  std::size_t width() const noexcept { return columns(); }
+  std::size_t height() const noexcept { return rows(); }
+
+ private:
+  struct Level {
+    CircularBuffer<T> data;
+    // Row-pooled column waiting for its horizontal neighbor before being
+    // appended to this level. Unused for level 0.
+    std::vector<T> pending;
+    bool has_pending = false;
+  };
+
+  std::vector<Level> levels_;
+};
+
+template <typename T>
+MipPyramid<T>::MipPyramid(std::size_t width, std::size_t height,
+                          std::size_t levels, T fill) {
+  for (std::size_t i = 0; i < levels && width > 0 && height > 0; ++i) {
+    levels_.push_back({.data = CircularBuffer<T>(width, height, fill),
+                       .pending = std::vector<T>(height)});
+    width /= 2;
+    height = (height + 1) / 2;
+  }
+}
+
+template <typename T>
+void MipPyramid<T>::AppendColumn(std::span<const T> column) noexcept {
+  levels_[0].data.AppendColumn(column);
+  for (std::size_t i = 1; i < levels_.size(); ++i) {
+    Level& level = levels_[i];
+    // Pool adjacent rows of the column just appended to the previous level.
+    const std::size_t rows = level.data.rows();
+    for (std::size_t r = 0; r < rows; ++r) {
+      const std::size_t a = 2 * r;
+      const std::size_t b = std::min(a + 1, column.size() - 1);
+      const T pooled = std::max(column[a], column[b]);
+      level.pending[r] =
+          level.has_pending ? std::max(level.pending[r], pooled) : pooled;
+    }
+    if (!level.has_pending) {
+      // Wait for the other half of the 2x2 blocks.
+      level.has_pending = true;
+      return;
+    }
+    level.has_pending = false;
+    level.data.AppendColumn(level.pending);
+    column = level.pending;
+  }
+}
@@ -0,0 +1,73 @@
+#include "mip_pyramid.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using testing::ElementsAreArray;
+using testing::Matcher;
+using testing::ResultOf;
+
+// Matcher for the full contents of a CircularBuffer, oldest column first.
+auto BufferElementsAre(std::vector<std::vector<int>> expected) {
+  auto as_2d_vector = [](const CircularBuffer<int>& buffer) {
+    std::vector<std::vector<int>> values(buffer.rows());
+    for (std::size_t r = 0; r < buffer.rows(); ++r) {
+      for (int v : buffer.Older().row(r)) {
+        values[r].push_back(v);
+      }
+      for (int v : buffer.Newer().row(r)) {
+        values[r].push_back(v);
+      }
+    }
+    return values;
+  };
+  std::vector<Matcher<std::vector<int>>> row_matchers;
+  for (const auto& row : expected) {
+    row_matchers.push_back(ElementsAreArray(row));
+  }
+  return ResultOf("data", as_2d_vector, ElementsAreArray(row_matchers));
+}
+
+TEST(MipPyramidTest, Dimensions) {
+  MipPyramid<int> pyramid(8, 5, 10);
+  // 8x5, 4x3, 2x2, 1x1
+  ASSERT_EQ(pyramid.levels(), 4);
+  EXPECT_EQ(pyramid.width(), 8);
+  EXPECT_EQ(pyramid.height(), 5);
+  EXPECT_EQ(pyramid.level(1).width(), 4);
+  EXPECT_EQ(pyramid.level(1).height(), 3);
+  EXPECT_EQ(pyramid.level(2).width(), 2);
+  EXPECT_EQ(pyramid.level(2).height(), 2);
+  EXPECT_EQ(pyramid.level(3).width(), 1);
+  EXPECT_EQ(pyramid.level(3).height(), 1);
+}
+
+TEST(MipPyramidTest, LevelLimit) {
+  MipPyramid<int> pyramid(8, 8, 2);
+  EXPECT_EQ(pyramid.levels(), 2);
+}
+
+TEST(MipPyramidTest, MaxPools) {
+  MipPyramid<int> pyramid(4, 3, 3);
+
+  pyramid.AppendColumn(std::span<const int>({1, 2, 3}));
+  // Level 1 waits for a second column.
+  EXPECT_THAT(pyramid.level(1), BufferElementsAre({{0, 0}, {0, 0}}));
+
+  pyramid.AppendColumn(std::span<const int>({4, 0, 0}));
+  EXPECT_THAT(pyramid.level(0),
+              BufferElementsAre({{0, 0, 1, 4}, {0, 0, 2, 0}, {0, 0, 3, 0}}));
+  EXPECT_THAT(pyramid.level(1), BufferElementsAre({{0, 4}, {0, 3}}));
+  EXPECT_THAT(pyramid.level(2), BufferElementsAre({{0}}));
+
+  pyramid.AppendColumn(std::span<const int>({0, 0, 0}));
+  pyramid.AppendColumn(std::span<const int>({0, 0, 9}));
+  EXPECT_THAT(pyramid.level(1), BufferElementsAre({{4, 0}, {3, 9}}));
+  EXPECT_THAT(pyramid.level(2), BufferElementsAre({{9}}));
+
+  // Older pooled columns are dropped as new ones arrive.
+  pyramid.AppendColumn(std::span<const int>({0, 0, 0}));
+  pyramid.AppendColumn(std::span<const int>({0, 1, 0}));
+  EXPECT_THAT(pyramid.level(1), BufferElementsAre({{0, 1}, {9, 0}}));
+  EXPECT_THAT(pyramid.level(2), BufferElementsAre({{9}}));
+}
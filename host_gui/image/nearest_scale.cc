@@ -0,0 +1,37 @@
+#include "nearest_scale.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cassert>
+
+std::vector<std::int32_t> NearestIndices(int src_size, int dst_size) {
+  std::vector<std::int32_t> indices(std::max(dst_size, 0));
+  for (int i = 0; i < dst_size; ++i) {
+    // Integer form of floor((i + 0.5) * src_size / dst_size).
+    const std::int64_t index =
+        (2 * std::int64_t{i} + 1) * src_size / (2 * std::int64_t{dst_size});
+    indices[i] = std::min<std::int64_t>(index, src_size - 1);
+  }
+  return indices;
+}
+
+void GatherPixels(std::span<const std::uint32_t> src,
+                  std::span<const std::int32_t> indices,
+                  std::span<std::uint32_t> dst) {
+  assert(indices.size() == dst.size());
+  const std::size_t n = dst.size();
+  std::size_t i = 0;
+#ifdef __AVX2__
+  const auto* base = reinterpret_cast<const int*>(src.data());
+  for (; i + 8 <= n; i += 8) {
+    const __m256i index = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(indices.data() + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst.data() + i),
+                        _mm256_i32gather_epi32(base, index, 4));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i] = src[indices[i]];
+  }
+}
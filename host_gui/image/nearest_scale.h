@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Source pixel indices for nearest-neighbor scaling of `src_size` pixels to
+// `dst_size` pixels. Each destination pixel samples the source pixel containing
+// its center.
+std::vector<std::int32_t> NearestIndices(int src_size, int dst_size);
+
+// dst[i] = src[indices[i]] for each i. `indices` and `dst` must be the same
+// size, and all indices must be in range for `src`.
+void GatherPixels(std::span<const std::uint32_t> src,
+                  std::span<const std::int32_t> indices,
+                  std::span<std::uint32_t> dst);
@@ -0,0 +1,44 @@
+#include "nearest_scale.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+using testing::ElementsAre;
+using testing::ElementsAreArray;
+
+TEST(NearestIndicesTest, Identity) {
+  EXPECT_THAT(NearestIndices(4, 4), ElementsAre(0, 1, 2, 3));
+}
+
+TEST(NearestIndicesTest, IntegerUpscale) {
+  EXPECT_THAT(NearestIndices(3, 6), ElementsAre(0, 0, 1, 1, 2, 2));
+}
+
+TEST(NearestIndicesTest, Downscale) {
+  EXPECT_THAT(NearestIndices(6, 3), ElementsAre(1, 3, 5));
+}
+
+TEST(NearestIndicesTest, FractionalUpscale) {
+  EXPECT_THAT(NearestIndices(2, 3), ElementsAre(0, 1, 1));
+}
+
+TEST(NearestIndicesTest, Empty) {
+  EXPECT_THAT(NearestIndices(2, 0), ElementsAre());
+}
+
+// Long enough to exercise both vector and scalar tail paths.
+TEST(GatherPixelsTest, MatchesIndexing) {
+  std::vector<std::uint32_t> src(50);
+  std::iota(src.begin(), src.end(), 1000);
+  const std::vector<std::int32_t> indices = NearestIndices(50, 123);
+  std::vector<std::uint32_t> dst(indices.size());
+  GatherPixels(src, indices, dst);
+
+  std::vector<std::uint32_t> expected;
+  for (std::int32_t index : indices) {
+    expected.push_back(src[index]);
+  }
+  EXPECT_THAT(dst, ElementsAreArray(expected));
+}
@@ -0,0 +1,64 @@
+#include "packed_levels.h"
+
+#include <immintrin.h>
+
+#include <cassert>
+
+// Each pair of values {a, b} is stored as the bytes:
+//   [a bits 0-7] [b bits 0-3, a bits 8-11] [b bits 4-11]
+
+void PackLevels(std::span<const std::uint16_t> levels,
+                std::span<std::uint8_t> packed) {
+  assert(packed.size() == PackedLevelsSize(levels.size()));
+  const std::size_t n = levels.size();
+  std::size_t i = 0;
+  std::uint8_t* out = packed.data();
+  for (; i + 2 <= n; i += 2, out += 3) {
+    const std::uint16_t a = levels[i] & 0xFFF;
+    const std::uint16_t b = levels[i + 1] & 0xFFF;
+    out[0] = a & 0xFF;
+    out[1] = (a >> 8) | ((b & 0xF) << 4);
+    out[2] = b >> 4;
+  }
+  if (i < n) {
+    const std::uint16_t a = levels[i] & 0xFFF;
+    out[0] = a & 0xFF;
+    out[1] = a >> 8;
+  }
+}
+
+void UnpackLevels(std::span<const std::uint8_t> packed,
+                  std::span<std::uint16_t> levels) {
+  assert(packed.size() == PackedLevelsSize(levels.size()));
+  const std::size_t n = levels.size();
+  std::size_t i = 0;
+  const std::uint8_t* in = packed.data();
+#ifdef __AVX2__
+  // Each 128-bit lane unpacks 8 values from 12 bytes. Gather each value's two
+  // bytes into a 16-bit element, then mask off the low 12 bits of even values
+  // and shift out the low 4 bits of odd values.
+  const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11));
+  const __m256i mask = _mm256_set1_epi16(0xFFF);
+  // Each iteration reads 28 bytes, of which only 24 are consumed.
+  for (; i + 16 <= n && 3 * i / 2 + 28 <= packed.size();
+       i += 16, in += 24) {
+    const __m256i bytes = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12)), 1);
+    const __m256i pairs = _mm256_shuffle_epi8(bytes, shuffle);
+    const __m256i even = _mm256_and_si256(pairs, mask);
+    const __m256i odd = _mm256_srli_epi16(pairs, 4);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(levels.data() + i),
+                        _mm256_blend_epi16(even, odd, 0b10101010));
+  }
+#endif
+  for (; i + 2 <= n; i += 2, in += 3) {
+    levels[i] = in[0] | ((in[1] & 0xF) << 8);
+    levels[i + 1] = (in[1] >> 4) | (in[2] << 4);
+  }
+  if (i < n) {
+    levels[i] = in[0] | ((in[1] & 0xF) << 8);
+  }
+}
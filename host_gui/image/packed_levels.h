@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+// Compact storage for 12-bit values such as ToLogLevels() outputs, packing each
+// pair of values into 3 bytes. This is 25% smaller than storing them as
+// uint16_t values, and 81% smaller than storing the corresponding doubles.
+
+// Number of bytes needed to pack `n` values.
+constexpr std::size_t PackedLevelsSize(std::size_t n) {
+  return (3 * n + 1) / 2;
+}
+
+// Packs `levels` into `packed`, which must have length
+// PackedLevelsSize(levels.size()). Only the low 12 bits of each value are kept.
+void PackLevels(std::span<const std::uint16_t> levels,
+                std::span<std::uint8_t> packed);
+
+// Inverse of PackLevels(). `packed` must have length
+// PackedLevelsSize(levels.size()).
+void UnpackLevels(std::span<const std::uint8_t> packed,
+                  std::span<std::uint16_t> levels);
@@ -0,0 +1,48 @@
+#include "packed_levels.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using testing::ElementsAre;
+using testing::ElementsAreArray;
+
+TEST(PackedLevelsTest, Size) {
+  EXPECT_EQ(PackedLevelsSize(0), 0);
+  EXPECT_EQ(PackedLevelsSize(1), 2);
+  EXPECT_EQ(PackedLevelsSize(2), 3);
+  EXPECT_EQ(PackedLevelsSize(3), 5);
+  EXPECT_EQ(PackedLevelsSize(1015), 1523);
+}
+
+TEST(PackedLevelsTest, Layout) {
+  const std::vector<std::uint16_t> levels = {0xABC, 0x123, 0xFED};
+  std::vector<std::uint8_t> packed(PackedLevelsSize(levels.size()));
+  PackLevels(levels, packed);
+  EXPECT_THAT(packed, ElementsAre(0xBC, 0x3A, 0x12, 0xED, 0x0F));
+}
+
+TEST(PackedLevelsTest, DropsHighBits) {
+  const std::vector<std::uint16_t> levels = {0xFABC, 0x1123};
+  std::vector<std::uint8_t> packed(PackedLevelsSize(levels.size()));
+  PackLevels(levels, packed);
+  std::vector<std::uint16_t> unpacked(levels.size());
+  UnpackLevels(packed, unpacked);
+  EXPECT_THAT(unpacked, ElementsAre(0xABC, 0x123));
+}
+
+// Covers lengths on both sides of the vectorized path's thresholds.
+TEST(PackedLevelsTest, RoundTrips) {
+  for (std::size_t n = 0; n < 100; ++n) {
+    std::vector<std::uint16_t> levels(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      levels[i] = (i * 2654435761u) % 4096;
+    }
+    std::vector<std::uint8_t> packed(PackedLevelsSize(n));
+    PackLevels(levels, packed);
+    std::vector<std::uint16_t> unpacked(n);
+    UnpackLevels(packed, unpacked);
+    EXPECT_THAT(unpacked, ElementsAreArray(levels)) << n;
+  }
+}
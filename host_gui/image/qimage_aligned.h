@@ -1,18 +1,20 @@
 #pragma once
 
 #include <QtGui/QImage>
+#include <bit>
+#include <cmath>
 #include <cstdlib>
+#include <new>
 #include <stdexcept>
 
 // AVX2 instructions expect 32-byte alignment.
 constexpr unsigned kDefaultQImageAlignment = 32;
 
-// Creates a QImage of the given dimensions where each scan line is aligned to
-// the number of bytes given by `alignment`. `alignment` must be a power of 2
-// greater than 4.
-inline QImage AlignedQImage(int width, int height,
-                            unsigned alignment = kDefaultQImageAlignment,
-                            QImage::Format format = QImage::Format_RGB32) {
+// Size of each scan line of a 32-bit per pixel image of the given width, padded
+// to a multiple of `alignment`. `alignment` must be a power of 2 greater than
+// 4.
+inline int AlignedBytesPerLine(int width,
+                               unsigned alignment = kDefaultQImageAlignment) {
   if (!std::has_single_bit(alignment)) {
     throw std::invalid_argument("Alignment must be a power of 2.");
   }
@@ -21,12 +23,23 @@ inline QImage AlignedQImage(int width, int height,
   }
   const double width_blocks = static_cast<double>(width) / alignment;
   const int pixel_stride = std::ceil(width_blocks) * alignment;
-  const int bytes_per_line = pixel_stride * 4;
+  return pixel_stride * 4;
+}
+
+// Creates a QImage of the given dimensions where each scan line is aligned to
+// the number of bytes given by `alignment`. `alignment` must be a power of 2
+// greater than 4.
+inline QImage AlignedQImage(int width, int height,
+                            unsigned alignment = kDefaultQImageAlignment,
+                            QImage::Format format = QImage::Format_RGB32) {
+  const int bytes_per_line = AlignedBytesPerLine(width, alignment);
 
   auto* data = reinterpret_cast<unsigned char*>(
       std::aligned_alloc(alignment, height * bytes_per_line));
-  constexpr auto cleanup = [](void* data) {
-    delete reinterpret_cast<unsigned char*>(data);
-  };
+  if (data == nullptr) {
+    throw std::bad_alloc();
+  }
+  // Memory from aligned_alloc() must be released with free().
+  constexpr auto cleanup = [](void* data) { std::free(data); };
   return QImage(data, width, height, bytes_per_line, format, cleanup, data);
 }
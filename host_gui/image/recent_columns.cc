@@ -0,0 +1,45 @@
+#include "recent_columns.h"
+
+#include <cassert>
+
+RecentColumns::RecentColumns(std::size_t capacity, std::size_t height)
+    : capacity_(capacity),
+      height_(height),
+      tags_(capacity),
+      values_(capacity * height) {
+  for (auto& tag : tags_) {
+    tag.store(-1, std::memory_order_relaxed);
+  }
+}
+
+void RecentColumns::AppendColumn(std::span<const std::uint16_t> column) {
+  assert(column.size() == height_);
+  const std::int64_t index = columns_.load(std::memory_order_relaxed);
+  const std::size_t slot = index % capacity_;
+  tags_[slot].store(-1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::atomic<std::uint16_t>* values = &values_[slot * height_];
+  for (std::size_t row = 0; row < height_; ++row) {
+    values[row].store(column[row], std::memory_order_relaxed);
+  }
+  tags_[slot].store(index, std::memory_order_release);
+  columns_.store(index + 1, std::memory_order_release);
+}
+
+std::optional<std::uint16_t> RecentColumns::Read(std::int64_t column,
+                                                 std::size_t row) const {
+  if (column < 0 || row >= height_) {
+    return std::nullopt;
+  }
+  const std::size_t slot = column % capacity_;
+  if (tags_[slot].load(std::memory_order_acquire) != column) {
+    return std::nullopt;
+  }
+  const std::uint16_t value =
+      values_[slot * height_ + row].load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (tags_[slot].load(std::memory_order_relaxed) != column) {
+    return std::nullopt;
+  }
+  return value;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+// Ring of the most recently appended columns of values, readable from any
+// thread without locks while a single writer keeps appending.
+//
+// Each slot is tagged with the index of the column it holds, which acts as the
+// slot's sequence number: a reader that races with the column being
+// overwritten sees the tag change and gets no value, and the writer never
+// waits for readers.
+class RecentColumns {
+ public:
+  RecentColumns(std::size_t capacity, std::size_t height);
+
+  std::size_t capacity() const { return capacity_; }
+  std::size_t height() const { return height_; }
+
+  // Total number of columns appended.
+  std::int64_t columns() const {
+    return columns_.load(std::memory_order_acquire);
+  }
+
+  // Must only be called from one thread at a time.
+  void AppendColumn(std::span<const std::uint16_t> column);
+
+  // The value at `row` of the column with the given index, or nullopt if that
+  // column hasn't been appended or has been overwritten.
+  std::optional<std::uint16_t> Read(std::int64_t column,
+                                    std::size_t row) const;
+
+ private:
+  const std::size_t capacity_;
+  const std::size_t height_;
+  std::atomic<std::int64_t> columns_ = 0;
+  // Index of the column held in each slot, or -1 while a slot is being
+  // written.
+  std::vector<std::atomic<std::int64_t>> tags_;
+  // Column-major values.
+  std::vector<std::atomic<std::uint16_t>> values_;
+};
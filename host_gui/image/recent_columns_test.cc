@@ -0,0 +1,65 @@
+#include "recent_columns.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using testing::Eq;
+using testing::Optional;
+
+std::vector<std::uint16_t> Column(std::size_t height, std::uint16_t value) {
+  return std::vector<std::uint16_t>(height, value);
+}
+
+TEST(RecentColumnsTest, Empty) {
+  RecentColumns columns(4, 2);
+  EXPECT_EQ(columns.columns(), 0);
+  EXPECT_EQ(columns.Read(0, 0), std::nullopt);
+}
+
+TEST(RecentColumnsTest, ReadsAppendedColumns) {
+  RecentColumns columns(4, 2);
+  columns.AppendColumn(std::vector<std::uint16_t>{1, 2});
+  columns.AppendColumn(std::vector<std::uint16_t>{3, 4});
+  EXPECT_EQ(columns.columns(), 2);
+  EXPECT_THAT(columns.Read(0, 0), Optional(1));
+  EXPECT_THAT(columns.Read(0, 1), Optional(2));
+  EXPECT_THAT(columns.Read(1, 0), Optional(3));
+  EXPECT_THAT(columns.Read(1, 1), Optional(4));
+  EXPECT_EQ(columns.Read(2, 0), std::nullopt);
+  EXPECT_EQ(columns.Read(1, 2), std::nullopt);
+  EXPECT_EQ(columns.Read(-1, 0), std::nullopt);
+}
+
+TEST(RecentColumnsTest, OldColumnsOverwritten) {
+  RecentColumns columns(2, 1);
+  for (std::uint16_t i = 0; i < 5; ++i) {
+    columns.AppendColumn(Column(1, i));
+  }
+  EXPECT_EQ(columns.Read(2, 0), std::nullopt);
+  EXPECT_THAT(columns.Read(3, 0), Optional(3));
+  EXPECT_THAT(columns.Read(4, 0), Optional(4));
+}
+
+// Readers only ever see the value written for the column they asked for.
+TEST(RecentColumnsTest, ConcurrentReadsConsistent) {
+  constexpr std::size_t kHeight = 64;
+  RecentColumns columns(4, kHeight);
+  constexpr std::uint16_t kWrites = 20'000;
+  std::jthread writer([&] {
+    for (std::uint16_t i = 0; i < kWrites; ++i) {
+      columns.AppendColumn(Column(kHeight, i));
+    }
+  });
+  std::jthread reader([&] {
+    while (columns.columns() < kWrites) {
+      const std::int64_t newest = columns.columns() - 1;
+      for (std::size_t row = 0; row < kHeight; ++row) {
+        if (const auto value = columns.Read(newest, row)) {
+          ASSERT_EQ(*value, newest);
+        }
+      }
+    }
+  });
+}
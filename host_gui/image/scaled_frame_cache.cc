@@ -0,0 +1,81 @@
+#include "scaled_frame_cache.h"
+
+#include <cmath>
+#include <cstring>
+#include <span>
+
+#include "frame_geometry.h"
+#include "nearest_scale.h"
+#include "qimage_aligned.h"
+
+namespace {
+
+std::span<const std::uint32_t> ConstRow(const QImage& image, int y) {
+  return std::span(reinterpret_cast<const std::uint32_t*>(
+                       image.constScanLine(y)),
+                   image.width());
+}
+
+std::span<std::uint32_t> Row(QImage& image, int y) {
+  return std::span(reinterpret_cast<std::uint32_t*>(image.scanLine(y)),
+                   image.width());
+}
+
+}  // namespace
+
+const QImage& ScaledFrameCache::Scale(const QImage& image, QSize size,
+                                      double device_pixel_ratio) {
+  scaled_columns_ = 0;
+  const bool same_size = !scaled_.isNull() && scaled_.size() == size &&
+                         source_.size() == image.size() &&
+                         source_.format() == image.format();
+  if (same_size && image.cacheKey() == source_.cacheKey()) {
+    scaled_.setDevicePixelRatio(device_pixel_ratio);
+    return scaled_;
+  }
+
+  int first_column = 0;
+  if (same_size) {
+    const std::int64_t distance =
+        FrameScrollPosition(image) - FrameScrollPosition(source_);
+    const double scale = static_cast<double>(size.width()) / image.width();
+    const std::int64_t pixels = distance * std::lround(scale);
+    if (SameFrameGeometry(image, source_) &&
+        FrameColors(image) == FrameColors(source_) && distance > 0 &&
+        scale == std::round(scale) && pixels < size.width()) {
+      // Everything but the new columns is already scaled, just further right.
+      for (int y = 0; y < scaled_.height(); ++y) {
+        const std::span<std::uint32_t> row = Row(scaled_, y);
+        std::memmove(row.data(), row.data() + pixels,
+                     (row.size() - pixels) * sizeof(std::uint32_t));
+      }
+      first_column = size.width() - pixels;
+    }
+  } else {
+    scaled_ = AlignedQImage(size.width(), size.height(),
+                            kDefaultQImageAlignment, image.format());
+    column_indices_ = NearestIndices(image.width(), size.width());
+    row_indices_ = NearestIndices(image.height(), size.height());
+  }
+  source_ = image;
+  ScaleColumns(first_column);
+  scaled_.setDevicePixelRatio(device_pixel_ratio);
+  return scaled_;
+}
+
+void ScaledFrameCache::ScaleColumns(int first_column) {
+  const auto columns = std::span(column_indices_).subspan(first_column);
+  scaled_columns_ = columns.size();
+  for (int y = 0; y < scaled_.height(); ++y) {
+    const std::span<std::uint32_t> row = Row(scaled_, y).subspan(first_column);
+    if (y > 0 && row_indices_[y] == row_indices_[y - 1]) {
+      // Upscaled rows repeat the previous row.
+      const std::span<std::uint32_t> previous =
+          Row(scaled_, y - 1).subspan(first_column);
+      std::memcpy(row.data(), previous.data(),
+                  row.size() * sizeof(std::uint32_t));
+      continue;
+    }
+    GatherPixels(ConstRow(source_, row_indices_[y]), columns, row);
+  }
+}
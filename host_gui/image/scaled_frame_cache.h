@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <cstdint>
+#include <vector>
+
+// Nearest-neighbor scaled copy of the most recently displayed frame, so that
+// painting it is a straight blit.
+class ScaledFrameCache {
+ public:
+  // Returns `image` scaled to `size` pixels, with the given device pixel ratio.
+  //
+  // The previous result is reused if `image` and `size` are unchanged. If
+  // `image` is the previous image scrolled by whole columns with the same
+  // colors (see frame_geometry.h), and each column scales to a whole number of
+  // pixels, then only the newly appended columns are scaled.
+  const QImage& Scale(const QImage& image, QSize size,
+                      double device_pixel_ratio = 1);
+
+  // Number of destination columns computed by the last call to Scale().
+  int scaled_columns() const { return scaled_columns_; }
+
+ private:
+  // Scales `source_` columns into destination columns [first_column, end).
+  void ScaleColumns(int first_column);
+
+  QImage source_;
+  QImage scaled_;
+  std::vector<std::int32_t> column_indices_;
+  std::vector<std::int32_t> row_indices_;
+  int scaled_columns_ = 0;
+};
@@ -0,0 +1,87 @@
+#include "scaled_frame_cache.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "frame_geometry.h"
+
+// Image whose pixel values identify their scroll-invariant column: column x of
+// an image at scroll position p holds value (p + x) * 1000 + y.
+QImage ScrolledImage(int width, int height, std::int64_t position) {
+  QImage image(width, height, QImage::Format_RGB32);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      image.setPixel(x, y, (position + x) * 1000 + y);
+    }
+  }
+  SetFrameGeometry(image, 0, QPoint(0, 0));
+  SetFrameScrollPosition(image, position);
+  return image;
+}
+
+// Reference nearest-neighbor scaling.
+void ExpectScaled(const QImage& scaled, const QImage& image) {
+  ASSERT_EQ(scaled.width() % image.width(), 0);
+  ASSERT_EQ(scaled.height() % image.height(), 0);
+  const int x_scale = scaled.width() / image.width();
+  const int y_scale = scaled.height() / image.height();
+  for (int y = 0; y < scaled.height(); ++y) {
+    for (int x = 0; x < scaled.width(); ++x) {
+      ASSERT_EQ(scaled.pixel(x, y), image.pixel(x / x_scale, y / y_scale))
+          << "(" << x << ", " << y << ")";
+    }
+  }
+}
+
+TEST(ScaledFrameCacheTest, Scales) {
+  ScaledFrameCache cache;
+  const QImage image = ScrolledImage(20, 5, 0);
+  const QImage& scaled = cache.Scale(image, QSize(40, 15), 2);
+  EXPECT_EQ(scaled.size(), QSize(40, 15));
+  EXPECT_EQ(scaled.devicePixelRatio(), 2);
+  EXPECT_EQ(cache.scaled_columns(), 40);
+  ExpectScaled(scaled, image);
+}
+
+TEST(ScaledFrameCacheTest, ReusesUnchangedImage) {
+  ScaledFrameCache cache;
+  const QImage image = ScrolledImage(20, 5, 0);
+  cache.Scale(image, QSize(40, 10));
+  const QImage& scaled = cache.Scale(image, QSize(40, 10));
+  EXPECT_EQ(cache.scaled_columns(), 0);
+  ExpectScaled(scaled, image);
+}
+
+TEST(ScaledFrameCacheTest, ScalesOnlyNewColumns) {
+  ScaledFrameCache cache;
+  cache.Scale(ScrolledImage(20, 5, 0), QSize(40, 10));
+  const QImage image = ScrolledImage(20, 5, 3);
+  const QImage& scaled = cache.Scale(image, QSize(40, 10));
+  EXPECT_EQ(cache.scaled_columns(), 6);
+  ExpectScaled(scaled, image);
+}
+
+TEST(ScaledFrameCacheTest, RescalesWhenColorsChange) {
+  ScaledFrameCache cache;
+  cache.Scale(ScrolledImage(20, 5, 0), QSize(40, 10));
+  QImage image = ScrolledImage(20, 5, 3);
+  SetFrameColors(image, 1);
+  cache.Scale(image, QSize(40, 10));
+  EXPECT_EQ(cache.scaled_columns(), 40);
+}
+
+TEST(ScaledFrameCacheTest, RescalesNonIntegerScale) {
+  ScaledFrameCache cache;
+  cache.Scale(ScrolledImage(20, 5, 0), QSize(30, 10));
+  cache.Scale(ScrolledImage(20, 5, 1), QSize(30, 10));
+  EXPECT_EQ(cache.scaled_columns(), 30);
+}
+
+TEST(ScaledFrameCacheTest, RescalesOnResize) {
+  ScaledFrameCache cache;
+  cache.Scale(ScrolledImage(20, 5, 0), QSize(40, 10));
+  const QImage image = ScrolledImage(20, 5, 1);
+  const QImage& scaled = cache.Scale(image, QSize(60, 10));
+  EXPECT_EQ(cache.scaled_columns(), 60);
+  ExpectScaled(scaled, image);
+}
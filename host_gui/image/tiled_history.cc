@@ -0,0 +1,210 @@
+#include "tiled_history.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "packed_levels.h"
+
+namespace {
+
+std::runtime_error SystemError(const std::string& message) {
+  return std::runtime_error(message + ": " + std::strerror(errno));
+}
+
+int OpenBackingFile(const std::string& path) {
+  if (!path.empty()) {
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      throw SystemError("Failed to open history file " + path);
+    }
+    return fd;
+  }
+  std::string name = "/tmp/mic_history_XXXXXX";
+  const int fd = mkstemp(name.data());
+  if (fd < 0) {
+    throw SystemError("Failed to create temporary history file");
+  }
+  // The file is removed once closed.
+  unlink(name.c_str());
+  return fd;
+}
+
+std::size_t RoundUp(std::size_t n, std::size_t multiple) {
+  return (n + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+// Read-only mapping of a single completed tile.
+class TiledHistory::MappedTile {
+ public:
+  MappedTile(int fd, std::size_t offset, std::size_t size) : size_(size) {
+    data_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, offset);
+    if (data_ == MAP_FAILED) {
+      throw SystemError("Failed to map history tile");
+    }
+  }
+  ~MappedTile() { munmap(data_, size_); }
+
+  MappedTile(const MappedTile&) = delete;
+  MappedTile& operator=(const MappedTile&) = delete;
+
+  const std::uint8_t* data() const {
+    return static_cast<const std::uint8_t*>(data_);
+  }
+
+ private:
+  void* data_;
+  const std::size_t size_;
+};
+
+TiledHistory::TiledHistory(std::size_t height, const Options& options)
+    : height_(height),
+      tile_columns_(options.tile_columns),
+      cache_tiles_(std::max<std::size_t>(options.cache_tiles, 1)),
+      prefetch_tiles_(options.prefetch_tiles),
+      column_bytes_(PackedLevelsSize(height)),
+      tile_stride_(RoundUp(column_bytes_ * tile_columns_,
+                           sysconf(_SC_PAGESIZE))),
+      fd_(OpenBackingFile(options.path)) {
+  if (height_ == 0 || tile_columns_ == 0) {
+    close(fd_);
+    throw std::invalid_argument("History tiles must be non-empty.");
+  }
+  current_tile_.reserve(column_bytes_ * tile_columns_);
+  prefetch_thread_ = std::jthread(&TiledHistory::PrefetchLoop, this);
+}
+
+TiledHistory::~TiledHistory() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  prefetch_thread_.join();
+  // Unmap all tiles before closing the file.
+  cache_.clear();
+  close(fd_);
+}
+
+void TiledHistory::AppendColumn(std::span<const std::uint16_t> column) {
+  assert(column.size() == height_);
+  const std::size_t offset = current_tile_.size();
+  current_tile_.resize(offset + column_bytes_);
+  PackLevels(column, std::span(current_tile_).subspan(offset));
+  if (current_tile_.size() == column_bytes_ * tile_columns_) {
+    std::int64_t tile;
+    {
+      absl::MutexLock lock(&mutex_);
+      tile = completed_tiles_;
+    }
+    const auto* data = reinterpret_cast<const char*>(current_tile_.data());
+    const std::size_t size = current_tile_.size();
+    for (std::size_t written = 0; written < size;) {
+      const ssize_t result = pwrite(fd_, data + written, size - written,
+                                    tile * tile_stride_ + written);
+      if (result < 0) {
+        throw SystemError("Failed to write history tile");
+      }
+      written += result;
+    }
+    absl::MutexLock lock(&mutex_);
+    ++completed_tiles_;
+    current_tile_.clear();
+  }
+  ++columns_;
+}
+
+void TiledHistory::ReadColumn(std::int64_t index,
+                              std::span<std::uint16_t> out) {
+  if (index < 0 || index >= columns_) {
+    throw std::out_of_range("History column " + std::to_string(index) +
+                            " out of range.");
+  }
+  const std::int64_t tile = index / tile_columns_;
+  const std::size_t offset = (index % tile_columns_) * column_bytes_;
+  assert(out.size() == height_);
+  bool completed;
+  {
+    absl::MutexLock lock(&mutex_);
+    completed = tile < completed_tiles_;
+  }
+  if (!completed) {
+    UnpackLevels(std::span(current_tile_).subspan(offset, column_bytes_), out);
+    return;
+  }
+  const std::shared_ptr<const MappedTile> mapped = GetTile(tile);
+  UnpackLevels(std::span(mapped->data() + offset, column_bytes_), out);
+}
+
+void TiledHistory::Prefetch(std::int64_t index, int direction) {
+  const std::int64_t tile = index / tile_columns_;
+  const std::int64_t step = direction < 0 ? -1 : 1;
+  absl::MutexLock lock(&mutex_);
+  // Newer requests supersede older ones.
+  prefetch_queue_.clear();
+  for (std::size_t i = 0; i <= prefetch_tiles_; ++i) {
+    const std::int64_t t = tile + step * static_cast<std::int64_t>(i);
+    if (t < 0 || t >= completed_tiles_) {
+      break;
+    }
+    prefetch_queue_.push_back(t);
+  }
+}
+
+std::shared_ptr<const TiledHistory::MappedTile> TiledHistory::GetTile(
+    std::int64_t tile) {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = std::ranges::find(cache_, tile, [](auto& e) { return e.first; });
+    if (it != cache_.end()) {
+      cache_.splice(cache_.begin(), cache_, it);
+      return it->second;
+    }
+  }
+  // Map outside of the lock so that readers of other tiles aren't blocked. If
+  // two threads race to map the same tile, the duplicate entry is harmless and
+  // eventually evicted.
+  auto mapped = std::make_shared<const MappedTile>(
+      fd_, tile * tile_stride_, column_bytes_ * tile_columns_);
+  absl::MutexLock lock(&mutex_);
+  cache_.emplace_front(tile, mapped);
+  if (cache_.size() > cache_tiles_) {
+    cache_.pop_back();
+  }
+  return mapped;
+}
+
+bool TiledHistory::PrefetchReady() const {
+  return stopping_ || !prefetch_queue_.empty();
+}
+
+void TiledHistory::PrefetchLoop() {
+  while (true) {
+    std::int64_t tile;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &TiledHistory::PrefetchReady));
+      if (stopping_) {
+        return;
+      }
+      tile = prefetch_queue_.front();
+      prefetch_queue_.pop_front();
+    }
+    const std::shared_ptr<const MappedTile> mapped = GetTile(tile);
+    // Touch each page so that the disk read happens here rather than on the
+    // reader's thread.
+    const auto* bytes = reinterpret_cast<const volatile char*>(mapped->data());
+    const std::size_t size = column_bytes_ * tile_columns_;
+    const std::size_t page_size = sysconf(_SC_PAGESIZE);
+    for (std::size_t i = 0; i < size; i += page_size) {
+      bytes[i];
+    }
+  }
+}
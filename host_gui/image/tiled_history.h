@@ -0,0 +1,100 @@
+#pragma once
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Unbounded append-only store of fixed-height columns of 12-bit values (e.g.
+// ToLogLevels() outputs), for scrolling back over long recordings. Columns are
+// stored with PackLevels(), so only the low 12 bits of each value are kept.
+//
+// Columns are grouped into tiles. The tile currently being appended to lives
+// in memory; once full, it's written out to a backing file. Reads of completed
+// tiles go through a small LRU cache of memory-mapped tiles, so memory usage
+// stays bounded no matter how much history has been recorded. Prefetch() maps
+// upcoming tiles on a background thread so that scrolling doesn't stall on
+// disk reads.
+//
+// AppendColumn() and reads of the newest, incomplete tile must happen on the
+// same thread. All other methods are thread-safe.
+class TiledHistory {
+ public:
+  struct Options {
+    // Path of the backing file, which is truncated. If empty, an anonymous
+    // temporary file is used.
+    std::string path;
+    // Number of columns per tile.
+    std::size_t tile_columns = 256;
+    // Maximum number of completed tiles kept mapped in memory.
+    std::size_t cache_tiles = 16;
+    // Number of tiles loaded ahead of the requested position by Prefetch().
+    std::size_t prefetch_tiles = 2;
+  };
+
+  TiledHistory(std::size_t height) : TiledHistory(height, Options()) {}
+  TiledHistory(std::size_t height, const Options& options);
+  ~TiledHistory();
+
+  TiledHistory(const TiledHistory&) = delete;
+  TiledHistory& operator=(const TiledHistory&) = delete;
+
+  // `column` must have length height().
+  void AppendColumn(std::span<const std::uint16_t> column);
+
+  // Copies column `index` into `out`, which must have length height(). Column
+  // 0 is the oldest column.
+  void ReadColumn(std::int64_t index, std::span<std::uint16_t> out);
+
+  // Hints that the columns following `index` in `direction` (+1 towards newer
+  // columns, -1 towards older columns) will be read soon.
+  void Prefetch(std::int64_t index, int direction);
+
+  // Total number of columns appended so far.
+  std::int64_t columns() const noexcept { return columns_; }
+  std::size_t height() const noexcept { return height_; }
+
+ private:
+  class MappedTile;
+
+  // Returns the completed tile with the given index, mapping it if it isn't
+  // already cached.
+  std::shared_ptr<const MappedTile> GetTile(std::int64_t tile)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  bool PrefetchReady() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void PrefetchLoop() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  const std::size_t height_;
+  const std::size_t tile_columns_;
+  const std::size_t cache_tiles_;
+  const std::size_t prefetch_tiles_;
+  // Bytes per packed column.
+  const std::size_t column_bytes_;
+  // Bytes between the start of consecutive tiles in the backing file. Rounded
+  // up to a multiple of the page size so tiles can be mapped individually.
+  const std::size_t tile_stride_;
+  int fd_ = -1;
+
+  std::atomic<std::int64_t> columns_ = 0;
+  // Packed contents of the newest, incomplete tile, one column after another.
+  std::vector<std::uint8_t> current_tile_;
+
+  absl::Mutex mutex_;
+  std::int64_t completed_tiles_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Most recently used tiles at the front.
+  std::list<std::pair<std::int64_t, std::shared_ptr<const MappedTile>>> cache_
+      ABSL_GUARDED_BY(mutex_);
+  std::deque<std::int64_t> prefetch_queue_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::jthread prefetch_thread_;
+};
@@ -0,0 +1,84 @@
+#include "tiled_history.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+
+#include "packed_levels.h"
+
+using testing::ElementsAreArray;
+
+constexpr std::size_t kHeight = 5;
+
+std::vector<std::uint16_t> Column(std::int64_t index) {
+  std::vector<std::uint16_t> column(kHeight);
+  for (std::size_t r = 0; r < kHeight; ++r) {
+    column[r] = static_cast<std::uint16_t>(index * kHeight + r);
+  }
+  return column;
+}
+
+std::vector<std::uint16_t> ReadColumn(TiledHistory& history,
+                                      std::int64_t index) {
+  std::vector<std::uint16_t> column(kHeight);
+  history.ReadColumn(index, column);
+  return column;
+}
+
+TEST(TiledHistoryTest, ReadsBackColumns) {
+  // Small tiles and cache, so that most reads come from evicted tiles.
+  TiledHistory history(kHeight, {.tile_columns = 4, .cache_tiles = 2});
+  for (int i = 0; i < 103; ++i) {
+    history.AppendColumn(Column(i));
+  }
+  EXPECT_EQ(history.columns(), 103);
+  // Both in-memory and spilled columns, in an order that cycles the cache.
+  for (int i : {102, 100, 99, 0, 1, 50, 3, 4, 101}) {
+    EXPECT_THAT(ReadColumn(history, i), ElementsAreArray(Column(i))) << i;
+  }
+}
+
+TEST(TiledHistoryTest, Prefetch) {
+  TiledHistory history(kHeight, {.tile_columns = 4, .prefetch_tiles = 3});
+  for (int i = 0; i < 64; ++i) {
+    history.AppendColumn(Column(i));
+  }
+  history.Prefetch(40, -1);
+  history.Prefetch(8, 1);
+  for (int i = 40; i >= 0; --i) {
+    EXPECT_THAT(ReadColumn(history, i), ElementsAreArray(Column(i))) << i;
+  }
+}
+
+TEST(TiledHistoryTest, FullRangeValues) {
+  TiledHistory history(kHeight, {.tile_columns = 2});
+  const std::vector<std::uint16_t> column = {0, 1, 2048, 4094, 4095};
+  for (int i = 0; i < 3; ++i) {
+    history.AppendColumn(column);
+  }
+  EXPECT_THAT(ReadColumn(history, 0), ElementsAreArray(column));
+  EXPECT_THAT(ReadColumn(history, 2), ElementsAreArray(column));
+}
+
+TEST(TiledHistoryTest, OutOfRange) {
+  TiledHistory history(kHeight, {.tile_columns = 4});
+  history.AppendColumn(Column(0));
+  EXPECT_THROW(ReadColumn(history, -1), std::out_of_range);
+  EXPECT_THROW(ReadColumn(history, 1), std::out_of_range);
+}
+
+TEST(TiledHistoryTest, NamedBackingFile) {
+  const std::string path = testing::TempDir() + "/tiled_history_test.bin";
+  {
+    TiledHistory history(kHeight, {.path = path, .tile_columns = 4});
+    for (int i = 0; i < 9; ++i) {
+      history.AppendColumn(Column(i));
+    }
+    EXPECT_THAT(ReadColumn(history, 2), ElementsAreArray(Column(2)));
+    // Two completed tiles have been spilled to the file.
+    EXPECT_GE(std::filesystem::file_size(path), 4 * PackedLevelsSize(kHeight));
+  }
+  std::filesystem::remove(path);
+}